@@ -1,7 +1,7 @@
-#include <utility>
-#include <functional>
 #include <algorithm>
+#include <functional>
 #include <iterator>
+#include <utility>
 
 
 namespace viper {
@@ -81,24 +81,6 @@ inline auto enumerate(Indexable&& container) noexcept {
 
 
 
-template<class Container>
-constexpr bool in(const Container& c, typename Container::const_reference value) {
-    return std::find(c.cbegin(), c.cend(), value) != c.cend();
-}
-
-template<class Container>
-constexpr bool in(const Container& c, typename Container::value_type&& value) {
-    return std::find(c.cbegin(), c.cend(), value) != c.cend();
-}
-
-template<class Container>
-constexpr bool in(Container&& c, typename Container::value_type&& value) {
-    return std::find(c.cbegin(), c.cend(), value) != c.cend();
-}
-
-
-
-
 template<class Iterator>
 
 class FilterIterator : public Iterator {
@@ -237,6 +219,63 @@ class FilterIterator<T*> {
 
 
 
+template<class ContainerOut, class ContainerIn>
+ContainerOut filter(const typename FilterIterator<typename ContainerIn::const_iterator>::predicate_t& fn, const ContainerIn& in) {
+    using filter_type_t = FilterIterator<typename ContainerIn::const_iterator>;
+    ContainerOut out{
+        filter_type_t(
+                in.cbegin(),
+                in.cend(),
+                fn
+                ),
+        filter_type_t(
+                in.cend(),
+                in.cend(),
+                fn
+                ),
+    };
+    return out;
+}
+
+
+template<class ContainerIn>
+ContainerIn filter(const typename FilterIterator<typename ContainerIn::const_iterator>::predicate_t& fn, const ContainerIn& in) {
+    using filter_type_t = FilterIterator<typename ContainerIn::const_iterator>;
+    ContainerIn out{
+        filter_type_t(
+                in.cbegin(),
+                in.cend(),
+                fn
+                ),
+        filter_type_t(
+                in.cend(),
+                in.cend(),
+                fn
+                ),
+    };
+    return out;
+}
+
+
+
+template<class Container>
+constexpr bool in(const Container& c, typename Container::const_reference value) {
+    return std::find(c.cbegin(), c.cend(), value) != c.cend();
+}
+
+template<class Container>
+constexpr bool in(const Container& c, typename Container::value_type&& value) {
+    return std::find(c.cbegin(), c.cend(), value) != c.cend();
+}
+
+template<class Container>
+constexpr bool in(Container&& c, typename Container::value_type&& value) {
+    return std::find(c.cbegin(), c.cend(), value) != c.cend();
+}
+
+
+
+
 template<class Iterator, class UnaryFunction>
 
 class Iter : public Iterator {
@@ -367,44 +406,5 @@ T into(const UnaryFunction& fn, Container&& c) {
 
 
 
-template<class ContainerOut, class ContainerIn>
-ContainerOut filter(const typename FilterIterator<typename ContainerIn::const_iterator>::predicate_t& fn, const ContainerIn& in) {
-    using filter_type_t = FilterIterator<typename ContainerIn::const_iterator>;
-    ContainerOut out{
-        filter_type_t(
-                in.cbegin(),
-                in.cend(),
-                fn
-                ),
-        filter_type_t(
-                in.cend(),
-                in.cend(),
-                fn
-                ),
-    };
-    return out;
-}
-
-
-template<class ContainerIn>
-ContainerIn filter(const typename FilterIterator<typename ContainerIn::const_iterator>::predicate_t& fn, const ContainerIn& in) {
-    using filter_type_t = FilterIterator<typename ContainerIn::const_iterator>;
-    ContainerIn out{
-        filter_type_t(
-                in.cbegin(),
-                in.cend(),
-                fn
-                ),
-        filter_type_t(
-                in.cend(),
-                in.cend(),
-                fn
-                ),
-    };
-    return out;
-}
-
-
-
 } // closing namespace viper
 
@@ -1,11 +1,18 @@
+#ifndef __VIPER_ENUMERATE__
+#define __VIPER_ENUMERATE__
+
+#include <cstddef>
 #include <iterator>
 #include <functional>
+#include <type_traits>
 #include <utility>
 
+#include "traits.h"
+
 
 /*
  * This header provides an 'enumerate' function that behave similarly to Python's 'enumerate'.
- * For a given indexable container, it returns an iterator.
+ * For a given container, or any range down to a single pass input range, it returns an iterator.
  * That iterator can be dereferenced into a pair of (index, value).
  *
  * For example:
@@ -23,51 +30,237 @@
 template<class Indexable>
 class Enumerate {
 
-    const Indexable & data;
+    using size_type = size_type_t<std::remove_reference_t<Indexable>>;
+
+    // a reference to an l-value container, the container itself when it was an r-value (moved in, see enumerate)
+    Indexable data;
+    size_type start, step;
 
     public:
-    Enumerate(const Indexable& container) noexcept :data(container) {}
+    Enumerate(Indexable&& container, size_type start = 0, size_type step = 1)
+        :data(std::forward<Indexable>(container)), start(start), step(step) {}
 
+    /*
+     * Has the category of the iterator it wraps: over a random access container it is random access too,
+     * so it can be offset, subtracted, compared and split in chunks in constant time,
+     * the index moving along with the underlying iterator.
+     * The index is carried by the iterator, 'step' apart from one element to the next.
+     */
     template<typename IterType>
     class Iterator {
 
         using type = std::remove_reference_t<Indexable>;
-        using iterator_type = typename type::iterator;
-        using reference = typename type::reference;
-        using size_type = typename type::size_type;
-        using value_type = typename type::value_type;
+        using size_type = size_type_t<type>;
 
         IterType iter;
         size_type index;
+        size_type step;
 
         public:
-            Iterator(const size_type& index, const IterType& iter): index(index), iter(iter) {}
 
-            inline auto operator*() const {
-                return std::make_pair(index, std::ref(*iter));
+            // (index, value) pairs are built on the fly, the value is a reference when the underlying iterator yields one
+            using reference = std::pair<size_type, decltype(*std::declval<const IterType&>())>;
+            using value_type = reference;
+            using pointer = void;
+            using difference_type = typename std::iterator_traits<IterType>::difference_type;
+            using iterator_category = typename std::iterator_traits<IterType>::iterator_category;
+
+            Iterator(const size_type& index, const IterType& iter, const size_type& step = 1): iter(iter), index(index), step(step) {}
+
+            inline const IterType& base() const noexcept { return iter; }
+
+            inline reference operator*() const {
+                return reference(index, *iter);
             }
 
-            inline auto operator++() {
-                ++index;
+            inline reference operator[](difference_type n) const {
+                return reference(index + n*step, iter[n]);
+            }
+
+            inline Iterator& operator++() {
+                index += step;
                 ++iter;
                 return *this;
             }
 
-            inline auto operator!=(const Iterator<IterType>& rhs) const {
+            inline auto operator++(int) {
+                auto iterator{*this};
+                operator++();
+                return iterator;
+            }
+
+            inline Iterator& operator--() {
+                index -= step;
+                --iter;
+                return *this;
+            }
+
+            inline auto operator--(int) {
+                auto iterator{*this};
+                operator--();
+                return iterator;
+            }
+
+            inline Iterator& operator+=(difference_type n) {
+                index += n*step;
+                iter += n;
+                return *this;
+            }
+
+            inline Iterator& operator-=(difference_type n) {
+                index -= n*step;
+                iter -= n;
+                return *this;
+            }
+
+            inline Iterator operator+(difference_type n) const {
+                auto iterator{*this};
+                return iterator += n;
+            }
+
+            friend inline Iterator operator+(difference_type n, const Iterator& rhs) {
+                return rhs + n;
+            }
+
+            inline Iterator operator-(difference_type n) const {
+                auto iterator{*this};
+                return iterator -= n;
+            }
+
+            inline difference_type operator-(const Iterator<IterType>& rhs) const {
+                return iter - rhs.iter;
+            }
+
+            inline bool operator==(const Iterator<IterType>& rhs) const {
+                return iter == rhs.iter;
+            }
+
+            inline bool operator!=(const Iterator<IterType>& rhs) const {
                 return iter != rhs.iter;
             }
 
+            inline bool operator<(const Iterator<IterType>& rhs) const {
+                return iter < rhs.iter;
+            }
+
+            inline bool operator>(const Iterator<IterType>& rhs) const {
+                return iter > rhs.iter;
+            }
+
+            inline bool operator<=(const Iterator<IterType>& rhs) const {
+                return iter <= rhs.iter;
+            }
+
+            inline bool operator>=(const Iterator<IterType>& rhs) const {
+                return iter >= rhs.iter;
+            }
+
     };
 
-    inline auto begin() { return Iterator<decltype(data.begin())>(0, data.begin()); }
+    /*
+     * End of an enumeration whose size isn't known in constant time (std::list, std::map...):
+     * it only holds the underlying end, an iterator reaches it when its underlying iterator does,
+     * so the container is walked once, without counting its elements first.
+     */
+    template<typename IterType>
+    class Sentinel {
 
-    inline auto end() { return Iterator<decltype(data.end())>(std::distance(data.begin(), data.end()), data.end()); }
+        IterType iter;
+
+        public:
+
+            explicit Sentinel(const IterType& iter): iter(iter) {}
+
+            inline const IterType& base() const noexcept { return iter; }
+
+            friend inline bool operator==(const Iterator<IterType>& lhs, const Sentinel& rhs) {
+                return lhs.base() == rhs.iter;
+            }
+
+            friend inline bool operator!=(const Iterator<IterType>& lhs, const Sentinel& rhs) {
+                return lhs.base() != rhs.iter;
+            }
+
+            friend inline bool operator==(const Sentinel& lhs, const Iterator<IterType>& rhs) {
+                return lhs.iter == rhs.base();
+            }
+
+            friend inline bool operator!=(const Sentinel& lhs, const Iterator<IterType>& rhs) {
+                return lhs.iter != rhs.base();
+            }
+    };
+
+    inline auto begin() { return Iterator<decltype(data.begin())>(start, data.begin(), step); }
+
+    // an Iterator over random access containers, whose last index is known for free, a Sentinel otherwise
+    inline auto end() {
+        using iterator_t = decltype(data.end());
+        if constexpr( std::is_base_of_v<std::random_access_iterator_tag, typename std::iterator_traits<iterator_t>::iterator_category> ) {
+            return Iterator<iterator_t>(start + (data.end() - data.begin())*step, data.end(), step);
+        } else {
+            return Sentinel<iterator_t>(data.end());
+        }
+    }
+
+    inline std::size_t size() const { return input_size(data); }
 
 };
 
 
+/*
+ * An l-value container is referenced, an r-value one is moved into the Enumerate,
+ * so enumerating a temporary neither copies it nor leaves a dangling reference:
+ *
+ * for( auto&& [index, row] : enumerate(make_rows()) ) { ... }
+ */
+template<class Indexable>
+inline auto enumerate(Indexable&& container) noexcept(std::is_lvalue_reference_v<Indexable> || std::is_nothrow_move_constructible_v<Indexable>) {
+    return Enumerate<Indexable>(std::forward<Indexable>(container));
+}
+
+
+/*
+ * Same, counting from 'start' rather than 0, like Python's enumerate(container, start),
+ * and optionally by 'step': a worker on a shard of the rows gets their global ids for free.
+ *
+ * For example:
+ * for( auto&& [id, row] : enumerate(shard, shard_base) ) { ... }         // shard_base, shard_base+1...
+ * for( auto&& [offset, row] : enumerate(rows, 0, row_size) ) { ... }     // 0, row_size, 2*row_size...
+ */
 template<class Indexable>
-inline auto enumerate(Indexable&& container) noexcept {
-    return Enumerate<decltype(container)>(std::forward<Indexable>(container));
+inline auto enumerate(Indexable&& container, std::size_t start, std::size_t step = 1) {
+    return Enumerate<Indexable>(std::forward<Indexable>(container), start, step);
+}
+
+
+/*
+ * The [first, last) range of a pair of iterators, held by value,
+ * so single pass sources which aren't containers can be enumerated as they are read.
+ *
+ * For example:
+ * std::ifstream log("huge.log");
+ * for( auto&& [number, word] : enumerate(std::istream_iterator<std::string>(log), std::istream_iterator<std::string>()) ) { ... }
+ */
+template<class Iterator>
+class IteratorPair {
+
+    Iterator first, last;
+
+    public:
+
+        using size_type = std::size_t;
+
+        IteratorPair(Iterator first, Iterator last) : first(std::move(first)), last(std::move(last)) {}
+
+        inline Iterator begin() const { return first; }
+
+        inline Iterator end() const { return last; }
+};
+
+
+template<class Iterator, class = typename std::iterator_traits<Iterator>::iterator_category>
+inline auto enumerate(Iterator first, Iterator last) {
+    return Enumerate<IteratorPair<Iterator>>(IteratorPair<Iterator>(std::move(first), std::move(last)));
 }
 
+#endif
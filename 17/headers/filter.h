@@ -1,10 +1,75 @@
+#ifndef __VIPER_FILTER__
+#define __VIPER_FILTER__
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
 #include "filter_iterator.h"
+#include "parallel.h"
+#include "predicates.h"
+#include "traits.h"
+
+
+/*
+ * How filter() sizes the container it returns.
+ *
+ * two_pass: counts the matches first, then allocates once and copies them.
+ *           The predicate runs twice per element, best for cheap predicates.
+ * one_pass: reserves room for the whole input and copies the matches in a single pass,
+ *           then gives the room back if more than half of it went unused: one or two allocations.
+ *
+ * Without a tag, filter() counts first for stateless predicates over arithmetic values, and goes one pass otherwise,
+ * unless it can compact the values with SIMD, see filter_compact().
+ * Containers without reserve() (std::set, std::list...) are always built straight from a pair of FilterIterators.
+ */
+struct two_pass_t {};
+
+inline constexpr two_pass_t two_pass{};
+
+struct one_pass_t {};
+
+inline constexpr one_pass_t one_pass{};
+
+
+template<class Container, class = void>
+struct has_reserve : std::false_type {};
+
+template<class Container>
+struct has_reserve<Container, std::void_t<decltype(std::declval<Container&>().reserve(std::size_t()))>> : std::true_type {};
 
 
-template<class ContainerOut, class ContainerIn>
-ContainerOut filter(const typename FilterIterator<typename ContainerIn::const_iterator>::predicate_t& fn, const ContainerIn& in) {
-    using filter_type_t = FilterIterator<typename ContainerIn::const_iterator>;
-    ContainerOut out{
+template<class Container, class = void>
+struct has_shrink_to_fit : std::false_type {};
+
+template<class Container>
+struct has_shrink_to_fit<Container, std::void_t<decltype(std::declval<Container&>().shrink_to_fit())>> : std::true_type {};
+
+
+// a comparison over a contiguous array of values of its own type can go through simd::compact
+template<class Container, class Predicate, class = void>
+struct is_simd_compactable : std::false_type {};
+
+template<class Container, class Predicate>
+struct is_simd_compactable<Container, Predicate, std::void_t<
+    decltype(std::data(std::declval<Container&>())),
+    typename Predicate::value_type
+    >> : std::bool_constant<
+        is_comparison<Predicate>::value
+        && simd::is_vectorizable_v<typename Container::value_type>
+        && std::is_same_v<typename Container::value_type, typename Predicate::value_type>
+        && std::is_same_v<decltype(std::data(std::declval<Container&>())), typename Container::value_type*>
+      > {};
+
+
+template<class ContainerOut, class Predicate, class ContainerIn>
+ContainerOut filter_range(Predicate& fn, const ContainerIn& in) {
+    using filter_type_t = FilterIterator<typename ContainerIn::const_iterator, std::decay_t<Predicate>>;
+    return ContainerOut(
         filter_type_t(
                 in.cbegin(),
                 in.cend(),
@@ -14,28 +79,280 @@ ContainerOut filter(const typename FilterIterator<typename ContainerIn::const_it
                 in.cend(),
                 in.cend(),
                 fn
-                ),
-    };
-    return out;
+                )
+    );
 }
 
 
-template<class ContainerIn>
-ContainerIn filter(const typename FilterIterator<typename ContainerIn::const_iterator>::predicate_t& fn, const ContainerIn& in) {
-    using filter_type_t = FilterIterator<typename ContainerIn::const_iterator>;
-    ContainerIn out{
-        filter_type_t(
-                in.cbegin(),
-                in.cend(),
-                fn
-                ),
-        filter_type_t(
-                in.cend(),
-                in.cend(),
-                fn
-                ),
-    };
+template<class ContainerOut, class Predicate, class ContainerIn>
+ContainerOut filter(two_pass_t, Predicate&& fn, const ContainerIn& in) {
+    if constexpr( has_reserve<ContainerOut>::value ) {
+        const auto count = static_cast<std::size_t>(std::count_if(in.cbegin(), in.cend(), std::ref(fn)));
+        ContainerOut out;
+        using value_t = typename ContainerOut::value_type;
+        if constexpr( std::is_trivially_copyable_v<value_t> && std::is_default_constructible_v<value_t> && has_resize<ContainerOut>::value ) {
+            // zero filling is cheaper than checking the capacity on every push_back
+            out.resize(count);
+            std::copy_if(in.cbegin(), in.cend(), out.begin(), std::ref(fn));
+        } else {
+            out.reserve(count);
+            std::copy_if(in.cbegin(), in.cend(), std::back_inserter(out), std::ref(fn));
+        }
+        return out;
+    } else {
+        return filter_range<ContainerOut>(fn, in);
+    }
+}
+
+
+template<class ContainerOut, class Predicate, class ContainerIn>
+ContainerOut filter(one_pass_t, Predicate&& fn, const ContainerIn& in) {
+    if constexpr( has_reserve<ContainerOut>::value ) {
+        ContainerOut out;
+        out.reserve(input_size(in));
+        std::copy_if(in.cbegin(), in.cend(), std::back_inserter(out), std::ref(fn));
+        if( out.capacity() / 2 > out.size() ) out.shrink_to_fit();
+        return out;
+    } else {
+        return filter_range<ContainerOut>(fn, in);
+    }
+}
+
+
+template<class Predicate, class ContainerIn>
+ContainerIn filter(two_pass_t tag, Predicate&& fn, const ContainerIn& in) {
+    return filter<ContainerIn>(tag, std::forward<Predicate>(fn), in);
+}
+
+
+template<class Predicate, class ContainerIn>
+ContainerIn filter(one_pass_t tag, Predicate&& fn, const ContainerIn& in) {
+    return filter<ContainerIn>(tag, std::forward<Predicate>(fn), in);
+}
+
+
+/*
+ * Filters an array of arithmetic values with a comparison (gt(0.5f), between(1, 9)...) without calling
+ * a predicate per element: the output is sized to the input and simd::compact writes the kept values
+ * straight into it, a whole register at a time, then the unused tail is dropped (and given back if
+ * more than half of it went unused, as for one_pass).
+ */
+template<class ContainerOut, class Comparison, class ContainerIn>
+ContainerOut filter_compact(const Comparison& fn, const ContainerIn& in) {
+    const auto size = std::size(in);
+    ContainerOut out;
+    out.resize(size);
+    const auto first = std::data(in);
+    const auto last = simd::compact<Comparison::comparison>(first, first + size, std::data(out), fn.a, fn.b);
+    out.resize(static_cast<std::size_t>(last - std::data(out)));
+    if constexpr( has_shrink_to_fit<ContainerOut>::value ) {
+        if( out.capacity() / 2 > out.size() ) out.shrink_to_fit();
+    }
     return out;
 }
 
 
+/*
+ * Returns a new container holding the elements of 'in' for which 'fn' returns true.
+ *
+ * The type of 'fn' is kept all the way down to the copy loop, so a lambda is inlined.
+ *
+ * For example:
+ * auto odd = [](int i) { return i % 2 == 1; };
+ * auto odd_numbers = filter(odd, vi);                   // same container type as vi
+ * auto odd_set = filter<std::set<int>>(odd, vi);        // any container constructible from an iterator pair
+ * auto odd_numbers = filter(one_pass, odd, vi);         // pick how the output is sized, see two_pass_t
+ */
+template<class ContainerOut, class Predicate, class ContainerIn>
+ContainerOut filter(Predicate&& fn, const ContainerIn& in) {
+    using value_t = typename ContainerIn::value_type;
+    using predicate_t = std::decay_t<Predicate>;
+    if constexpr( is_simd_compactable<ContainerIn, predicate_t>::value
+                  && is_simd_compactable<ContainerOut, predicate_t>::value
+                  && has_resize<ContainerOut>::value ) {
+        return filter_compact<ContainerOut>(fn, in);
+    } else if constexpr( std::is_empty_v<predicate_t> && std::is_arithmetic_v<value_t> ) {
+        return filter<ContainerOut>(two_pass, std::forward<Predicate>(fn), in);
+    } else {
+        return filter<ContainerOut>(one_pass, std::forward<Predicate>(fn), in);
+    }
+}
+
+
+template<class Predicate, class ContainerIn>
+ContainerIn filter(Predicate&& fn, const ContainerIn& in) {
+    return filter<ContainerIn>(std::forward<Predicate>(fn), in);
+}
+
+
+template<class Container, class Predicate, class = void>
+struct has_member_remove_if : std::false_type {};
+
+template<class Container, class Predicate>
+struct has_member_remove_if<Container, Predicate, std::void_t<
+    decltype(std::declval<Container&>().remove_if(std::declval<Predicate>()))
+    >> : std::true_type {};
+
+
+template<class Container, class = void>
+struct is_associative : std::false_type {};
+
+template<class Container>
+struct is_associative<Container, std::void_t<typename Container::key_type>> : std::true_type {};
+
+
+/*
+ * Erases the elements of 'c' for which 'fn' returns false, keeping the order of the others,
+ * without allocating: std::list & co. relink their nodes, associative containers erase in place,
+ * sequence containers shift the kept elements down (moving them) and drop the tail,
+ * with a SIMD stream compaction for comparisons over arithmetic values (see predicates.h).
+ */
+template<class Container, class Predicate>
+void compact(Container& c, Predicate& fn) {
+    using predicate_t = std::decay_t<Predicate>;
+    auto reject = [&fn](auto& value) { return !fn(value); };
+    if constexpr( is_simd_compactable<Container, predicate_t>::value ) {
+        auto first = std::data(c);
+        auto last = simd::compact<predicate_t::comparison>(first, first + std::size(c), first, fn.a, fn.b);
+        c.erase(c.begin() + (last - first), c.end());
+    } else if constexpr( has_member_remove_if<Container, decltype(reject)>::value ) {
+        c.remove_if(reject);
+    } else if constexpr( is_associative<Container>::value ) {
+        for( auto it = c.begin(); it != c.end(); ) {
+            if( reject(*it) ) it = c.erase(it); else ++it;
+        }
+    } else {
+        c.erase(std::remove_if(c.begin(), c.end(), reject), c.end());
+    }
+}
+
+
+/*
+ * In place filter: erases the elements of 'c' for which 'fn' returns false, keeping the order of the others,
+ * and returns the new size of 'c'. Nothing is allocated, unless the 'shrink' tag asks to give back the unused capacity.
+ *
+ * For example:
+ * filter_inplace(even, vi);           // instead of vi = filter(even, vi);
+ * filter_inplace(shrink, even, vi);   // same, then vi.shrink_to_fit()
+ * filter_inplace(gt(0), vi);          // SIMD stream compaction
+ */
+struct shrink_t {};
+
+inline constexpr shrink_t shrink{};
+
+
+template<class Predicate, class Container>
+std::size_t filter_inplace(Predicate&& fn, Container& c) {
+    compact(c, fn);
+    return input_size(c);
+}
+
+
+template<class Predicate, class Container>
+std::size_t filter_inplace(shrink_t, Predicate&& fn, Container& c) {
+    compact(c, fn);
+    if constexpr( has_shrink_to_fit<Container>::value ) c.shrink_to_fit();
+    return input_size(c);
+}
+
+
+/*
+ * Filtering a temporary moves the elements instead of copying them.
+ * When the output is the same type as the input, it is the input compacted in place:
+ * no allocation at all, and the same buffer is returned.
+ *
+ * For example:
+ * auto long_names = filter(is_long, load_names());   // load_names()'s buffer, with the short names erased
+ */
+template<class ContainerOut, class Predicate, class ContainerIn, std::enable_if_t<!std::is_lvalue_reference_v<ContainerIn> && !std::is_const_v<ContainerIn>, int> = 0>
+ContainerOut filter(Predicate&& fn, ContainerIn&& in) {
+    if constexpr( std::is_same_v<ContainerOut, ContainerIn> ) {
+        compact(in, fn);
+        return std::move(in);
+    } else {
+        ContainerOut out;
+        if constexpr( has_reserve<ContainerOut>::value ) out.reserve(input_size(in));
+        for( auto& value : in ) {
+            if( fn(value) ) out.insert(out.end(), std::move(value));
+        }
+        if constexpr( has_reserve<ContainerOut>::value ) {
+            if( out.capacity() / 2 > out.size() ) out.shrink_to_fit();
+        }
+        return out;
+    }
+}
+
+
+template<class Predicate, class ContainerIn, std::enable_if_t<!std::is_lvalue_reference_v<ContainerIn> && !std::is_const_v<ContainerIn>, int> = 0>
+ContainerIn filter(Predicate&& fn, ContainerIn&& in) {
+    return filter<ContainerIn>(std::forward<Predicate>(fn), std::move(in));
+}
+
+
+/*
+ * Parallel filter over a random access container.
+ *
+ * Each chunk of the input evaluates the predicate once per element and remembers the outcome,
+ * the chunk counts give every chunk its offset in the output, which is allocated once and filled in parallel.
+ * The output keeps the order of the input.
+ *
+ * For example:
+ * auto evens = filter(par, even, records);
+ */
+template<class ContainerOut, class Predicate, class ContainerIn>
+ContainerOut filter(const parallel_policy& policy, Predicate&& fn, const ContainerIn& in) {
+    using category = typename std::iterator_traits<typename ContainerIn::const_iterator>::iterator_category;
+    static_assert(std::is_base_of_v<std::random_access_iterator_tag, category>, "parallel filter needs a random access container");
+
+    const std::size_t size = std::size(in);
+    const std::size_t chunks = chunk_count(policy, size);
+    if( chunks == 1 ) return filter<ContainerOut>(std::forward<Predicate>(fn), in);
+
+    const auto first = in.cbegin();
+    std::vector<unsigned char> keep(size);
+    std::vector<std::size_t> offsets(chunks + 1, 0);
+
+    parallel_chunks(chunks, size, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+        std::size_t count = 0;
+        for( std::size_t i = begin; i < end; ++i ) {
+            keep[i] = fn(first[i]) ? 1 : 0;
+            count += keep[i];
+        }
+        offsets[chunk+1] = count;
+    });
+
+    for( std::size_t chunk = 0; chunk < chunks; ++chunk ) offsets[chunk+1] += offsets[chunk];
+
+    using out_value_t = typename ContainerOut::value_type;
+    using out_category = typename std::iterator_traits<typename ContainerOut::iterator>::iterator_category;
+    if constexpr( std::is_base_of_v<std::random_access_iterator_tag, out_category> && std::is_default_constructible_v<out_value_t>
+               && has_resize<ContainerOut>::value && !is_bit_packed<ContainerOut>::value ) {
+        ContainerOut out;
+        out.resize(offsets[chunks]);
+        auto out_first = out.begin();
+        parallel_chunks(chunks, size, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+            auto out_it = out_first + offsets[chunk];
+            for( std::size_t i = begin; i < end; ++i ) {
+                if( keep[i] ) *out_it++ = first[i];
+            }
+        });
+        return out;
+    } else {
+        // std::set & co., std::vector<bool> and containers that can't be sized upfront can't be written to in parallel,
+        // at least the predicate ran in parallel
+        ContainerOut out;
+        auto inserter = std::inserter(out, out.end());
+        for( std::size_t i = 0; i < size; ++i ) {
+            if( keep[i] ) *inserter++ = first[i];
+        }
+        return out;
+    }
+}
+
+
+template<class Predicate, class ContainerIn>
+ContainerIn filter(const parallel_policy& policy, Predicate&& fn, const ContainerIn& in) {
+    return filter<ContainerIn>(policy, std::forward<Predicate>(fn), in);
+}
+
+#endif
@@ -1,131 +1,96 @@
+#ifndef __VIPER_FILTER_ITERATOR__
+#define __VIPER_FILTER_ITERATOR__
+
 #include <functional>
 #include <iterator>
+#include <type_traits>
+#include <utility>
 
+#include "function_box.h"
 
-template<class Iterator>
-
-class FilterIterator : public Iterator {
-    public:
 
-    using predicate_t = std::function< bool (typename Iterator::reference) >;
-
-    private:
-    
-    predicate_t _filter;
-    Iterator _end;
-
-    inline void move_to_next_valid_value() {
-        while( (*this!=_end) && !_filter(**this)) Iterator::operator++();
-    }
+/*
+ * Iterates over [begin, end) skipping the elements for which the predicate returns false.
+ *
+ * The predicate type is a template parameter, so a lambda is called directly and can be inlined.
+ * It defaults to a std::function for when the type of the callable can't be named,
+ * at the cost of an indirect call per element.
+ *
+ * For example:
+ * auto even = [](int i) { return i % 2 == 0; };
+ * FilterIterator it(vi.begin(), vi.end(), even); // FilterIterator<std::vector<int>::iterator, decltype(even)>
+ */
+template<class Iterator, class Predicate = std::function< bool (typename std::iterator_traits<Iterator>::reference) >>
+class FilterIterator : private FunctionBox<Predicate> {
 
+    using box_t = FunctionBox<Predicate>;
+    using traits_t = std::iterator_traits<Iterator>;
 
     public:
 
-    FilterIterator(const FilterIterator& iter):FilterIterator(iter, iter._end, iter._filter) {}
-
-    FilterIterator(const Iterator& begin, const Iterator& end, const predicate_t& filter)
-        : Iterator(begin),_filter(filter),_end(end) {
-            move_to_next_valid_value();
-        }
+        using predicate_t = Predicate;
+        using iterator_type = Iterator;
+        using difference_type = typename traits_t::difference_type;
+        using value_type = typename traits_t::value_type;
+        using pointer = typename traits_t::pointer;
+        using reference = typename traits_t::reference;
+        // skipping elements means we can't jump ahead, at best we move forward
+        using iterator_category = std::conditional_t<
+            std::is_base_of_v<std::forward_iterator_tag, typename traits_t::iterator_category>,
+            std::forward_iterator_tag,
+            typename traits_t::iterator_category
+                >;
 
-    FilterIterator(Iterator&& begin, Iterator&& end, predicate_t&& filter)
-        : Iterator(std::move(begin)), _filter(std::move(filter)), _end(std::move(end)) {
-            move_to_next_valid_value();
-        }
+    private:
 
-    FilterIterator& operator=(const FilterIterator& other) {
-        if( this != &other ) {
-            _filter = other._filter;
-            _end = other._end;
-        }
-        return *this;
-    }
+        Iterator _iter, _end;
 
-    FilterIterator& operator=(FilterIterator&& other) {
-        if( this != &other ) {
-            _filter = std::move(other._filter);
-            _end = std::move(other._end);
+        inline void move_to_next_valid_value() {
+            while( (_iter != _end) && !box_t::function()(*_iter) ) ++_iter;
         }
-        return *this;
-    }
-
-    inline FilterIterator& operator++() {
-        do {
-            Iterator::operator++();
-        } while( (*this!=_end) && !_filter(**this) );
-        return *this;
-    }
-
-    inline auto operator++(int) {
-        auto iterator{*this};
-        operator++();
-        return iterator;
-    }
-};
-
-
-template<class T>
-
-class FilterIterator<T*> {
 
     public:
 
-    using predicate_t = typename std::function< bool (const T&) >;
-
-    private:
+        FilterIterator(Iterator begin, Iterator end, Predicate filter)
+            : box_t(std::move(filter)), _iter(std::move(begin)), _end(std::move(end)) {
+                move_to_next_valid_value();
+            }
 
-    const T *_iter, *_end;
-    const predicate_t& _filter;
+        FilterIterator(const FilterIterator&) = default;
 
-    inline void move_to_next_valid_value() {
-        while( (*this!=_end) && !_filter(**this)) ++_iter;
-    }
+        FilterIterator(FilterIterator&&) = default;
 
-    public:
+        FilterIterator& operator=(const FilterIterator&) = default;
 
-        using difference_type = typename std::iterator_traits<T*>::difference_type;
-        using value_type = typename std::iterator_traits<T*>::value_type;
-        using pointer = typename std::iterator_traits<T*>::pointer;
-        using reference = typename std::iterator_traits<T*>::reference;
-        using iterator_category = typename std::iterator_traits<T*>::iterator_category;
+        FilterIterator& operator=(FilterIterator&&) = default;
 
-        FilterIterator(const T* begin, const T* end, const predicate_t& filter)
-            : _iter(begin), _end(end), _filter(filter) {
-                move_to_next_valid_value();
-            }
+        inline const Iterator& base() const noexcept { return _iter; }
 
-        inline bool operator==(const T* rhs) const {
-            return _iter == rhs;
-        }
+        inline const Predicate& predicate() const noexcept { return box_t::function(); }
 
-        inline bool operator==(const FilterIterator<T*>& rhs) const {
+        inline bool operator==(const FilterIterator& rhs) const {
             return _iter == rhs._iter;
         }
 
-        inline bool operator!=(const T* rhs) const {
-            return _iter != rhs;
-        }
-
-        inline bool operator!=(const FilterIterator<T*>& rhs) const {
+        inline bool operator!=(const FilterIterator& rhs) const {
             return _iter != rhs._iter;
         }
 
-        inline difference_type operator-(const T* rhs) const {
-            return _iter - rhs;
+        inline bool operator==(const Iterator& rhs) const {
+            return _iter == rhs;
         }
 
-        inline difference_type operator-(const FilterIterator<T*>& rhs) const {
-            return _iter - rhs._iter;
+        inline bool operator!=(const Iterator& rhs) const {
+            return _iter != rhs;
         }
 
-        inline const T& operator*() const {
+        inline reference operator*() const {
             return *_iter;
         }
 
         inline FilterIterator& operator++() {
-            do {
-                ++_iter;
-            } while( (*this!=_end) && !_filter(**this) );
+            ++_iter;
+            move_to_next_valid_value();
             return *this;
         }
 
@@ -136,4 +101,4 @@ class FilterIterator<T*> {
         }
 };
 
-
+#endif
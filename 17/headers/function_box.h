@@ -0,0 +1,88 @@
+#ifndef __VIPER_FUNCTION_BOX__
+#define __VIPER_FUNCTION_BOX__
+
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+
+/*
+ * Stores the callable of an iterator adaptor (FilterIterator's predicate, Iter's conversion) by value.
+ *
+ * Stateless callables (captureless lambdas, std::less<>, ...) become an empty base and take no room at all.
+ * Lambdas with captures are not assignable, so they are re-built in place on assignment
+ * to keep the iterator CopyAssignable.
+ */
+template<class Function, bool = std::is_empty_v<Function> && !std::is_final_v<Function>>
+class FunctionBox : private Function {
+
+    public:
+
+        constexpr FunctionBox(const Function& function) : Function(function) {}
+
+        constexpr FunctionBox(Function&& function) : Function(std::move(function)) {}
+
+        FunctionBox(const FunctionBox&) = default;
+
+        FunctionBox(FunctionBox&&) = default;
+
+        // nothing to assign, an empty callable has no state
+        constexpr FunctionBox& operator=(const FunctionBox&) noexcept { return *this; }
+
+        constexpr FunctionBox& operator=(FunctionBox&&) noexcept { return *this; }
+
+        constexpr Function& function() noexcept { return *this; }
+
+        constexpr const Function& function() const noexcept { return *this; }
+};
+
+
+template<class Function>
+class FunctionBox<Function, false> {
+
+    static constexpr bool assignable = std::is_copy_assignable_v<Function> && std::is_move_assignable_v<Function>;
+
+    std::conditional_t<assignable, Function, std::optional<Function>> _function;
+
+    public:
+
+        constexpr FunctionBox(const Function& function) : _function(function) {}
+
+        constexpr FunctionBox(Function&& function) : _function(std::move(function)) {}
+
+        FunctionBox(const FunctionBox&) = default;
+
+        FunctionBox(FunctionBox&&) = default;
+
+        FunctionBox& operator=(const FunctionBox& other) {
+            if( this != &other ) {
+                if constexpr( assignable ) {
+                    _function = other._function;
+                } else {
+                    _function.emplace(*other._function);
+                }
+            }
+            return *this;
+        }
+
+        FunctionBox& operator=(FunctionBox&& other) {
+            if( this != &other ) {
+                if constexpr( assignable ) {
+                    _function = std::move(other._function);
+                } else {
+                    _function.emplace(std::move(*other._function));
+                }
+            }
+            return *this;
+        }
+
+        constexpr Function& function() noexcept {
+            if constexpr( assignable ) return _function; else return *_function;
+        }
+
+        constexpr const Function& function() const noexcept {
+            if constexpr( assignable ) return _function; else return *_function;
+        }
+};
+
+#endif
@@ -2,16 +2,110 @@
 #define __VIPER_GRID__
 
 
+#include <algorithm>
+#include <cstddef>
 #include <iterator>
+#include <type_traits>
+#include <utility>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+
+//
+// LAYOUTS
+//
+// Where the element at row r, column c of a 'rows' x 'cols' grid is in its container: offset(r, c, rows, cols).
+// size(rows, cols) is how many elements the container has to hold.
+// A layout whose rows (columns) are contiguous says so with contiguous_rows (contiguous_cols).
+//
+
+
+// one row after the other, C style
+struct row_major {
+    static constexpr bool contiguous_rows = true;
+    static constexpr bool contiguous_cols = false;
+
+    static constexpr std::size_t offset(std::size_t r, std::size_t c, std::size_t, std::size_t cols) noexcept { return r*cols + c; }
+
+    static constexpr std::size_t size(std::size_t rows, std::size_t cols) noexcept { return rows*cols; }
+};
+
+
+// one column after the other, Fortran and BLAS style
+struct column_major {
+    static constexpr bool contiguous_rows = false;
+    static constexpr bool contiguous_cols = true;
+
+    static constexpr std::size_t offset(std::size_t r, std::size_t c, std::size_t rows, std::size_t) noexcept { return c*rows + r; }
+
+    static constexpr std::size_t size(std::size_t rows, std::size_t cols) noexcept { return rows*cols; }
+};
+
+
+// row-major, each row starting 'leading_dimension' elements after the previous one (at least 'cols')
+template<std::size_t leading_dimension>
+struct padded_row_major {
+    static constexpr bool contiguous_rows = true;
+    static constexpr bool contiguous_cols = false;
+
+    static constexpr std::size_t offset(std::size_t r, std::size_t c, std::size_t, std::size_t) noexcept { return r*leading_dimension + c; }
+
+    static constexpr std::size_t size(std::size_t rows, std::size_t) noexcept { return rows*leading_dimension; }
+};
 
-template<std::size_t column_number, std::size_t rows, std::size_t cols, class SequenceContainer>
+
+// column-major, each column starting 'leading_dimension' elements after the previous one (at least 'rows'), BLAS's lda
+template<std::size_t leading_dimension>
+struct padded_column_major {
+    static constexpr bool contiguous_rows = false;
+    static constexpr bool contiguous_cols = true;
+
+    static constexpr std::size_t offset(std::size_t r, std::size_t c, std::size_t, std::size_t) noexcept { return c*leading_dimension + r; }
+
+    static constexpr std::size_t size(std::size_t, std::size_t cols) noexcept { return cols*leading_dimension; }
+};
+
+
+/*
+ * 'tile_rows' x 'tile_cols' tiles one after the other, left to right then top to bottom,
+ * each tile row-major. Tiles on the bottom and right edges are stored whole, padding included.
+ */
+template<std::size_t tile_rows, std::size_t tile_cols>
+struct tiled {
+    static_assert(tile_rows > 0 && tile_cols > 0, "tiles have at least one element");
+
+    static constexpr bool contiguous_rows = false;
+    static constexpr bool contiguous_cols = false;
+
+    static constexpr std::size_t offset(std::size_t r, std::size_t c, std::size_t, std::size_t cols) noexcept {
+        const std::size_t across = (cols + tile_cols - 1) / tile_cols;
+        return ((r / tile_rows) * across + c / tile_cols) * (tile_rows * tile_cols) + (r % tile_rows) * tile_cols + c % tile_cols;
+    }
+
+    static constexpr std::size_t size(std::size_t rows, std::size_t cols) noexcept {
+        return (rows + tile_rows - 1) / tile_rows * tile_rows * ((cols + tile_cols - 1) / tile_cols * tile_cols);
+    }
+};
+
+
+/*
+ * A column of a 'rows' x 'cols' grid stored in 'SequenceContainer' as 'Layout' says, see LAYOUTS.
+ * Its iterators step from one element of the column to the next by the distance between them in the layout:
+ * 'cols' elements for row-major grids, one for column-major ones.
+ */
+template<std::size_t column_number, std::size_t rows, std::size_t cols, class SequenceContainer, class Layout = row_major>
 class ColumnDimension {
 
     protected:
 
     const SequenceContainer& data;
 
+    static constexpr std::size_t offset(std::size_t pos) noexcept {
+        return Layout::offset(pos, column_number, rows, cols);
+    }
+
     public:
 
     template<typename iterator>
@@ -29,27 +123,30 @@ class ColumnDimension {
         protected:
 
             iterator _iter;
+            std::size_t _pos;
 
         public:
 
-            ColumnIterator(const iterator& iter): _iter(iter) {}
+            ColumnIterator(const iterator& iter, std::size_t pos = 0): _iter(iter), _pos(pos) {}
 
             inline typename std::conditional<std::is_const<iterator>::value, const_reference, reference>::type operator*() const {
                 return *_iter;
             }
 
             inline auto operator!=(const ColumnIterator<iterator>& rhs) const {
-                return _iter != rhs._iter;
+                return _pos != rhs._pos;
             }
 
+            // the last element doesn't step any further, past the end of the container
             inline auto operator++() {
-                std::advance(_iter, cols);
+                if( ++_pos < rows ) std::advance(_iter, static_cast<difference_type>(offset(_pos)) - static_cast<difference_type>(offset(_pos - 1)));
                 return *this;
             }
 
     };
 
     using container_t = std::remove_reference_t<SequenceContainer>;
+    using layout_t = Layout;
     using value_type = typename container_t::value_type;
     using size_type = typename container_t::size_type;
     using difference_type = typename container_t::difference_type;
@@ -72,7 +169,7 @@ class ColumnDimension {
     }
 
     constexpr const_reference operator[]( size_type pos ) const {
-        return data[ column_number + pos*cols ];
+        return data[ offset(pos) ];
     }
 
     //
@@ -80,27 +177,32 @@ class ColumnDimension {
     //
 
     constexpr reference operator[]( size_type pos ) {
-        return data[ column_number + pos*cols ];
+        return data[ offset(pos) ];
     }
 
-    constexpr iterator begin() { return iterator(std::next(data.begin(), column_number)); }
+    constexpr iterator begin() { return iterator(std::next(data.begin(), offset(0))); }
 
-    constexpr iterator end() { return iterator(std::next(data.begin(), column_number + rows*cols)); }
+    constexpr iterator end() { return iterator(std::next(data.begin(), offset(0)), rows); }
 
-    constexpr const_iterator cbegin() const { return const_iterator(std::next(data.cbegin(), column_number)); }
+    constexpr const_iterator cbegin() const { return const_iterator(std::next(data.cbegin(), offset(0))); }
 
-    constexpr const_iterator cend() const { return const_iterator(std::next(data.cbegin(), column_number + rows*cols)); }
+    constexpr const_iterator cend() const { return const_iterator(std::next(data.cbegin(), offset(0)), rows); }
 
 };
 
 
-template<std::size_t row_number, std::size_t rows, std::size_t cols, class SequenceContainer>
+// a row of a 'rows' x 'cols' grid stored in 'SequenceContainer' as 'Layout' says, see ColumnDimension
+template<std::size_t row_number, std::size_t rows, std::size_t cols, class SequenceContainer, class Layout = row_major>
 class RowDimension {
 
     protected:
 
         const SequenceContainer& data;
 
+        static constexpr std::size_t offset(std::size_t pos) noexcept {
+            return Layout::offset(row_number, pos, rows, cols);
+        }
+
     public:
 
         template<typename iterator>
@@ -118,27 +220,29 @@ class RowDimension {
                 protected:
 
                     iterator _iter;
+                    std::size_t _pos;
 
                 public:
 
-                    RowIterator(const iterator& iter): _iter(iter) {}
+                    RowIterator(const iterator& iter, std::size_t pos = 0): _iter(iter), _pos(pos) {}
 
                     inline typename std::conditional<std::is_const<iterator>::value, const_reference, reference>::type operator*() const {
                         return *_iter;
                     }
 
                     inline auto operator!=(const RowIterator<iterator>& rhs) const {
-                        return _iter != rhs._iter;
+                        return _pos != rhs._pos;
                     }
 
                     inline auto operator++() {
-                        _iter++;
+                        if( ++_pos < cols ) std::advance(_iter, static_cast<difference_type>(offset(_pos)) - static_cast<difference_type>(offset(_pos - 1)));
                         return *this;
                     }
 
             };
 
         using container_t = std::remove_reference_t<SequenceContainer>;
+        using layout_t = Layout;
         using value_type = typename container_t::value_type;
         using size_type = typename container_t::size_type;
         using difference_type = typename container_t::difference_type;
@@ -161,47 +265,715 @@ class RowDimension {
         }
 
         constexpr const_reference operator[]( size_type pos ) const {
-            return data[ row_number*cols + pos ];
+            return data[ offset(pos) ];
         }
 
-        constexpr const_iterator cbegin() const { return const_iterator(std::next(data.cbegin(), row_number*cols)); }
+        constexpr const_iterator cbegin() const { return const_iterator(std::next(data.cbegin(), offset(0))); }
 
-        constexpr const_iterator cend() const { return const_iterator(std::next(data.cbegin(), row_number*cols + cols)); }
+        constexpr const_iterator cend() const { return const_iterator(std::next(data.cbegin(), offset(0)), cols); }
 
         //
         // WRITE OPS
         //
 
         constexpr reference operator[]( size_type pos ) {
-            return data[ row_number*cols + pos ];
+            return data[ offset(pos) ];
         }
 
-        constexpr iterator begin() { return iterator(std::next(data.begin(), row_number*cols)); }
+        constexpr iterator begin() { return iterator(std::next(data.begin(), offset(0))); }
 
-        constexpr iterator end() { return iterator(std::next(data.begin(), row_number*cols + cols)); }
+        constexpr iterator end() { return iterator(std::next(data.begin(), offset(0)), cols); }
 };
 
 
-template<std::size_t column_number, std::size_t rows, std::size_t cols, class SequenceContainer>
+/*
+ * The layout comes after the dimensions, row-major unless told otherwise:
+ *
+ * std::array<double, 6> fortran = ...;                    // 2 x 3, column-major
+ * for( auto x : col<1, 2, 3, column_major>(fortran) ) { ... }
+ * auto r = row<0, 2, 3, column_major>(fortran);            // r[2] == fortran[4]
+ */
+template<std::size_t column_number, std::size_t rows, std::size_t cols, class Layout = row_major, class SequenceContainer>
 inline auto col(SequenceContainer&& container) {
     return ColumnDimension<
         column_number,
         rows,
         cols,
-        SequenceContainer
+        SequenceContainer,
+        Layout
             > (std::forward<SequenceContainer>(container));
 }
 
 
-template<std::size_t row_number, std::size_t rows, std::size_t cols, class SequenceContainer>
+template<std::size_t row_number, std::size_t rows, std::size_t cols, class Layout = row_major, class SequenceContainer>
 inline auto row(SequenceContainer&& container) {
     return RowDimension<
         row_number,
         rows,
         cols,
-        SequenceContainer
+        SequenceContainer,
+        Layout
             > (std::forward<SequenceContainer>(container));
 }
 
 
+//
+// RUNTIME DIMENSIONS
+//
+// The views below take their dimensions as arguments, for grids whose size is only known at runtime.
+// Like the compile-time ones, they don't own anything: they alias the container they were made from.
+//
+
+
+/*
+ * Random access iterator over every 'stride'-th element, walking a column of a row-major grid.
+ * It keeps its position as an offset from the first element, so the end of the last column
+ * never points past the end of the container.
+ */
+template<class Iterator>
+class StridedIterator {
+
+    using traits_t = std::iterator_traits<Iterator>;
+
+    public:
+
+        using difference_type = typename traits_t::difference_type;
+        using value_type = typename traits_t::value_type;
+        using pointer = typename traits_t::pointer;
+        using reference = typename traits_t::reference;
+        using iterator_category = std::random_access_iterator_tag;
+
+    private:
+
+        Iterator _first;
+        difference_type _pos;
+        difference_type _stride;
+
+    public:
+
+        StridedIterator(Iterator first, difference_type pos, difference_type stride)
+            : _first(std::move(first)), _pos(pos), _stride(stride) {}
+
+        inline difference_type stride() const noexcept { return _stride; }
+
+        inline reference operator*() const {
+            return _first[_pos * _stride];
+        }
+
+        inline reference operator[](difference_type n) const {
+            return _first[(_pos + n) * _stride];
+        }
+
+        inline bool operator==(const StridedIterator& rhs) const {
+            return _pos == rhs._pos;
+        }
+
+        inline bool operator!=(const StridedIterator& rhs) const {
+            return _pos != rhs._pos;
+        }
+
+        inline bool operator<(const StridedIterator& rhs) const {
+            return _pos < rhs._pos;
+        }
+
+        inline bool operator>(const StridedIterator& rhs) const {
+            return _pos > rhs._pos;
+        }
+
+        inline bool operator<=(const StridedIterator& rhs) const {
+            return _pos <= rhs._pos;
+        }
+
+        inline bool operator>=(const StridedIterator& rhs) const {
+            return _pos >= rhs._pos;
+        }
+
+        inline difference_type operator-(const StridedIterator& rhs) const {
+            return _pos - rhs._pos;
+        }
+
+        inline StridedIterator& operator++() {
+            ++_pos;
+            return *this;
+        }
+
+        inline auto operator++(int) {
+            auto iterator{*this};
+            operator++();
+            return iterator;
+        }
+
+        inline StridedIterator& operator--() {
+            --_pos;
+            return *this;
+        }
+
+        inline auto operator--(int) {
+            auto iterator{*this};
+            operator--();
+            return iterator;
+        }
+
+        inline StridedIterator& operator+=(difference_type n) {
+            _pos += n;
+            return *this;
+        }
+
+        inline StridedIterator& operator-=(difference_type n) {
+            _pos -= n;
+            return *this;
+        }
+
+        inline StridedIterator operator+(difference_type n) const {
+            auto iterator{*this};
+            return iterator += n;
+        }
+
+        inline StridedIterator operator-(difference_type n) const {
+            auto iterator{*this};
+            return iterator -= n;
+        }
+};
+
+
+/*
+ * A row of a grid: 'size' consecutive elements.
+ * Its iterators are the container's own (a plain pointer for contiguous containers, see grid()),
+ * so a loop over a row compiles as a loop over an array.
+ */
+template<class Iterator>
+class RowView {
+
+    using traits_t = std::iterator_traits<Iterator>;
+
+    Iterator _first;
+    std::size_t _size;
+
+    public:
+
+        using value_type = typename traits_t::value_type;
+        using size_type = std::size_t;
+        using difference_type = typename traits_t::difference_type;
+        using reference = typename traits_t::reference;
+        using pointer = typename traits_t::pointer;
+        using iterator = Iterator;
+        using const_iterator = Iterator;
+
+        RowView(Iterator first, size_type size) : _first(std::move(first)), _size(size) {}
+
+        inline size_type size() const noexcept { return _size; }
+
+        inline reference operator[](size_type pos) const {
+            return _first[static_cast<difference_type>(pos)];
+        }
+
+        inline iterator begin() const { return _first; }
+
+        inline iterator end() const { return _first + static_cast<difference_type>(_size); }
+
+        inline const_iterator cbegin() const { return begin(); }
+
+        inline const_iterator cend() const { return end(); }
+};
+
+
+// a column of a grid: 'size' elements, 'stride' apart
+template<class Iterator>
+class ColumnView {
+
+    using traits_t = std::iterator_traits<Iterator>;
+
+    Iterator _first;
+    std::size_t _size;
+    typename traits_t::difference_type _stride;
+
+    public:
+
+        using value_type = typename traits_t::value_type;
+        using size_type = std::size_t;
+        using difference_type = typename traits_t::difference_type;
+        using reference = typename traits_t::reference;
+        using pointer = typename traits_t::pointer;
+        using iterator = StridedIterator<Iterator>;
+        using const_iterator = iterator;
+
+        ColumnView(Iterator first, size_type size, difference_type stride)
+            : _first(std::move(first)), _size(size), _stride(stride) {}
+
+        inline size_type size() const noexcept { return _size; }
+
+        inline difference_type stride() const noexcept { return _stride; }
+
+        inline reference operator[](size_type pos) const {
+            return _first[static_cast<difference_type>(pos) * _stride];
+        }
+
+        inline iterator begin() const { return iterator(_first, 0, _stride); }
+
+        inline iterator end() const { return iterator(_first, static_cast<difference_type>(_size), _stride); }
+
+        inline const_iterator cbegin() const { return begin(); }
+
+        inline const_iterator cend() const { return end(); }
+};
+
+
+/*
+ * Random access iterator over a range of views made on the fly (rows, columns, tiles of a grid):
+ * it keeps a copy of the range, which is just a few words, and a position in it.
+ */
+template<class Range>
+class IndexIterator {
+
+    Range _range;
+    std::ptrdiff_t _pos;
+
+    public:
+
+        using difference_type = std::ptrdiff_t;
+        using value_type = typename Range::value_type;
+        using pointer = void;
+        using reference = value_type;
+        using iterator_category = std::random_access_iterator_tag;
+
+        IndexIterator(Range range, difference_type pos) : _range(std::move(range)), _pos(pos) {}
+
+        inline reference operator*() const {
+            return _range[static_cast<std::size_t>(_pos)];
+        }
+
+        inline reference operator[](difference_type n) const {
+            return _range[static_cast<std::size_t>(_pos + n)];
+        }
+
+        inline bool operator==(const IndexIterator& rhs) const {
+            return _pos == rhs._pos;
+        }
+
+        inline bool operator!=(const IndexIterator& rhs) const {
+            return _pos != rhs._pos;
+        }
+
+        inline bool operator<(const IndexIterator& rhs) const {
+            return _pos < rhs._pos;
+        }
+
+        inline bool operator>(const IndexIterator& rhs) const {
+            return _pos > rhs._pos;
+        }
+
+        inline bool operator<=(const IndexIterator& rhs) const {
+            return _pos <= rhs._pos;
+        }
+
+        inline bool operator>=(const IndexIterator& rhs) const {
+            return _pos >= rhs._pos;
+        }
+
+        inline difference_type operator-(const IndexIterator& rhs) const {
+            return _pos - rhs._pos;
+        }
+
+        inline IndexIterator& operator++() {
+            ++_pos;
+            return *this;
+        }
+
+        inline auto operator++(int) {
+            auto iterator{*this};
+            operator++();
+            return iterator;
+        }
+
+        inline IndexIterator& operator--() {
+            --_pos;
+            return *this;
+        }
+
+        inline auto operator--(int) {
+            auto iterator{*this};
+            operator--();
+            return iterator;
+        }
+
+        inline IndexIterator& operator+=(difference_type n) {
+            _pos += n;
+            return *this;
+        }
+
+        inline IndexIterator& operator-=(difference_type n) {
+            _pos -= n;
+            return *this;
+        }
+
+        inline IndexIterator operator+(difference_type n) const {
+            auto iterator{*this};
+            return iterator += n;
+        }
+
+        inline IndexIterator operator-(difference_type n) const {
+            auto iterator{*this};
+            return iterator -= n;
+        }
+};
+
+
+// the range of all the rows, or all the columns, of a grid
+template<class Grid, bool columns>
+class Lines {
+
+    Grid _grid;
+    std::size_t _size;
+
+    public:
+
+        using value_type = std::conditional_t<columns, typename Grid::column_type, typename Grid::row_type>;
+        using reference = value_type;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using iterator = IndexIterator<Lines>;
+        using const_iterator = iterator;
+
+        Lines(Grid grid, size_type size) : _grid(std::move(grid)), _size(size) {}
+
+        inline size_type size() const noexcept { return _size; }
+
+        inline const Grid& grid() const noexcept { return _grid; }
+
+        inline reference operator[](size_type pos) const {
+            if constexpr( columns ) return _grid.col(pos);
+            else return _grid.row(pos);
+        }
+
+        inline iterator begin() const { return iterator(*this, 0); }
+
+        inline iterator end() const { return iterator(*this, static_cast<difference_type>(_size)); }
+
+        inline const_iterator cbegin() const { return begin(); }
+
+        inline const_iterator cend() const { return end(); }
+};
+
+
+template<class Grid>
+class Tiles;
+
+
+/*
+ * A flat sequence container seen as a row-major grid of 'height' rows of 'width' elements,
+ * each row starting 'stride' elements after the previous one (the width unless the grid is part of a larger one).
+ *
+ * For example:
+ * std::vector<float> pixels = load(path, height, width);
+ * auto image = grid(pixels, height, width);
+ *
+ * image(r, c) = 0.f;
+ * for( auto& pixel : image.row(r) ) { ... }
+ * for( auto& pixel : image.col(c) ) { ... }
+ *
+ * rows() and cols() are random access ranges of all the rows and columns,
+ * for nested loops, algorithms, or parallel_for:
+ *
+ * for( auto row : image.rows() ) {
+ *     for( auto& pixel : row ) { ... }
+ * }
+ * parallel_for(enumerate(image.rows()), [](auto&& indexed) { ... });
+ *
+ * tiles() cuts it in blocks small enough to stay in cache, see Tiles.
+ */
+template<class Iterator>
+class Grid {
+
+    Iterator _first;
+    std::size_t _height, _width, _stride;
+
+    public:
+
+        using value_type = typename std::iterator_traits<Iterator>::value_type;
+        using size_type = std::size_t;
+        using difference_type = typename std::iterator_traits<Iterator>::difference_type;
+        using reference = typename std::iterator_traits<Iterator>::reference;
+        using row_type = RowView<Iterator>;
+        using column_type = ColumnView<Iterator>;
+
+        Grid(Iterator first, size_type height, size_type width)
+            : Grid(std::move(first), height, width, width) {}
+
+        Grid(Iterator first, size_type height, size_type width, size_type stride)
+            : _first(std::move(first)), _height(height), _width(width), _stride(stride) {}
+
+        inline size_type height() const noexcept { return _height; }
+
+        inline size_type width() const noexcept { return _width; }
+
+        inline size_type stride() const noexcept { return _stride; }
+
+        inline size_type size() const noexcept { return _height * _width; }
+
+        // the top left element
+        inline const Iterator& base() const noexcept { return _first; }
+
+        inline reference operator()(size_type r, size_type c) const {
+            return _first[static_cast<difference_type>(r * _stride + c)];
+        }
+
+        inline row_type row(size_type r) const {
+            return row_type(_first + static_cast<difference_type>(r * _stride), _width);
+        }
+
+        inline column_type col(size_type c) const {
+            return column_type(_first + static_cast<difference_type>(c), _height, static_cast<difference_type>(_stride));
+        }
+
+        inline Lines<Grid, false> rows() const {
+            return Lines<Grid, false>(*this, _height);
+        }
+
+        inline Lines<Grid, true> cols() const {
+            return Lines<Grid, true>(*this, _width);
+        }
+
+        // the 'height' x 'width' block whose top left element is (r, c), sharing this grid's elements
+        inline Grid block(size_type r, size_type c, size_type height, size_type width) const {
+            return Grid(_first + static_cast<difference_type>(r * _stride + c), height, width, _stride);
+        }
+
+        /*
+         * The rows [0, at) and [at, height()) as two grids, or the columns with split_cols,
+         * split() cuts the larger dimension in halves: blocks of a grid can be split again and again,
+         * for divide-and-conquer, at the cost of a few additions.
+         */
+        inline std::pair<Grid, Grid> split_rows(size_type at) const {
+            return {block(0, 0, at, _width), block(at, 0, _height - at, _width)};
+        }
+
+        inline std::pair<Grid, Grid> split_cols(size_type at) const {
+            return {block(0, 0, _height, at), block(0, at, _height, _width - at)};
+        }
+
+        inline std::pair<Grid, Grid> split() const {
+            return _height >= _width ? split_rows(_height / 2) : split_cols(_width / 2);
+        }
+
+        inline Tiles<Grid> tiles() const;
+
+        inline Tiles<Grid> tiles(size_type tile_height, size_type tile_width) const;
+};
+
+
+//
+// CACHE BLOCKING
+//
+
+
+/*
+ * A cache parameter as sysconf reports it, or 'fallback' when it can't tell: sysconf returns 0 or -1
+ * in some containers, on CPUs the C library doesn't know and on systems other than glibc's.
+ * Values outside [low, high] are taken for garbage as well, rather than sizing tiles after them.
+ */
+inline std::size_t cache_parameter(long reported, std::size_t fallback, std::size_t low, std::size_t high) noexcept {
+    if( reported <= 0 ) return fallback;
+    const auto value = static_cast<std::size_t>(reported);
+    return value >= low && value <= high ? value : fallback;
+}
+
+
+// size in bytes of the L1 data cache, 32KiB when the system can't tell
+inline std::size_t l1_cache_size() noexcept {
+#if defined(_SC_LEVEL1_DCACHE_SIZE)
+    static const std::size_t size = cache_parameter(sysconf(_SC_LEVEL1_DCACHE_SIZE), 32 * 1024, 4 * 1024, 1024 * 1024);
+    return size;
+#else
+    return 32 * 1024;
+#endif
+}
+
+
+// number of ways of the L1 data cache, 8 when the system can't tell
+inline std::size_t l1_cache_ways() noexcept {
+#if defined(_SC_LEVEL1_DCACHE_ASSOC)
+    static const std::size_t ways = cache_parameter(sysconf(_SC_LEVEL1_DCACHE_ASSOC), 8, 1, 64);
+    return ways;
+#else
+    return 8;
+#endif
+}
+
+
+/*
+ * Tile dimensions (height, width) for a grid of T, sized after the L1 data cache only:
+ * a tile fills half of it, and spans no more rows than it has ways. When the stride is a multiple of 4KiB
+ * all the rows of a column land in the same cache set, they still fit in it.
+ * Its width is a whole number of cache lines. L2 and L3 aren't taken into account, for tiles
+ * of work that reuses them pass the dimensions to tiles(height, width).
+ */
+template<class T>
+inline std::pair<std::size_t, std::size_t> default_tile_size(std::size_t cache_size, std::size_t cache_ways) noexcept {
+    constexpr std::size_t line = 64 / sizeof(T) ? 64 / sizeof(T) : 1;
+    const std::size_t budget = cache_size / 2 / sizeof(T);
+    const std::size_t height = std::max<std::size_t>(1, std::min(cache_ways, budget / line));
+    const std::size_t width = std::max(line, budget / height / line * line);
+    return {height, width};
+}
+
+template<class T>
+inline std::pair<std::size_t, std::size_t> default_tile_size() noexcept {
+    return default_tile_size<T>(l1_cache_size(), l1_cache_ways());
+}
+
+
+/*
+ * A grid cut in tiles, visited one after the other (left to right, then top to bottom), each tile a Grid itself.
+ * Work that sweeps columns, like reducing them, runs tile by tile at about the speed of a row-major sweep:
+ * the cache lines of a tile are all loaded by its first column and reused by the next ones.
+ *
+ * For example:
+ * std::vector<double> sums(image.width());
+ * for( auto tile : image.tiles() ) {
+ *     for( std::size_t c = 0; c < tile.width(); ++c ) {
+ *         for( auto pixel : tile.col(c) ) sums[tile.left() + c] += pixel;
+ *     }
+ * }
+ *
+ * Tiles on the bottom and right edges are cut down to what is left of the grid.
+ */
+template<class Grid>
+class Tile : public Grid {
+
+    std::size_t _top, _left;
+
+    public:
+
+        Tile(Grid grid, std::size_t top, std::size_t left) : Grid(std::move(grid)), _top(top), _left(left) {}
+
+        // row and column of the parent grid where this tile starts
+        inline std::size_t top() const noexcept { return _top; }
+
+        inline std::size_t left() const noexcept { return _left; }
+};
+
+
+template<class Grid>
+class Tiles {
+
+    Grid _grid;
+    std::size_t _tile_height, _tile_width;
+    std::size_t _across;
+
+    public:
+
+        using value_type = Tile<Grid>;
+        using reference = value_type;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using iterator = IndexIterator<Tiles>;
+        using const_iterator = iterator;
+
+        Tiles(Grid grid, size_type tile_height, size_type tile_width)
+            : _grid(std::move(grid)),
+              _tile_height(std::max<size_type>(1, tile_height)),
+              _tile_width(std::max<size_type>(1, tile_width)),
+              _across((_grid.width() + _tile_width - 1) / _tile_width) {}
+
+        // number of tiles down and across the grid
+        inline size_type height() const noexcept { return (_grid.height() + _tile_height - 1) / _tile_height; }
+
+        inline size_type width() const noexcept { return _across; }
+
+        inline size_type size() const noexcept { return height() * width(); }
+
+        inline reference operator[](size_type pos) const {
+            const size_type top = pos / _across * _tile_height;
+            const size_type left = pos % _across * _tile_width;
+            const size_type height = std::min(_tile_height, _grid.height() - top);
+            const size_type width = std::min(_tile_width, _grid.width() - left);
+            return value_type(_grid.block(top, left, height, width), top, left);
+        }
+
+        inline iterator begin() const { return iterator(*this, 0); }
+
+        inline iterator end() const { return iterator(*this, static_cast<difference_type>(size())); }
+
+        inline const_iterator cbegin() const { return begin(); }
+
+        inline const_iterator cend() const { return end(); }
+};
+
+
+template<class Iterator>
+inline Tiles<Grid<Iterator>> Grid<Iterator>::tiles() const {
+    const auto [tile_height, tile_width] = default_tile_size<value_type>();
+    return tiles(tile_height, tile_width);
+}
+
+
+template<class Iterator>
+inline Tiles<Grid<Iterator>> Grid<Iterator>::tiles(size_type tile_height, size_type tile_width) const {
+    return Tiles<Grid>(*this, tile_height, tile_width);
+}
+
+
+/*
+ * Where a view of 'container' starts: a pointer when its elements are contiguous (std::vector, std::array...),
+ * so views over it work on plain pointers, its begin() otherwise (std::deque...).
+ */
+template<class SequenceContainer, class = void>
+struct has_data : std::false_type {};
+
+template<class SequenceContainer>
+struct has_data<SequenceContainer, std::void_t<decltype(std::data(std::declval<SequenceContainer&>()))>> : std::true_type {};
+
+template<class SequenceContainer>
+inline auto first_element(SequenceContainer& container) {
+    if constexpr( has_data<SequenceContainer>::value ) return std::data(container);
+    else return std::begin(container);
+}
+
+
+// views don't own the container, so a temporary one is rejected rather than left dangling
+template<class SequenceContainer>
+inline auto grid(SequenceContainer&& container, std::size_t rows, std::size_t cols) {
+    static_assert(std::is_lvalue_reference_v<SequenceContainer>, "grid() views a container without owning it, a temporary would be destroyed under the view");
+    return Grid<decltype(first_element(container))>(first_element(container), rows, cols);
+}
+
+
+/*
+ * The 'height' x 'width' window of 'grid' whose top left element is (top, left), to hand part of a grid to a worker.
+ * It aliases the parent's elements, its rows are as far apart as the parent's (its stride(), BLAS's leading dimension),
+ * and it has rows, columns, tiles and sub-grids of its own. The window has to fit in the grid.
+ *
+ * For example, rows 100 to 199 and columns 50 to 79:
+ * auto window = subgrid(image, 100, 50, 100, 30);
+ * for( auto& pixel : window.col(0) ) { ... }        // column 50 of image, from row 100 to row 199
+ *
+ * void scale(Grid<float*> g, float factor) {
+ *     if( g.size() <= 4096 ) {
+ *         for( auto row : g.rows() ) { for( auto& x : row ) x *= factor; }
+ *         return;
+ *     }
+ *     auto [first, second] = g.split();      // each half to a worker
+ *     scale(first, factor); scale(second, factor);
+ * }
+ */
+template<class Iterator>
+inline Grid<Iterator> subgrid(const Grid<Iterator>& grid, std::size_t top, std::size_t left, std::size_t height, std::size_t width) {
+    return grid.block(top, left, height, width);
+}
+
+
+template<class SequenceContainer>
+inline auto row(SequenceContainer&& container, std::size_t row_number, std::size_t rows, std::size_t cols) {
+    static_assert(std::is_lvalue_reference_v<SequenceContainer>, "row() views a container without owning it, a temporary would be destroyed under the view");
+    return grid(container, rows, cols).row(row_number);
+}
+
+
+template<class SequenceContainer>
+inline auto col(SequenceContainer&& container, std::size_t column_number, std::size_t rows, std::size_t cols) {
+    static_assert(std::is_lvalue_reference_v<SequenceContainer>, "col() views a container without owning it, a temporary would be destroyed under the view");
+    return grid(container, rows, cols).col(column_number);
+}
+
+
 #endif
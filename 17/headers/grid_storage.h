@@ -0,0 +1,181 @@
+#ifndef __VIPER_GRID_STORAGE__
+#define __VIPER_GRID_STORAGE__
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "grid.h"
+
+
+/*
+ * A grid that owns its elements, laid out for SIMD kernels:
+ * the buffer is 64-byte aligned (a cache line, an AVX-512 register) and each row is padded up to a multiple of 64 bytes
+ * (when the size of T divides 64), so every row starts aligned, whatever the width. A 1001 floats wide grid has rows of 1008 floats.
+ * Rows that would end up a multiple of 1KiB apart get one more cache line: the elements of a column
+ * would otherwise all fall in a few sets of the L1 cache, and rows exactly 4KiB apart make the CPU mistake
+ * loads from a row for stores to another (4K aliasing).
+ *
+ * For example:
+ * GridStorage<float> image(height, width);
+ * image(r, c) = 1.f;
+ * for( auto& pixel : image.row(r) ) { ... }     // the same views as grid()'s, over the first width() elements of each row
+ * transpose(image.view(), other.view());         // the Grid of all the elements, for everything that takes one
+ *
+ * padded_row(r) is the whole row, padding included (stride() elements, initialized like the others),
+ * for kernels that would rather run over a multiple of their register width than handle a tail.
+ */
+template<class T>
+class GridStorage {
+
+    public:
+
+        static constexpr std::size_t alignment = 64;
+
+        using value_type = T;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using reference = T&;
+        using const_reference = const T&;
+        using pointer = T*;
+        using const_pointer = const T*;
+        using view_type = Grid<T*>;
+        using const_view_type = Grid<const T*>;
+
+    private:
+
+        // frees the memory only, before the elements are constructed
+        struct Release {
+            inline void operator()(T* p) const noexcept { ::operator delete(p, std::align_val_t(alignment)); }
+        };
+
+        // destroys the elements, then frees the memory
+        struct Destroy {
+            std::size_t count;
+
+            inline void operator()(T* p) const noexcept {
+                std::destroy_n(p, count);
+                Release()(p);
+            }
+        };
+
+        std::unique_ptr<T, Destroy> _data;
+        size_type _height, _width, _stride;
+
+        static inline std::unique_ptr<T, Release> allocate(size_type count) {
+            return std::unique_ptr<T, Release>(static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(alignment))));
+        }
+
+        static inline std::unique_ptr<T, Destroy> filled(size_type count, const T& value) {
+            auto memory = allocate(count);
+            std::uninitialized_fill_n(memory.get(), count, value);
+            return std::unique_ptr<T, Destroy>(memory.release(), Destroy{count});
+        }
+
+        static inline std::unique_ptr<T, Destroy> copied(size_type count, const T* elements) {
+            if( elements == nullptr ) return std::unique_ptr<T, Destroy>(nullptr, Destroy{0});   // a moved-from storage
+            auto memory = allocate(count);
+            std::uninitialized_copy_n(elements, count, memory.get());
+            return std::unique_ptr<T, Destroy>(memory.release(), Destroy{count});
+        }
+
+    public:
+
+        // elements from one row to the next for rows of 'width' elements, see above
+        static constexpr size_type padded_stride(size_type width) noexcept {
+            constexpr size_type line = alignment % sizeof(T) == 0 ? alignment / sizeof(T) : 1;
+            size_type stride = (width + line - 1) / line * line;
+            if( stride > 0 && stride * sizeof(T) % 1024 == 0 ) stride += line;
+            return stride;
+        }
+
+        GridStorage(size_type height, size_type width, const T& value = T())
+            : _data(filled(height * padded_stride(width), value)), _height(height), _width(width), _stride(padded_stride(width)) {}
+
+        GridStorage(const GridStorage& other)
+            : _data(copied(other._height * other._stride, other.data())), _height(other._height), _width(other._width), _stride(other._stride) {}
+
+        // the moved-from storage is left empty, 0 x 0 without elements
+        GridStorage(GridStorage&& other) noexcept
+            : _data(std::move(other._data)), _height(std::exchange(other._height, 0)), _width(std::exchange(other._width, 0)),
+              _stride(std::exchange(other._stride, 0)) {}
+
+        GridStorage& operator=(const GridStorage& other) {
+            if( this != &other ) *this = GridStorage(other);
+            return *this;
+        }
+
+        GridStorage& operator=(GridStorage&& other) noexcept {
+            if( this != &other ) {
+                _data = std::move(other._data);
+                _height = std::exchange(other._height, 0);
+                _width = std::exchange(other._width, 0);
+                _stride = std::exchange(other._stride, 0);
+            }
+            return *this;
+        }
+
+        inline void swap(GridStorage& other) noexcept {
+            std::swap(_data, other._data);
+            std::swap(_height, other._height);
+            std::swap(_width, other._width);
+            std::swap(_stride, other._stride);
+        }
+
+        inline size_type height() const noexcept { return _height; }
+
+        inline size_type width() const noexcept { return _width; }
+
+        // elements from the start of one row to the start of the next, padded_stride(width())
+        inline size_type stride() const noexcept { return _stride; }
+
+        inline size_type size() const noexcept { return _height * _width; }
+
+        // the first element of the first row, 64-byte aligned
+        inline T* data() noexcept { return _data.get(); }
+
+        inline const T* data() const noexcept { return _data.get(); }
+
+        inline reference operator()(size_type r, size_type c) { return data()[r * _stride + c]; }
+
+        inline const_reference operator()(size_type r, size_type c) const { return data()[r * _stride + c]; }
+
+        inline view_type view() noexcept { return view_type(data(), _height, _width, _stride); }
+
+        inline const_view_type view() const noexcept { return const_view_type(data(), _height, _width, _stride); }
+
+        //
+        // THE VIEWS OF A GRID
+        //
+
+        inline auto row(size_type r) { return view().row(r); }
+
+        inline auto row(size_type r) const { return view().row(r); }
+
+        inline auto padded_row(size_type r) { return RowView<T*>(data() + r * _stride, _stride); }
+
+        inline auto padded_row(size_type r) const { return RowView<const T*>(data() + r * _stride, _stride); }
+
+        inline auto col(size_type c) { return view().col(c); }
+
+        inline auto col(size_type c) const { return view().col(c); }
+
+        inline auto rows() { return view().rows(); }
+
+        inline auto rows() const { return view().rows(); }
+
+        inline auto cols() { return view().cols(); }
+
+        inline auto cols() const { return view().cols(); }
+
+        inline auto block(size_type r, size_type c, size_type height, size_type width) { return view().block(r, c, height, width); }
+
+        inline auto block(size_type r, size_type c, size_type height, size_type width) const { return view().block(r, c, height, width); }
+
+        inline auto tiles() { return view().tiles(); }
+
+        inline auto tiles() const { return view().tiles(); }
+};
+
+#endif
@@ -1,19 +1,342 @@
+#ifndef __VIPER_IN__
+#define __VIPER_IN__
+
 #include <algorithm>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "simd.h"
+
+
+/*
+ * True when Container stores its values in one contiguous block of arithmetic values
+ * (std::vector<int>, std::array<uint16_t, N>, std::string...), which the SIMD kernels can scan directly.
+ */
+template<class Container, class = void>
+struct is_contiguous_arithmetic : std::false_type {};
+
+template<class Container>
+struct is_contiguous_arithmetic<Container, std::void_t<decltype(std::data(std::declval<const Container&>()))>>
+    : std::bool_constant<
+        simd::is_vectorizable_v<typename Container::value_type>
+        && std::is_same_v<decltype(std::data(std::declval<const Container&>())), const typename Container::value_type*>
+      > {};
+
+template<class Container>
+constexpr bool is_contiguous_arithmetic_v = is_contiguous_arithmetic<Container>::value;
+
 
+// std::set, std::unordered_set... and anything else offering a member contains() (C++20)
+template<class Container, class T, class = void>
+struct has_member_contains : std::false_type {};
+
+template<class Container, class T>
+struct has_member_contains<Container, T, std::void_t<
+    decltype(std::declval<const Container&>().contains(std::declval<const T&>()))
+    >> : std::true_type {};
+
+
+// associative containers, but not std::string whose find() returns a position
+template<class Container, class T, class = void>
+struct has_member_find : std::false_type {};
+
+template<class Container, class T>
+struct has_member_find<Container, T, std::void_t<
+    decltype(std::declval<const Container&>().find(std::declval<const T&>()) != std::declval<const Container&>().end())
+    >> : std::true_type {};
+
+
+// std::map, std::unordered_map... where we look up a key rather than a (key, value) pair
+template<class Container, class = void>
+struct is_map_like : std::false_type {};
+
+template<class Container>
+struct is_map_like<Container, std::void_t<typename Container::key_type, typename Container::mapped_type>> : std::true_type {};
 
 template<class Container>
-constexpr bool in(const Container& c, typename Container::const_reference value) {
-    return std::find(c.cbegin(), c.cend(), value) != c.cend();
+constexpr bool is_map_like_v = is_map_like<Container>::value;
+
+
+/*
+ * Wraps a container the caller promises is already sorted according to Compare,
+ * so 'in' can binary search it instead of scanning it.
+ * The element the search lands on is compared with ==, like an unsorted scan would:
+ * NaN is neither less nor greater than anything, yet equals nothing.
+ * Unlike Python's 'sorted' it doesn't sort anything, nor copy the container.
+ *
+ * For example:
+ * std::vector<int> whitelist = {2, 3, 5, 7, 11};
+ *
+ * if( in(sorted(whitelist), 7) ) { ... }
+ */
+template<class Container, class Compare = std::less<>>
+class Sorted {
+
+    const Container& data;
+    Compare compare;
+
+    public:
+
+        using container_t = std::remove_reference_t<Container>;
+        using value_type = typename container_t::value_type;
+        using size_type = typename container_t::size_type;
+        using reference = typename container_t::reference;
+        using const_reference = typename container_t::const_reference;
+        using const_iterator = typename container_t::const_iterator;
+        using iterator = const_iterator;
+
+        constexpr Sorted(const Container& container, Compare compare = Compare()) noexcept
+            : data(container), compare(compare) {}
+
+        inline auto begin() const { return data.cbegin(); }
+
+        inline auto end() const { return data.cend(); }
+
+        inline auto cbegin() const { return data.cbegin(); }
+
+        inline auto cend() const { return data.cend(); }
+
+        inline auto size() const { return data.size(); }
+
+        template<class T>
+        bool contains(const T& value) const {
+            using category = typename std::iterator_traits<const_iterator>::iterator_category;
+            if constexpr( std::is_base_of_v<std::random_access_iterator_tag, category> ) {
+                // branchless lower bound: the loop only depends on the size, the compiler turns the ternary into a cmov
+                auto base = data.cbegin();
+                auto n = std::distance(data.cbegin(), data.cend());
+                if( n == 0 ) return false;
+                while( n > 1 ) {
+                    const auto half = n / 2;
+                    base = compare(base[half], value) ? base + half : base;
+                    n -= half;
+                }
+                base += compare(*base, value);
+                return base != data.cend() && *base == value;
+            } else {
+                const auto found = std::lower_bound(data.cbegin(), data.cend(), value, compare);
+                return found != data.cend() && *found == value;
+            }
+        }
+};
+
+
+template<class Container, class Compare = std::less<>>
+constexpr auto sorted(const Container& container, Compare compare = Compare()) noexcept {
+    return Sorted<Container, Compare>(container, compare);
 }
 
+
+/*
+ * True when 'value' converted to T is still 'value': it converts to T and back unchanged, or it is an integer
+ * and T a floating point type, which == would convert it to anyway.
+ * 300 isn't a uint8_t, nor 2.5 an int: converted they would find 44 or 2 where == finds neither,
+ * so neither the SIMD kernels, which compare values of a single type, nor std::set<T>::find can be given them.
+ */
+template<class T, class Needle>
+constexpr bool converts_exactly(const Needle& value) {
+    if constexpr( std::is_same_v<T, Needle> ) {
+        return true;
+    } else if constexpr( std::is_integral_v<Needle> ) {
+        // == converts an integer to the floating point type, and between integers it matches the round trip
+        if constexpr( std::is_floating_point_v<T> ) return true;
+        else return static_cast<Needle>(static_cast<T>(value)) == value;
+    } else if constexpr( std::is_floating_point_v<T> ) {
+        if constexpr( std::numeric_limits<Needle>::digits <= std::numeric_limits<T>::digits
+                   && std::numeric_limits<Needle>::max_exponent <= std::numeric_limits<T>::max_exponent ) {
+            return true;
+        } else {
+            // converting a value out of T's range is undefined, check it first
+            return value >= -static_cast<Needle>(std::numeric_limits<T>::max()) && value <= static_cast<Needle>(std::numeric_limits<T>::max())
+                && static_cast<Needle>(static_cast<T>(value)) == value;
+        }
+    } else {
+        // a floating point needle and integers: T's range is [lowest, 2^digits), both ends exact in floating point
+        constexpr Needle upper = static_cast<Needle>(std::numeric_limits<T>::max() / 2 + 1) * 2;
+        return value >= static_cast<Needle>(std::numeric_limits<T>::lowest()) && value < upper
+            && static_cast<Needle>(static_cast<T>(value)) == value;
+    }
+}
+
+
+// integers wider than a floating point needle's mantissa round when == compares them with it: 2^53 + 1 == 2^53.
+// A SIMD scan for the converted needle would miss the rounded ones.
+template<class T, class Needle>
+constexpr bool rounds_when_compared_v = std::is_integral_v<T> && std::is_floating_point_v<Needle>
+                                     && (std::numeric_limits<T>::digits > std::numeric_limits<Needle>::digits);
+
+
+template<class Container, class = void>
+struct has_key_type : std::false_type {};
+
 template<class Container>
-constexpr bool in(const Container& c, typename Container::value_type&& value) {
-    return std::find(c.cbegin(), c.cend(), value) != c.cend();
+struct has_key_type<Container, std::void_t<typename Container::key_type>> : std::true_type {};
+
+
+// false when the container's own lookup, converting the needle to its key type, would look for another number
+template<class Container, class T>
+inline bool is_possible_key(const T& value) {
+    if constexpr( has_key_type<Container>::value ) {
+        using key_t = typename Container::key_type;
+        if constexpr( std::is_arithmetic_v<key_t> && std::is_arithmetic_v<T> ) return converts_exactly<key_t>(value);
+    }
+    return true;
 }
 
+
+/*
+ * Picks the fastest way to look 'value' up, from the container's own traits:
+ * member contains() or find() for associative containers and Sorted,
+ * SIMD scan for contiguous arithmetic values, linear scan otherwise.
+ */
+template<class Container, class T>
+inline bool find_in(const Container& c, const T& value) {
+    if constexpr( has_member_contains<Container, T>::value ) {
+        return is_possible_key<Container>(value) && c.contains(value);
+    } else if constexpr( has_member_find<Container, T>::value ) {
+        return is_possible_key<Container>(value) && c.find(value) != c.end();
+    } else if constexpr( is_contiguous_arithmetic_v<Container> ) {
+        using value_t = typename Container::value_type;
+        const auto first = std::data(c);
+        const auto last = first + std::size(c);
+        if constexpr( std::is_arithmetic_v<T> && !rounds_when_compared_v<value_t, T> ) {
+            if( converts_exactly<value_t>(value) ) return simd::find(first, last, static_cast<value_t>(value)) != last;
+        }
+        return std::find(first, last, value) != last;
+    } else {
+        return std::find(c.cbegin(), c.cend(), value) != c.cend();
+    }
+}
+
+
+// the type of a braced needle, in(container, {...}): like Python, 'in' on a map looks up a key
+template<class Container, class = void>
+struct needle_type {
+    using type = typename Container::value_type;
+};
+
 template<class Container>
-constexpr bool in(Container&& c, typename Container::value_type&& value) {
-    return std::find(c.cbegin(), c.cend(), value) != c.cend();
+struct needle_type<Container, std::enable_if_t<is_map_like_v<Container>>> {
+    using type = typename Container::key_type;
+};
+
+
+// the needle is compared as it is, not converted to the container's values first: in(bytes, 300) is false
+template<class Container, class T = typename needle_type<std::remove_reference_t<Container>>::type>
+constexpr bool in(const Container& c, const T& value) {
+    return find_in(c, value);
 }
 
 
+/*
+ * Batch membership: check many needles against the same haystack.
+ *
+ * Past 'in_batch_threshold' needles, a haystack without a fast lookup of its own is indexed once
+ * (sorted copy for numbers, hash set for other hashable values) so the whole batch costs
+ * roughly O(N+M) instead of O(N*M). Needles are compared with == like in() does, whatever their number:
+ * a hash set of floats would convert a double needle to float before looking it up, a sorted copy compares it as it is.
+ *
+ * For example:
+ * std::vector<int> whitelist = {80, 443, 8080};
+ * std::vector<int> ports = {22, 80, 443};
+ *
+ * in_mask(whitelist, ports); // std::vector<bool>{false, true, true}
+ * in_any(whitelist, ports);  // true
+ * in_all(whitelist, ports);  // false
+ */
+constexpr std::size_t in_batch_threshold = 16;
+
+
+template<class T, class = void>
+struct is_hashable : std::false_type {};
+
+template<class T>
+struct is_hashable<T, std::void_t<decltype(std::hash<T>()(std::declval<const T&>()))>>
+    : std::is_default_constructible<std::hash<T>> {};
+
+
+template<class T, class = void>
+struct is_less_comparable : std::false_type {};
+
+template<class T>
+struct is_less_comparable<T, std::void_t<decltype(std::declval<const T&>() < std::declval<const T&>())>> : std::true_type {};
+
+
+// number of needles, or the threshold when a single pass range can't tell us
+template<class Needles>
+inline std::size_t batch_size(const Needles& needles) {
+    using category = typename std::iterator_traits<decltype(std::begin(needles))>::iterator_category;
+    if constexpr( std::is_base_of_v<std::forward_iterator_tag, category> ) {
+        return static_cast<std::size_t>(std::distance(std::begin(needles), std::end(needles)));
+    } else {
+        return in_batch_threshold;
+    }
+}
+
+
+// calls visit(found) for each needle in order, until visit returns false
+template<class Container, class Needles, class Visitor>
+void visit_membership(const Container& c, const Needles& needles, Visitor&& visit) {
+    using value_t = typename Container::value_type;
+    using needle_t = std::decay_t<decltype(*std::begin(needles))>;
+
+    auto lookup_each = [&needles, &visit](const auto& haystack) {
+        for( const auto& needle : needles ) {
+            if( !visit(find_in(haystack, needle)) ) return;
+        }
+    };
+
+    if constexpr( has_member_contains<Container, needle_t>::value || has_member_find<Container, needle_t>::value ) {
+        lookup_each(c);
+    } else if( batch_size(needles) < in_batch_threshold ) {
+        lookup_each(c);
+    } else if constexpr( std::is_arithmetic_v<value_t> || (!is_hashable<value_t>::value && is_less_comparable<value_t>::value) ) {
+        std::vector<value_t> index(c.cbegin(), c.cend());
+        if constexpr( std::is_floating_point_v<value_t> ) {
+            // NaNs don't sort, and equal nothing anyway
+            index.erase(std::remove_if(index.begin(), index.end(), [](value_t x) { return x != x; }), index.end());
+        }
+        std::sort(index.begin(), index.end());
+        lookup_each(sorted(index));
+    } else if constexpr( is_hashable<value_t>::value ) {
+        const std::unordered_set<value_t> index(c.cbegin(), c.cend());
+        lookup_each(index);
+    } else {
+        lookup_each(c);
+    }
+}
+
+
+// one bool per needle, true when the needle is in the container
+template<class Container, class Needles>
+std::vector<bool> in_mask(const Container& c, const Needles& needles) {
+    std::vector<bool> mask;
+    mask.reserve(batch_size(needles));
+    visit_membership(c, needles, [&mask](bool found) { mask.push_back(found); return true; });
+    return mask;
+}
+
+
+// true when at least one needle is in the container
+template<class Container, class Needles>
+bool in_any(const Container& c, const Needles& needles) {
+    bool any = false;
+    visit_membership(c, needles, [&any](bool found) { any = found; return !found; });
+    return any;
+}
+
+
+// true when every needle is in the container, also true for no needles
+template<class Container, class Needles>
+bool in_all(const Container& c, const Needles& needles) {
+    bool all = true;
+    visit_membership(c, needles, [&all](bool found) { all = found; return found; });
+    return all;
+}
+
+#endif
@@ -1,119 +1,129 @@
+#ifndef __VIPER_ITERATOR_CAST__
+#define __VIPER_ITERATOR_CAST__
+
 #include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "function_box.h"
+#include "parallel.h"
+#include "traits.h"
+
+
+/*
+ * Iterator adaptor dereferencing to convert(*iter), in the spirit of Python's 'map'.
+ * The conversion is stored by value (see FunctionBox) and called directly, so it can be inlined.
+ *
+ * For example:
+ * auto to_char = [](const int& i) { return (char)(i+48); };
+ * std::string str(iterator_cast(vi.cbegin(), to_char), iterator_cast(vi.cend(), to_char));
+ */
+template<class Iterator, class UnaryFunction>
 
+class Iter : private FunctionBox<UnaryFunction> {
 
-template<class Iterator, class UnaryFunction>
+    using box_t = FunctionBox<UnaryFunction>;
+    using traits_t = std::iterator_traits<Iterator>;
 
-class Iter : public Iterator {
-    
-    UnaryFunction& _convert;
+    Iterator _iter;
 
     public:
 
-    //TODO provide valid value_type and reference!
-        //using value_type = typename std::iterator_traits<T*>::value_type;
-        //using reference = typename std::iterator_traits<T*>::reference;
+        using iterator_type = Iterator;
+        using difference_type = typename traits_t::difference_type;
+        using reference = std::invoke_result_t<const UnaryFunction&, typename traits_t::reference>;
+        using value_type = std::remove_cv_t<std::remove_reference_t<reference>>;
+        using pointer = void;
+        using iterator_category = typename traits_t::iterator_category;
 
-        Iter(const Iterator& iter, const UnaryFunction& convert)
-            : Iterator(iter),_convert(convert) {}
+        Iter(Iterator iter, UnaryFunction convert)
+            : box_t(std::move(convert)), _iter(std::move(iter)) {}
 
-        Iter(Iterator&& iter, UnaryFunction&& convert)
-            : Iterator(std::move(iter)), _convert(std::move(convert)) {}
+        inline const Iterator& base() const noexcept { return _iter; }
 
-        inline auto operator*() {
-            return _convert(Iterator::operator*());
+        inline reference operator*() const {
+            return box_t::function()(*_iter);
         }
-};
 
+        inline reference operator[](difference_type n) const {
+            return box_t::function()(_iter[n]);
+        }
 
-template<class T, class UnaryFunction>
+        inline bool operator==(const Iter& rhs) const {
+            return _iter == rhs._iter;
+        }
 
-class Iter<T*, UnaryFunction> {
-    T* _iter;
-    UnaryFunction& _convert;
+        inline bool operator!=(const Iter& rhs) const {
+            return _iter != rhs._iter;
+        }
 
-    public:
+        inline bool operator<(const Iter& rhs) const {
+            return _iter < rhs._iter;
+        }
 
-        using difference_type = typename std::iterator_traits<T*>::difference_type;
-        using value_type = typename std::iterator_traits<T*>::value_type;
-        using pointer = typename std::iterator_traits<T*>::pointer;
-        using reference = typename std::iterator_traits<T*>::reference;
-        using iterator_category = typename std::iterator_traits<T*>::iterator_category;
+        inline bool operator>(const Iter& rhs) const {
+            return _iter > rhs._iter;
+        }
 
-        Iter(T* iter, const UnaryFunction& convert)
-            : _iter(iter),_convert(convert) {}
+        inline bool operator<=(const Iter& rhs) const {
+            return _iter <= rhs._iter;
+        }
 
-        //Iter(T* iter, UnaryFunction&& convert)
-            //: _iter(iter),_convert(std::move(convert)) {}
+        inline bool operator>=(const Iter& rhs) const {
+            return _iter >= rhs._iter;
+        }
 
-        inline bool operator!=(const Iter<T*, UnaryFunction>& rhs) const {
-            return _iter != rhs._iter;
+        inline difference_type operator-(const Iter& rhs) const {
+            return _iter - rhs._iter;
         }
 
-        inline auto operator++() {
+        inline Iter& operator++() {
             ++_iter;
             return *this;
         }
 
-        inline auto operator*() {
-            return _convert(*_iter);
+        inline auto operator++(int) {
+            auto iterator{*this};
+            operator++();
+            return iterator;
         }
-};
-
-
-template<class T, class UnaryFunction>
-
-class Iter<const T*, UnaryFunction> {
-    const T* _iter;
-    UnaryFunction& _convert;
-
-    public:
-
-        using difference_type = typename std::iterator_traits<const T*>::difference_type;
-        using value_type = typename std::iterator_traits<const T*>::value_type;
-        using pointer = typename std::iterator_traits<const T*>::pointer;
-        using reference = typename std::iterator_traits<const T*>::reference;
-        using iterator_category = typename std::iterator_traits<const T*>::iterator_category;
-
-        Iter(const T* iter, const UnaryFunction& convert)
-            : _iter(iter),_convert(convert) {}
 
-        //Iter(T* iter, UnaryFunction&& convert)
-            //: _iter(iter),_convert(std::move(convert)) {}
+        inline Iter& operator--() {
+            --_iter;
+            return *this;
+        }
 
-        inline bool operator!=(const Iter<const T*, UnaryFunction>& rhs) const {
-            return _iter != rhs._iter;
+        inline auto operator--(int) {
+            auto iterator{*this};
+            operator--();
+            return iterator;
         }
 
-        inline difference_type operator-(const Iter<const T*, UnaryFunction>& rhs) const {
-            return _iter - rhs._iter;
+        inline Iter& operator+=(difference_type n) {
+            _iter += n;
+            return *this;
         }
 
-        inline auto operator++() {
-            ++_iter;
+        inline Iter& operator-=(difference_type n) {
+            _iter -= n;
             return *this;
         }
 
-        inline auto operator*() {
-            return _convert(*_iter);
+        inline Iter operator+(difference_type n) const {
+            auto iterator{*this};
+            return iterator += n;
+        }
+
+        inline Iter operator-(difference_type n) const {
+            auto iterator{*this};
+            return iterator -= n;
         }
 };
 
 
 template<class Iterator, class UnaryFunction>
 inline auto iterator_cast(Iterator&& iter, UnaryFunction&& convert) {
-    return Iter<Iterator, UnaryFunction>(std::forward<Iterator>(iter), std::forward<UnaryFunction>(convert));
-};
-
-
-template<class T, class UnaryFunction>
-inline auto iterator_cast(T* iter, UnaryFunction&& convert) {
-   return Iter<decltype(iter), decltype(convert)>(iter, std::forward<UnaryFunction>(convert));
-}
-
-
-template<class T, class UnaryFunction>
-inline auto iterator_cast(const T* iter, UnaryFunction&& convert) {
-   return Iter<decltype(iter), decltype(convert)>(iter, std::forward<UnaryFunction>(convert));
+    return Iter<std::decay_t<Iterator>, std::decay_t<UnaryFunction>>(std::forward<Iterator>(iter), std::forward<UnaryFunction>(convert));
 }
 
 
@@ -129,3 +139,34 @@ T into(const UnaryFunction& fn, Container&& c) {
 }
 
 
+/*
+ * Parallel transform of a random access container into a random access container of the same size,
+ * allocated once (default constructed, then resized) then filled chunk by chunk in parallel.
+ * Outputs without resize(), and std::vector<bool> (see is_bit_packed), are filled sequentially.
+ *
+ * For example:
+ * auto names = into<std::vector<std::string>>(par, name_of, records);
+ */
+template<class T, class UnaryFunction, class Container>
+T into(const parallel_policy& policy, const UnaryFunction& fn, const Container& c) {
+    using category = typename std::iterator_traits<typename std::remove_reference_t<Container>::const_iterator>::iterator_category;
+    using out_category = typename std::iterator_traits<typename T::iterator>::iterator_category;
+    static_assert(std::is_base_of_v<std::random_access_iterator_tag, category>, "parallel into needs a random access container");
+    static_assert(std::is_base_of_v<std::random_access_iterator_tag, out_category>, "parallel into needs a random access output");
+
+    if constexpr( is_bit_packed<T>::value || !has_resize<T>::value ) {
+        return into<T>(fn, c);
+    } else {
+        const std::size_t size = std::size(c);
+        const auto first = c.cbegin();
+        T out;
+        out.resize(size);
+        auto out_first = out.begin();
+        parallel_chunks(chunk_count(policy, size), size, [&](std::size_t, std::size_t begin, std::size_t end) {
+            for( std::size_t i = begin; i < end; ++i ) out_first[i] = fn(first[i]);
+        });
+        return out;
+    }
+}
+
+#endif
@@ -0,0 +1,301 @@
+#ifndef __VIPER_PARALLEL__
+#define __VIPER_PARALLEL__
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+/*
+ * Execution policy for the parallel overloads of Viper's functions.
+ *
+ * For example:
+ * auto evens = filter(par, even, records);                  // as many chunks as hardware threads
+ * auto evens = filter(parallel_policy{8}, even, records);   // at most 8 chunks
+ *
+ * 'threads' caps the number of chunks the input is split into (0 means one per hardware thread),
+ * 'grain' is the minimum number of elements per chunk, so small inputs aren't worth waking a thread for.
+ * 0 lets each function pick its own: default_grain for filter and into, whose elements are cheap,
+ * one element for parallel_for, whose elements are expected to be expensive.
+ */
+struct parallel_policy {
+    std::size_t threads = 0;
+    std::size_t grain = 0;
+};
+
+inline constexpr std::size_t default_grain = 4096;
+
+inline constexpr parallel_policy par{};
+
+
+/*
+ * The thread pool backing the parallel policy.
+ * Tasks go through a single queue, a thread waiting on its tasks helps running the queue,
+ * so parallel calls can be nested without running out of workers.
+ */
+class ThreadPool {
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable ready;
+    bool stopping = false;
+
+    void work() {
+        for(;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if( tasks.empty() ) return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    public:
+
+        explicit ThreadPool(std::size_t threads) {
+            workers.reserve(threads);
+            for( std::size_t i = 0; i < threads; ++i ) workers.emplace_back([this] { work(); });
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            ready.notify_all();
+            for( auto& worker : workers ) worker.join();
+        }
+
+        // the calling thread works too, so one less than the hardware threads
+        static ThreadPool& instance() {
+            static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+            return pool;
+        }
+
+        inline std::size_t size() const noexcept { return workers.size(); }
+
+        void submit(std::function<void()> task) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                tasks.push_back(std::move(task));
+            }
+            ready.notify_one();
+        }
+
+        // runs one queued task on the calling thread, false when there was none
+        bool try_run_one() {
+            std::function<void()> task;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if( tasks.empty() ) return false;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+            return true;
+        }
+};
+
+
+// number of chunks the policy splits 'size' elements into, 'fallback_grain' when the policy leaves the grain to the caller
+inline std::size_t chunk_count(const parallel_policy& policy, std::size_t size, std::size_t fallback_grain = default_grain) noexcept {
+    const std::size_t threads = policy.threads ? policy.threads : std::max(1u, std::thread::hardware_concurrency());
+    const std::size_t grain = std::max<std::size_t>(1, policy.grain ? policy.grain : fallback_grain);
+    return std::max<std::size_t>(1, std::min(threads, size / grain));
+}
+
+
+/*
+ * Containers whose neighbouring elements share memory: std::vector<bool> packs them in words,
+ * writing two of them from different threads is a data race even at different indices.
+ * The parallel overloads fill these sequentially.
+ */
+template<class Container>
+struct is_bit_packed : std::false_type {};
+
+template<class Allocator>
+struct is_bit_packed<std::vector<bool, Allocator>> : std::true_type {};
+
+
+/*
+ * Splits [0, size) into 'chunks' contiguous ranges of nearly equal size
+ * and calls fn(chunk, begin, end) for each of them, the first one on the calling thread.
+ * Returns once all of them are done, re-throwing the first exception thrown by fn.
+ */
+template<class Function>
+void parallel_chunks(std::size_t chunks, std::size_t size, Function&& fn) {
+    auto bounds = [chunks, size](std::size_t chunk) { return chunk * size / chunks; };
+
+    if( chunks <= 1 ) {
+        fn(std::size_t(0), std::size_t(0), size);
+        return;
+    }
+
+    std::mutex mutex;
+    std::condition_variable done;
+    std::size_t remaining = chunks - 1;
+    std::exception_ptr error;
+
+    auto& pool = ThreadPool::instance();
+    for( std::size_t chunk = 1; chunk < chunks; ++chunk ) {
+        pool.submit([&, chunk] {
+            std::exception_ptr chunk_error;
+            try {
+                fn(chunk, bounds(chunk), bounds(chunk+1));
+            } catch(...) {
+                chunk_error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            if( chunk_error && !error ) error = chunk_error;
+            if( --remaining == 0 ) done.notify_one();
+        });
+    }
+
+    try {
+        fn(std::size_t(0), bounds(0), bounds(1));
+    } catch(...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if( !error ) error = std::current_exception();
+    }
+
+    for(;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if( remaining == 0 ) break;
+        }
+        if( !pool.try_run_one() ) {
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [&remaining] { return remaining == 0; });
+            break;
+        }
+    }
+
+    if( error ) std::rethrow_exception(error);
+}
+
+
+/*
+ * Blocks of work handed out to the threads of a parallel_for.
+ * Each thread starts with its own contiguous share of the blocks and runs them front to back,
+ * once it runs out it steals the back half of what another thread has left,
+ * so a thread stuck on expensive elements gets helped rather than waited for.
+ * Blocks only move under their owner's lock, so each of them runs exactly once.
+ */
+class WorkStealingBlocks {
+
+    struct alignas(64) Share {
+        std::mutex mutex;
+        std::size_t begin = 0, end = 0;
+    };
+
+    std::vector<Share> shares;
+
+    public:
+
+        WorkStealingBlocks(std::size_t threads, std::size_t blocks) : shares(threads) {
+            for( std::size_t thread = 0; thread < threads; ++thread ) {
+                shares[thread].begin = thread * blocks / threads;
+                shares[thread].end = (thread + 1) * blocks / threads;
+            }
+        }
+
+        // next block for 'thread', from its own share or stolen from another one, false once there is no work left
+        bool next(std::size_t thread, std::size_t& block) {
+            auto& own = shares[thread];
+            {
+                std::lock_guard<std::mutex> lock(own.mutex);
+                if( own.begin != own.end ) {
+                    block = own.begin++;
+                    return true;
+                }
+            }
+            for( std::size_t k = 1; k < shares.size(); ++k ) {
+                auto& victim = shares[(thread + k) % shares.size()];
+                std::size_t begin, end;
+                {
+                    std::lock_guard<std::mutex> lock(victim.mutex);
+                    if( victim.begin == victim.end ) continue;
+                    end = victim.end;
+                    begin = end - std::max<std::size_t>(1, (end - victim.begin) / 2);
+                    victim.end = begin;
+                }
+                std::lock_guard<std::mutex> lock(own.mutex);
+                block = begin;
+                own.begin = begin + 1;
+                own.end = end;
+                return true;
+            }
+            return false;
+        }
+};
+
+
+/*
+ * Calls fn(element) for every element of a random access range, in parallel, each element exactly once.
+ * Made for enumerate(), so the index comes along with the value:
+ *
+ * parallel_for(enumerate(images), [](auto&& indexed) { thumbnails[indexed.first] = thumbnail(indexed.second); });
+ *
+ * The range is cut in blocks balanced between threads by work stealing (see WorkStealingBlocks),
+ * elements whose cost varies a lot don't leave threads idle. The policy bounds the number of threads;
+ * unless it sets a grain, even a few elements are spread over all of them, a few blocks per thread,
+ * pass a larger grain (parallel_policy{0, 4096}) when each element is cheap.
+ */
+template<class Range, class Function>
+void parallel_for(const parallel_policy& policy, Range&& range, Function&& fn) {
+    const auto first = std::begin(range);
+    using category = typename std::iterator_traits<std::remove_const_t<decltype(first)>>::iterator_category;
+    static_assert(std::is_base_of_v<std::random_access_iterator_tag, category>, "parallel_for needs a random access range");
+
+    const auto size = static_cast<std::size_t>(std::end(range) - first);
+    const std::size_t threads = chunk_count(policy, size, 1);
+    // a few blocks per thread are enough for stealing to even the load out
+    const std::size_t blocks = std::min(size, threads * 8);
+    if( threads <= 1 || blocks == 0 ) {
+        for( auto it = first; it != first + size; ++it ) fn(*it);
+        return;
+    }
+
+    WorkStealingBlocks work(threads, blocks);
+    std::atomic<bool> failed{false};
+    parallel_chunks(threads, threads, [&](std::size_t thread, std::size_t, std::size_t) {
+        std::size_t block;
+        while( !failed.load(std::memory_order_relaxed) && work.next(thread, block) ) {
+            auto it = first + static_cast<std::ptrdiff_t>(block * size / blocks);
+            const auto last = first + static_cast<std::ptrdiff_t>((block + 1) * size / blocks);
+            try {
+                for( ; it != last; ++it ) fn(*it);
+            } catch(...) {
+                failed = true;
+                throw;
+            }
+        }
+    });
+}
+
+
+template<class Range, class Function>
+void parallel_for(Range&& range, Function&& fn) {
+    parallel_for(par, std::forward<Range>(range), std::forward<Function>(fn));
+}
+
+#endif
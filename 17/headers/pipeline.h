@@ -0,0 +1,264 @@
+#ifndef __VIPER_PIPELINE__
+#define __VIPER_PIPELINE__
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "enumerate.h"
+#include "filter_iterator.h"
+#include "iterator_cast.h"
+
+
+/*
+ * Lazy pipelines: chain stages with operator| and nothing is computed until the pipeline is iterated,
+ * every stage just wraps the iterators of the previous one, so the whole chain runs in a single pass.
+ *
+ * For example:
+ * auto even = [](int i) { return i % 2 == 0; };
+ * auto square = [](int i) { return i * i; };
+ *
+ * for( auto&& [index, value] : vi | filter(even) | transform(square) | enumerate() | take(3) ) { ... }
+ *
+ * auto squares = vi | filter(even) | transform(square) | into<std::vector<int>>();   // only materialized here
+ *
+ * A pipeline references an l-value source and takes ownership of an r-value one (moved in),
+ * so pipelines over temporaries don't dangle.
+ */
+
+
+// iterator type of a source, be it a container or a previous stage
+template<class Range>
+using range_iterator_t = decltype(std::begin(std::declval<std::remove_reference_t<Range>&>()));
+
+
+/*
+ * Common part of the stages: the source (a reference or an owned value, see above)
+ * and the typedefs Enumerate's iterator needs from what it walks over.
+ */
+template<class Range, class StageIterator>
+class View {
+
+    protected:
+
+        Range range;
+
+        inline auto source_begin() { return std::begin(range); }
+
+        inline auto source_end() { return std::end(range); }
+
+    public:
+
+        using iterator = StageIterator;
+        using reference = typename std::iterator_traits<StageIterator>::reference;
+        using value_type = typename std::iterator_traits<StageIterator>::value_type;
+        using difference_type = typename std::iterator_traits<StageIterator>::difference_type;
+        using size_type = std::size_t;
+
+        explicit View(Range&& source) : range(std::forward<Range>(source)) {}
+};
+
+
+template<class Range, class Predicate>
+class FilterView : public View<Range, FilterIterator<range_iterator_t<Range>, Predicate>> {
+
+    using base_t = View<Range, FilterIterator<range_iterator_t<Range>, Predicate>>;
+
+    Predicate predicate;
+
+    public:
+
+        using iterator = typename base_t::iterator;
+
+        FilterView(Range&& source, Predicate predicate)
+            : base_t(std::forward<Range>(source)), predicate(std::move(predicate)) {}
+
+        inline iterator begin() { return iterator(this->source_begin(), this->source_end(), predicate); }
+
+        inline iterator end() { return iterator(this->source_end(), this->source_end(), predicate); }
+};
+
+
+template<class Range, class UnaryFunction>
+class TransformView : public View<Range, Iter<range_iterator_t<Range>, UnaryFunction>> {
+
+    using base_t = View<Range, Iter<range_iterator_t<Range>, UnaryFunction>>;
+
+    UnaryFunction convert;
+
+    public:
+
+        using iterator = typename base_t::iterator;
+
+        TransformView(Range&& source, UnaryFunction convert)
+            : base_t(std::forward<Range>(source)), convert(std::move(convert)) {}
+
+        inline iterator begin() { return iterator(this->source_begin(), convert); }
+
+        inline iterator end() { return iterator(this->source_end(), convert); }
+};
+
+
+template<class Range>
+class EnumerateView : public View<Range, typename Enumerate<Range>::template Iterator<range_iterator_t<Range>>> {
+
+    using base_t = View<Range, typename Enumerate<Range>::template Iterator<range_iterator_t<Range>>>;
+
+    public:
+
+        using iterator = typename base_t::iterator;
+
+        explicit EnumerateView(Range&& source) : base_t(std::forward<Range>(source)) {}
+
+        inline iterator begin() { return iterator(0, this->source_begin()); }
+
+        // only the underlying iterators are compared, the index of the end doesn't matter
+        inline iterator end() { return iterator(0, this->source_end()); }
+};
+
+
+/*
+ * Stops after 'count' elements or at the end of the underlying range, whichever comes first.
+ * It doesn't move the underlying iterator past the last element taken,
+ * so a filter upstream won't scan the rest of its input for nothing.
+ */
+template<class Iterator>
+class TakeIterator {
+
+    using traits_t = std::iterator_traits<Iterator>;
+
+    Iterator _iter;
+    std::size_t _count;
+
+    public:
+
+        using difference_type = typename traits_t::difference_type;
+        using value_type = typename traits_t::value_type;
+        using pointer = typename traits_t::pointer;
+        using reference = typename traits_t::reference;
+        using iterator_category = std::conditional_t<
+            std::is_base_of_v<std::forward_iterator_tag, typename traits_t::iterator_category>,
+            std::forward_iterator_tag,
+            typename traits_t::iterator_category
+                >;
+
+        TakeIterator(Iterator iter, std::size_t count) : _iter(std::move(iter)), _count(count) {}
+
+        inline reference operator*() const {
+            return *_iter;
+        }
+
+        inline bool operator==(const TakeIterator& rhs) const {
+            return _count == rhs._count || _iter == rhs._iter;
+        }
+
+        inline bool operator!=(const TakeIterator& rhs) const {
+            return !(*this == rhs);
+        }
+
+        inline TakeIterator& operator++() {
+            if( --_count ) ++_iter;
+            return *this;
+        }
+
+        inline auto operator++(int) {
+            auto iterator{*this};
+            operator++();
+            return iterator;
+        }
+};
+
+
+template<class Range>
+class TakeView : public View<Range, TakeIterator<range_iterator_t<Range>>> {
+
+    using base_t = View<Range, TakeIterator<range_iterator_t<Range>>>;
+
+    std::size_t count;
+
+    public:
+
+        using iterator = typename base_t::iterator;
+
+        TakeView(Range&& source, std::size_t count) : base_t(std::forward<Range>(source)), count(count) {}
+
+        inline iterator begin() { return iterator(this->source_begin(), count); }
+
+        inline iterator end() { return iterator(this->source_end(), 0); }
+};
+
+
+//
+// STAGES: what the right hand side of operator| is made of
+//
+
+template<class Predicate>
+struct FilterStage { Predicate predicate; };
+
+template<class UnaryFunction>
+struct TransformStage { UnaryFunction convert; };
+
+struct EnumerateStage {};
+
+struct TakeStage { std::size_t count; };
+
+template<class Container>
+struct IntoStage {};
+
+
+template<class Predicate>
+inline auto filter(Predicate&& fn) {
+    return FilterStage<std::decay_t<Predicate>>{std::forward<Predicate>(fn)};
+}
+
+template<class UnaryFunction>
+inline auto transform(UnaryFunction&& convert) {
+    return TransformStage<std::decay_t<UnaryFunction>>{std::forward<UnaryFunction>(convert)};
+}
+
+inline auto enumerate() {
+    return EnumerateStage{};
+}
+
+inline auto take(std::size_t count) {
+    return TakeStage{count};
+}
+
+// the only stage that allocates: walks the whole pipeline into a Container
+template<class Container>
+inline auto into() {
+    return IntoStage<Container>{};
+}
+
+
+template<class Range, class Predicate>
+inline auto operator|(Range&& range, FilterStage<Predicate> stage) {
+    return FilterView<Range, Predicate>(std::forward<Range>(range), std::move(stage.predicate));
+}
+
+template<class Range, class UnaryFunction>
+inline auto operator|(Range&& range, TransformStage<UnaryFunction> stage) {
+    return TransformView<Range, UnaryFunction>(std::forward<Range>(range), std::move(stage.convert));
+}
+
+template<class Range>
+inline auto operator|(Range&& range, EnumerateStage) {
+    return EnumerateView<Range>(std::forward<Range>(range));
+}
+
+template<class Range>
+inline auto operator|(Range&& range, TakeStage stage) {
+    return TakeView<Range>(std::forward<Range>(range), stage.count);
+}
+
+template<class Range, class Container>
+inline Container operator|(Range&& range, IntoStage<Container>) {
+    Container out;
+    for( auto&& value : range ) {
+        out.insert(out.end(), std::forward<decltype(value)>(value));
+    }
+    return out;
+}
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef __VIPER_PREDICATES__
+#define __VIPER_PREDICATES__
+
+#include <type_traits>
+
+#include "simd.h"
+
+
+/*
+ * Predicates comparing a value against constants.
+ * They can be called like any other predicate, but since the comparison is known,
+ * filter() and filter_inplace() run them through SIMD kernels over arrays of the same arithmetic type.
+ *
+ * For example:
+ * filter_inplace(gt(0.5f), weights);           // keeps the weights > 0.5f
+ * auto adults = filter(between(18, 65), ages);  // 18 <= age && age <= 65
+ */
+template<class T, simd::compare op>
+struct Comparison {
+
+    using value_type = T;
+    static constexpr simd::compare comparison = op;
+
+    T a, b;
+
+    template<class U>
+    constexpr bool operator()(const U& x) const {
+        return simd::test<op>(x, a, b);
+    }
+};
+
+
+template<class Predicate>
+struct is_comparison : std::false_type {};
+
+template<class T, simd::compare op>
+struct is_comparison<Comparison<T, op>> : std::true_type {};
+
+
+template<class T>
+constexpr auto eq(const T& value) { return Comparison<T, simd::compare::eq>{value, value}; }
+
+template<class T>
+constexpr auto ne(const T& value) { return Comparison<T, simd::compare::ne>{value, value}; }
+
+template<class T>
+constexpr auto lt(const T& value) { return Comparison<T, simd::compare::lt>{value, value}; }
+
+template<class T>
+constexpr auto le(const T& value) { return Comparison<T, simd::compare::le>{value, value}; }
+
+template<class T>
+constexpr auto gt(const T& value) { return Comparison<T, simd::compare::gt>{value, value}; }
+
+template<class T>
+constexpr auto ge(const T& value) { return Comparison<T, simd::compare::ge>{value, value}; }
+
+// both bounds included
+template<class T>
+constexpr auto between(const T& low, const T& high) { return Comparison<T, simd::compare::between>{low, high}; }
+
+#endif
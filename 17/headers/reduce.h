@@ -0,0 +1,161 @@
+#ifndef __VIPER_REDUCE__
+#define __VIPER_REDUCE__
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "grid.h"
+#include "simd.h"
+
+
+/*
+ * sum, min and max of a row or a column of a grid, and dot products of two of them,
+ * with the compile-time views of row<>() and col<>() as well as the runtime ones:
+ *
+ * std::array<float, rows*cols> samples = ...;
+ * auto peak = max(row<2, rows, cols>(samples));
+ * auto energy = dot(image.row(r), image.row(r));
+ *
+ * Rows of contiguous containers of float, double or std::int32_t are reduced with SIMD registers,
+ * and so are the columns of column-major ones (see LAYOUTS in grid.h). Otherwise reducing a single column
+ * can't use them, its elements are a row apart: to reduce all the columns of a grid, reduce its cols() range,
+ * whose adjacent columns are reduced a register at a time down the rows.
+ * Same with its rows(), each into a std::vector:
+ *
+ * std::vector<float> column_sums = sum(image.cols());
+ * std::vector<float> row_maxima = max(image.rows());
+ *
+ * Sums are of the view's value_type, like std::accumulate(first, last, T()) would be;
+ * floating point values are added in a different order than a sequential loop so their rounding can differ slightly.
+ * min and max need at least one element, they give T() otherwise. They are NaN when an element is.
+ * They only take these views (is_line_view) and their rows() and cols(), other calls to min(x) or max(x)
+ * in code that includes Viper don't see them.
+ */
+
+
+// the rows and columns of grid.h, compile-time or runtime, which sum, min, max and dot take
+template<class View>
+struct is_line_view : std::false_type {};
+
+template<class Iterator>
+struct is_line_view<RowView<Iterator>> : std::true_type {};
+
+template<class Iterator>
+struct is_line_view<ColumnView<Iterator>> : std::true_type {};
+
+template<std::size_t row_number, std::size_t rows, std::size_t cols, class SequenceContainer, class Layout>
+struct is_line_view<RowDimension<row_number, rows, cols, SequenceContainer, Layout>> : std::true_type {};
+
+template<std::size_t column_number, std::size_t rows, std::size_t cols, class SequenceContainer, class Layout>
+struct is_line_view<ColumnDimension<column_number, rows, cols, SequenceContainer, Layout>> : std::true_type {};
+
+template<class View>
+constexpr bool is_line_view_v = is_line_view<View>::value;
+
+
+// views whose elements are contiguous in memory, one after the other
+template<class View>
+struct is_contiguous_view : std::false_type {};
+
+template<class T>
+struct is_contiguous_view<RowView<T*>> : std::true_type {};
+
+template<std::size_t row_number, std::size_t rows, std::size_t cols, class SequenceContainer, class Layout>
+struct is_contiguous_view<RowDimension<row_number, rows, cols, SequenceContainer, Layout>>
+    : std::bool_constant<Layout::contiguous_rows && has_data<std::remove_reference_t<SequenceContainer>>::value> {};
+
+template<std::size_t column_number, std::size_t rows, std::size_t cols, class SequenceContainer, class Layout>
+struct is_contiguous_view<ColumnDimension<column_number, rows, cols, SequenceContainer, Layout>>
+    : std::bool_constant<Layout::contiguous_cols && has_data<std::remove_reference_t<SequenceContainer>>::value> {};
+
+
+template<simd::reduction op, class View>
+inline auto reduce_view(const View& view) {
+    using value_type = std::remove_const_t<typename View::value_type>;
+    const std::size_t size = view.size();
+    if( size == 0 ) return value_type();
+    if constexpr( is_contiguous_view<View>::value ) {
+        return simd::reduce<op>(static_cast<const value_type*>(std::addressof(view[0])), size);
+    } else {
+        value_type result = view[0];
+        for( std::size_t i = 1; i < size; ++i ) result = simd::combine<op>(result, static_cast<value_type>(view[i]));
+        return result;
+    }
+}
+
+
+template<simd::reduction op, class Grid, bool columns>
+inline auto reduce_lines(const Lines<Grid, columns>& lines) {
+    using value_type = std::remove_const_t<typename Grid::value_type>;
+    const Grid& grid = lines.grid();
+    std::vector<value_type> results(lines.size());
+    if constexpr( !columns ) {
+        for( std::size_t r = 0; r < grid.height(); ++r ) results[r] = reduce_view<op>(grid.row(r));
+    } else if constexpr( std::is_pointer_v<std::decay_t<decltype(grid.base())>> ) {
+        simd::reduce_columns<op>(static_cast<const value_type*>(grid.base()), grid.stride(), grid.height(), grid.width(), results.data());
+    } else if( grid.height() > 0 ) {
+        // row by row all the same, each element is read once, in the order of the container
+        for( std::size_t c = 0; c < grid.width(); ++c ) results[c] = grid(0, c);
+        for( std::size_t r = 1; r < grid.height(); ++r ) {
+            for( std::size_t c = 0; c < grid.width(); ++c ) results[c] = simd::combine<op>(results[c], static_cast<value_type>(grid(r, c)));
+        }
+    }
+    return results;
+}
+
+
+template<class View, std::enable_if_t<is_line_view_v<View>, int> = 0>
+inline auto sum(const View& view) {
+    return reduce_view<simd::reduction::sum>(view);
+}
+
+
+template<class View, std::enable_if_t<is_line_view_v<View>, int> = 0>
+inline auto min(const View& view) {
+    return reduce_view<simd::reduction::min>(view);
+}
+
+
+template<class View, std::enable_if_t<is_line_view_v<View>, int> = 0>
+inline auto max(const View& view) {
+    return reduce_view<simd::reduction::max>(view);
+}
+
+
+template<class Grid, bool columns>
+inline auto sum(const Lines<Grid, columns>& lines) {
+    return reduce_lines<simd::reduction::sum>(lines);
+}
+
+
+template<class Grid, bool columns>
+inline auto min(const Lines<Grid, columns>& lines) {
+    return reduce_lines<simd::reduction::min>(lines);
+}
+
+
+template<class Grid, bool columns>
+inline auto max(const Lines<Grid, columns>& lines) {
+    return reduce_lines<simd::reduction::max>(lines);
+}
+
+
+// the sum of the products of the elements of two views of the same size
+template<class ViewA, class ViewB, std::enable_if_t<is_line_view_v<ViewA> && is_line_view_v<ViewB>, int> = 0>
+inline auto dot(const ViewA& a, const ViewB& b) {
+    using value_type = std::remove_const_t<typename ViewA::value_type>;
+    const std::size_t size = a.size();
+    if( size == 0 ) return value_type();
+    if constexpr( is_contiguous_view<ViewA>::value && is_contiguous_view<ViewB>::value
+               && std::is_same_v<value_type, std::remove_const_t<typename ViewB::value_type>> ) {
+        return simd::dot(static_cast<const value_type*>(std::addressof(a[0])), static_cast<const value_type*>(std::addressof(b[0])), size);
+    } else {
+        value_type result = value_type();
+        for( std::size_t i = 0; i < size; ++i ) result += a[i] * b[i];
+        return result;
+    }
+}
+
+#endif
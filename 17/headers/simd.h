@@ -0,0 +1,823 @@
+#ifndef __VIPER_SIMD__
+#define __VIPER_SIMD__
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+/*
+ * SIMD kernels shared by the other headers.
+ *
+ * Viper is header-only, so we can't ask for -mavx2: the kernels are compiled with a per-function
+ * target attribute and picked at runtime from the CPU features, falling back to plain scalar code.
+ * Define VIPER_NO_SIMD to always use the scalar code.
+ */
+#if !defined(VIPER_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define VIPER_X86_SIMD 1
+#include <immintrin.h>
+#define VIPER_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+
+namespace simd {
+
+// ordered, each level implies the ones before it
+enum class level { scalar, sse42, avx2, avx512 };
+
+
+inline level detect() noexcept {
+#ifdef VIPER_X86_SIMD
+    __builtin_cpu_init();
+    if( __builtin_cpu_supports("avx512f") ) return level::avx512;
+    if( __builtin_cpu_supports("avx2") ) return level::avx2;
+    if( __builtin_cpu_supports("sse4.2") ) return level::sse42;
+#endif
+    return level::scalar;
+}
+
+
+// the CPU won't change while we're running, ask once
+inline level supported() noexcept {
+    static const level cpu = detect();
+    return cpu;
+}
+
+
+// the types our kernels can compare a whole register of at once
+template<class T>
+constexpr bool is_vectorizable_v = std::is_arithmetic_v<T>
+                                && !std::is_same_v<T, bool>
+                                && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+
+
+#ifdef VIPER_X86_SIMD
+
+template<class T>
+VIPER_TARGET("sse4.2") inline __m128i broadcast_sse42(const T value) {
+    if constexpr( std::is_same_v<T, float> ) return _mm_castps_si128(_mm_set1_ps(value));
+    else if constexpr( std::is_same_v<T, double> ) return _mm_castpd_si128(_mm_set1_pd(value));
+    else if constexpr( sizeof(T) == 1 ) return _mm_set1_epi8(static_cast<char>(value));
+    else if constexpr( sizeof(T) == 2 ) return _mm_set1_epi16(static_cast<short>(value));
+    else if constexpr( sizeof(T) == 4 ) return _mm_set1_epi32(static_cast<int>(value));
+    else return _mm_set1_epi64x(static_cast<long long>(value));
+}
+
+
+// all ones in the lanes of [p, p+16 bytes) equal to the needle
+template<class T>
+VIPER_TARGET("sse4.2") inline __m128i equal_sse42(const T* p, const __m128i needle) {
+    if constexpr( std::is_same_v<T, float> ) {
+        return _mm_castps_si128(_mm_cmpeq_ps(_mm_loadu_ps(p), _mm_castsi128_ps(needle)));
+    } else if constexpr( std::is_same_v<T, double> ) {
+        return _mm_castpd_si128(_mm_cmpeq_pd(_mm_loadu_pd(p), _mm_castsi128_pd(needle)));
+    } else {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        if constexpr( sizeof(T) == 1 ) return _mm_cmpeq_epi8(block, needle);
+        else if constexpr( sizeof(T) == 2 ) return _mm_cmpeq_epi16(block, needle);
+        else if constexpr( sizeof(T) == 4 ) return _mm_cmpeq_epi32(block, needle);
+        else return _mm_cmpeq_epi64(block, needle);
+    }
+}
+
+
+template<class T>
+VIPER_TARGET("sse4.2") const T* find_sse42(const T* first, const T* last, const T value) {
+    constexpr std::ptrdiff_t lanes = 16 / sizeof(T);
+    const __m128i needle = broadcast_sse42(value);
+    for( ; last - first >= 4*lanes; first += 4*lanes ) {
+        const __m128i m0 = equal_sse42(first, needle);
+        const __m128i m1 = equal_sse42(first + lanes, needle);
+        const __m128i m2 = equal_sse42(first + 2*lanes, needle);
+        const __m128i m3 = equal_sse42(first + 3*lanes, needle);
+        if( _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(m0, m1), _mm_or_si128(m2, m3))) ) break;
+    }
+    for( ; last - first >= lanes; first += lanes ) {
+        const unsigned mask = _mm_movemask_epi8(equal_sse42(first, needle));
+        if( mask ) return first + __builtin_ctz(mask) / sizeof(T);
+    }
+    return std::find(first, last, value);
+}
+
+
+template<class T>
+VIPER_TARGET("avx2") inline __m256i broadcast_avx2(const T value) {
+    if constexpr( std::is_same_v<T, float> ) return _mm256_castps_si256(_mm256_set1_ps(value));
+    else if constexpr( std::is_same_v<T, double> ) return _mm256_castpd_si256(_mm256_set1_pd(value));
+    else if constexpr( sizeof(T) == 1 ) return _mm256_set1_epi8(static_cast<char>(value));
+    else if constexpr( sizeof(T) == 2 ) return _mm256_set1_epi16(static_cast<short>(value));
+    else if constexpr( sizeof(T) == 4 ) return _mm256_set1_epi32(static_cast<int>(value));
+    else return _mm256_set1_epi64x(static_cast<long long>(value));
+}
+
+
+// all ones in the lanes of [p, p+32 bytes) equal to the needle
+template<class T>
+VIPER_TARGET("avx2") inline __m256i equal_avx2(const T* p, const __m256i needle) {
+    if constexpr( std::is_same_v<T, float> ) {
+        return _mm256_castps_si256(_mm256_cmp_ps(_mm256_loadu_ps(p), _mm256_castsi256_ps(needle), _CMP_EQ_OQ));
+    } else if constexpr( std::is_same_v<T, double> ) {
+        return _mm256_castpd_si256(_mm256_cmp_pd(_mm256_loadu_pd(p), _mm256_castsi256_pd(needle), _CMP_EQ_OQ));
+    } else {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        if constexpr( sizeof(T) == 1 ) return _mm256_cmpeq_epi8(block, needle);
+        else if constexpr( sizeof(T) == 2 ) return _mm256_cmpeq_epi16(block, needle);
+        else if constexpr( sizeof(T) == 4 ) return _mm256_cmpeq_epi32(block, needle);
+        else return _mm256_cmpeq_epi64(block, needle);
+    }
+}
+
+
+template<class T>
+VIPER_TARGET("avx2") const T* find_avx2(const T* first, const T* last, const T value) {
+    constexpr std::ptrdiff_t lanes = 32 / sizeof(T);
+    const __m256i needle = broadcast_avx2(value);
+    // 4 registers per step to keep the load ports busy, then narrow down on the block with the hit
+    for( ; last - first >= 4*lanes; first += 4*lanes ) {
+        const __m256i m0 = equal_avx2(first, needle);
+        const __m256i m1 = equal_avx2(first + lanes, needle);
+        const __m256i m2 = equal_avx2(first + 2*lanes, needle);
+        const __m256i m3 = equal_avx2(first + 3*lanes, needle);
+        const __m256i any = _mm256_or_si256(_mm256_or_si256(m0, m1), _mm256_or_si256(m2, m3));
+        if( !_mm256_testz_si256(any, any) ) break;
+    }
+    for( ; last - first >= lanes; first += lanes ) {
+        const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(equal_avx2(first, needle)));
+        if( mask ) return first + __builtin_ctz(mask) / sizeof(T);
+    }
+    return std::find(first, last, value);
+}
+
+#endif
+
+
+/*
+ * Same as std::find(first, last, value) over a contiguous array of arithmetic values,
+ * comparing a whole register of values per instruction when the CPU supports it.
+ */
+template<class T>
+inline const T* find(const T* first, const T* last, const T value) {
+    static_assert(is_vectorizable_v<T>, "simd::find only compares arithmetic values");
+#ifdef VIPER_X86_SIMD
+    const level cpu = supported();
+    if( cpu >= level::avx2 ) return find_avx2(first, last, value);
+    if( cpu >= level::sse42 ) return find_sse42(first, last, value);
+#endif
+    return std::find(first, last, value);
+}
+
+
+/*
+ * Stream compaction: copies the values of [first, last) passing the comparison to 'out', keeping their order,
+ * and returns the end of the output. 'out' may be 'first', the values are then compacted in place,
+ * otherwise it must have room for last-first values: whole registers are stored, not just the values kept.
+ *
+ * Comparisons are the ones of 'Comparison' (predicates.h), 'between' includes both bounds.
+ */
+enum class compare { eq, ne, lt, le, gt, ge, between };
+
+
+template<compare op, class T, class U>
+constexpr bool test(const T& x, const U& a, const U& b) {
+    if constexpr( op == compare::eq ) return x == a;
+    else if constexpr( op == compare::ne ) return x != a;
+    else if constexpr( op == compare::lt ) return x < a;
+    else if constexpr( op == compare::le ) return x <= a;
+    else if constexpr( op == compare::gt ) return x > a;
+    else if constexpr( op == compare::ge ) return x >= a;
+    else return a <= x && x <= b;
+}
+
+
+// branchless: every value is written, the output only moves forward when it passes
+template<compare op, class T>
+inline T* compact_scalar(const T* first, const T* last, T* out, const T a, const T b) {
+    for( ; first != last; ++first ) {
+        const T value = *first;
+        *out = value;
+        out += test<op>(value, a, b);
+    }
+    return out;
+}
+
+
+// lane indices moving the selected 32 bit lanes of a 256 bit register to the front, per 8 bit mask
+constexpr std::array<std::array<std::uint32_t, 8>, 256> make_compaction_table_32() {
+    std::array<std::array<std::uint32_t, 8>, 256> table{};
+    for( std::size_t mask = 0; mask < 256; ++mask ) {
+        std::size_t k = 0;
+        for( std::uint32_t lane = 0; lane < 8; ++lane ) {
+            if( mask & (std::size_t(1) << lane) ) table[mask][k++] = lane;
+        }
+    }
+    return table;
+}
+
+
+// same for 64 bit lanes, as pairs of 32 bit lanes, per 4 bit mask
+constexpr std::array<std::array<std::uint32_t, 8>, 16> make_compaction_table_64() {
+    std::array<std::array<std::uint32_t, 8>, 16> table{};
+    for( std::size_t mask = 0; mask < 16; ++mask ) {
+        std::size_t k = 0;
+        for( std::uint32_t lane = 0; lane < 4; ++lane ) {
+            if( mask & (std::size_t(1) << lane) ) {
+                table[mask][k++] = 2*lane;
+                table[mask][k++] = 2*lane + 1;
+            }
+        }
+    }
+    return table;
+}
+
+inline constexpr auto compaction_table_32 = make_compaction_table_32();
+
+inline constexpr auto compaction_table_64 = make_compaction_table_64();
+
+
+#ifdef VIPER_X86_SIMD
+
+template<class T, int predicate>
+VIPER_TARGET("avx2") inline __m256i compare_float_avx2(const __m256i x, const __m256i y) {
+    if constexpr( std::is_same_v<T, float> ) return _mm256_castps_si256(_mm256_cmp_ps(_mm256_castsi256_ps(x), _mm256_castsi256_ps(y), predicate));
+    else return _mm256_castpd_si256(_mm256_cmp_pd(_mm256_castsi256_pd(x), _mm256_castsi256_pd(y), predicate));
+}
+
+
+template<class T>
+VIPER_TARGET("avx2") inline __m256i greater_avx2(__m256i x, __m256i y) {
+    if constexpr( std::is_unsigned_v<T> ) {
+        // no unsigned comparison in AVX2: flip the sign bits and compare signed
+        const __m256i sign = sizeof(T) == 8 ? _mm256_set1_epi64x(static_cast<long long>(1ull << 63)) : _mm256_set1_epi32(static_cast<int>(1u << 31));
+        x = _mm256_xor_si256(x, sign);
+        y = _mm256_xor_si256(y, sign);
+    }
+    if constexpr( sizeof(T) == 8 ) return _mm256_cmpgt_epi64(x, y); else return _mm256_cmpgt_epi32(x, y);
+}
+
+
+template<class T>
+VIPER_TARGET("avx2") inline __m256i equal_lanes_avx2(const __m256i x, const __m256i y) {
+    if constexpr( sizeof(T) == 8 ) return _mm256_cmpeq_epi64(x, y); else return _mm256_cmpeq_epi32(x, y);
+}
+
+
+// all ones in the 32 or 64 bit lanes of 'values' passing the comparison
+template<compare op, class T>
+VIPER_TARGET("avx2") inline __m256i test_avx2(const __m256i values, const __m256i a, const __m256i b) {
+    if constexpr( std::is_floating_point_v<T> ) {
+        // ordered comparisons are false for NaN, like the scalar operators, != is the unordered one
+        if constexpr( op == compare::eq ) return compare_float_avx2<T, _CMP_EQ_OQ>(values, a);
+        else if constexpr( op == compare::ne ) return compare_float_avx2<T, _CMP_NEQ_UQ>(values, a);
+        else if constexpr( op == compare::lt ) return compare_float_avx2<T, _CMP_LT_OQ>(values, a);
+        else if constexpr( op == compare::le ) return compare_float_avx2<T, _CMP_LE_OQ>(values, a);
+        else if constexpr( op == compare::gt ) return compare_float_avx2<T, _CMP_GT_OQ>(values, a);
+        else if constexpr( op == compare::ge ) return compare_float_avx2<T, _CMP_GE_OQ>(values, a);
+        else return _mm256_and_si256(compare_float_avx2<T, _CMP_GE_OQ>(values, a), compare_float_avx2<T, _CMP_LE_OQ>(values, b));
+    } else {
+        const __m256i ones = _mm256_set1_epi32(-1);
+        if constexpr( op == compare::eq ) return equal_lanes_avx2<T>(values, a);
+        else if constexpr( op == compare::ne ) return _mm256_xor_si256(equal_lanes_avx2<T>(values, a), ones);
+        else if constexpr( op == compare::lt ) return greater_avx2<T>(a, values);
+        else if constexpr( op == compare::le ) return _mm256_xor_si256(greater_avx2<T>(values, a), ones);
+        else if constexpr( op == compare::gt ) return greater_avx2<T>(values, a);
+        else if constexpr( op == compare::ge ) return _mm256_xor_si256(greater_avx2<T>(a, values), ones);
+        else return _mm256_xor_si256(_mm256_or_si256(greater_avx2<T>(a, values), greater_avx2<T>(values, b)), ones);
+    }
+}
+
+
+template<compare op, class T>
+VIPER_TARGET("avx2,popcnt") T* compact_avx2(const T* first, const T* last, T* out, const T a, const T b) {
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8, "AVX2 compaction works on 32 or 64 bit lanes");
+    constexpr std::ptrdiff_t lanes = 32 / sizeof(T);
+    const __m256i va = broadcast_avx2(a);
+    const __m256i vb = broadcast_avx2(b);
+    for( ; last - first >= lanes; first += lanes ) {
+        // the whole block is loaded before anything is stored, and out <= first, so compacting in place is safe
+        const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+        const __m256i selected = test_avx2<op, T>(values, va, vb);
+        unsigned mask;
+        const std::uint32_t* permutation;
+        if constexpr( sizeof(T) == 4 ) {
+            mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(selected)));
+            permutation = compaction_table_32[mask].data();
+        } else {
+            mask = static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(selected)));
+            permutation = compaction_table_64[mask].data();
+        }
+        const __m256i shuffle = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(permutation));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_permutevar8x32_epi32(values, shuffle));
+        out += __builtin_popcount(mask);
+    }
+    return compact_scalar<op>(first, last, out, a, b);
+}
+
+
+template<class T>
+VIPER_TARGET("avx512f") inline __m512i broadcast_avx512(const T value) {
+    if constexpr( std::is_same_v<T, float> ) return _mm512_castps_si512(_mm512_set1_ps(value));
+    else if constexpr( std::is_same_v<T, double> ) return _mm512_castpd_si512(_mm512_set1_pd(value));
+    else if constexpr( sizeof(T) == 4 ) return _mm512_set1_epi32(static_cast<int>(value));
+    else return _mm512_set1_epi64(static_cast<long long>(value));
+}
+
+
+// AVX-512 compares straight into a mask register, signed, unsigned or floating point
+template<class T, int predicate>
+VIPER_TARGET("avx512f") inline unsigned compare_avx512(const __m512i x, const __m512i y) {
+    if constexpr( std::is_same_v<T, float> ) return _mm512_cmp_ps_mask(_mm512_castsi512_ps(x), _mm512_castsi512_ps(y), predicate);
+    else if constexpr( std::is_same_v<T, double> ) return _mm512_cmp_pd_mask(_mm512_castsi512_pd(x), _mm512_castsi512_pd(y), predicate);
+    else if constexpr( sizeof(T) == 4 && std::is_signed_v<T> ) return _mm512_cmp_epi32_mask(x, y, predicate);
+    else if constexpr( sizeof(T) == 4 ) return _mm512_cmp_epu32_mask(x, y, predicate);
+    else if constexpr( std::is_signed_v<T> ) return _mm512_cmp_epi64_mask(x, y, predicate);
+    else return _mm512_cmp_epu64_mask(x, y, predicate);
+}
+
+
+// one bit per 32 or 64 bit lane of 'values' passing the comparison
+template<compare op, class T>
+VIPER_TARGET("avx512f") inline unsigned test_avx512(const __m512i values, const __m512i a, const __m512i b) {
+    if constexpr( std::is_floating_point_v<T> ) {
+        if constexpr( op == compare::eq ) return compare_avx512<T, _CMP_EQ_OQ>(values, a);
+        else if constexpr( op == compare::ne ) return compare_avx512<T, _CMP_NEQ_UQ>(values, a);
+        else if constexpr( op == compare::lt ) return compare_avx512<T, _CMP_LT_OQ>(values, a);
+        else if constexpr( op == compare::le ) return compare_avx512<T, _CMP_LE_OQ>(values, a);
+        else if constexpr( op == compare::gt ) return compare_avx512<T, _CMP_GT_OQ>(values, a);
+        else if constexpr( op == compare::ge ) return compare_avx512<T, _CMP_GE_OQ>(values, a);
+        else return compare_avx512<T, _CMP_GE_OQ>(values, a) & compare_avx512<T, _CMP_LE_OQ>(values, b);
+    } else {
+        if constexpr( op == compare::eq ) return compare_avx512<T, _MM_CMPINT_EQ>(values, a);
+        else if constexpr( op == compare::ne ) return compare_avx512<T, _MM_CMPINT_NE>(values, a);
+        else if constexpr( op == compare::lt ) return compare_avx512<T, _MM_CMPINT_LT>(values, a);
+        else if constexpr( op == compare::le ) return compare_avx512<T, _MM_CMPINT_LE>(values, a);
+        else if constexpr( op == compare::gt ) return compare_avx512<T, _MM_CMPINT_NLE>(values, a);
+        else if constexpr( op == compare::ge ) return compare_avx512<T, _MM_CMPINT_NLT>(values, a);
+        else return compare_avx512<T, _MM_CMPINT_NLT>(values, a) & compare_avx512<T, _MM_CMPINT_LE>(values, b);
+    }
+}
+
+
+/*
+ * The compress instruction packs the selected lanes in a register, no table needed.
+ * It is stored with a plain full width store rather than a compress-store to memory,
+ * which is microcoded and much slower on some CPUs, hence the same room requirement on 'out' as AVX2.
+ */
+template<compare op, class T>
+VIPER_TARGET("avx512f,popcnt") T* compact_avx512(const T* first, const T* last, T* out, const T a, const T b) {
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8, "AVX-512 compaction works on 32 or 64 bit lanes");
+    constexpr std::ptrdiff_t lanes = 64 / sizeof(T);
+    const __m512i va = broadcast_avx512(a);
+    const __m512i vb = broadcast_avx512(b);
+    for( ; last - first >= lanes; first += lanes ) {
+        const __m512i values = _mm512_loadu_si512(first);
+        const unsigned mask = test_avx512<op, T>(values, va, vb);
+        __m512i packed;
+        if constexpr( sizeof(T) == 4 ) packed = _mm512_maskz_compress_epi32(static_cast<__mmask16>(mask), values);
+        else packed = _mm512_maskz_compress_epi64(static_cast<__mmask8>(mask), values);
+        _mm512_storeu_si512(out, packed);
+        out += __builtin_popcount(mask);
+    }
+    return compact_scalar<op>(first, last, out, a, b);
+}
+
+#endif
+
+
+template<compare op, class T>
+inline T* compact(const T* first, const T* last, T* out, const T a, const T b = T()) {
+    static_assert(is_vectorizable_v<T>, "simd::compact only compares arithmetic values");
+#ifdef VIPER_X86_SIMD
+    if constexpr( sizeof(T) == 4 || sizeof(T) == 8 ) {
+        const level cpu = supported();
+        if( cpu >= level::avx512 ) return compact_avx512<op>(first, last, out, a, b);
+        if( cpu >= level::avx2 ) return compact_avx2<op>(first, last, out, a, b);
+    }
+#endif
+    return compact_scalar<op>(first, last, out, a, b);
+}
+
+
+/*
+ * Transposition of small blocks: out(c, r) = in(r, c) for the 'rows' x 'cols' block at 'in',
+ * both blocks row-major, their rows 'in_stride' and 'out_stride' elements apart.
+ * Square tiles of 8x8 (32-bit) or 4x4 (64-bit) elements are transposed in registers,
+ * 4x4 with SSE for 32-bit values, the edges element by element.
+ *
+ * A kernel's block() loads its whole tile before it stores anything, so in and out may be the same tile.
+ */
+template<class T>
+struct TransposeScalar {
+    static constexpr std::size_t size = 1;
+
+    static inline void block(const T* in, std::size_t, T* out, std::size_t) { *out = *in; }
+};
+
+
+#ifdef VIPER_X86_SIMD
+
+template<class T>
+struct TransposeSSE42 {
+    static_assert(sizeof(T) == 4, "the SSE kernel transposes 32-bit values");
+    static constexpr std::size_t size = 4;
+
+    VIPER_TARGET("sse4.2") static void block(const T* in, std::size_t in_stride, T* out, std::size_t out_stride) {
+        const float* i = reinterpret_cast<const float*>(in);
+        float* o = reinterpret_cast<float*>(out);
+        __m128 r0 = _mm_loadu_ps(i), r1 = _mm_loadu_ps(i + in_stride),
+               r2 = _mm_loadu_ps(i + 2*in_stride), r3 = _mm_loadu_ps(i + 3*in_stride);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _mm_storeu_ps(o, r0);
+        _mm_storeu_ps(o + out_stride, r1);
+        _mm_storeu_ps(o + 2*out_stride, r2);
+        _mm_storeu_ps(o + 3*out_stride, r3);
+    }
+};
+
+
+template<class T>
+struct TransposeAVX2 {
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8, "the AVX2 kernel transposes 32-bit and 64-bit values");
+    static constexpr std::size_t size = 32 / sizeof(T);
+
+    VIPER_TARGET("avx2") static void block(const T* in, std::size_t in_stride, T* out, std::size_t out_stride) {
+        if constexpr( sizeof(T) == 4 ) {
+            const float* i = reinterpret_cast<const float*>(in);
+            float* o = reinterpret_cast<float*>(out);
+            __m256 r[8], t[8];
+            for( std::size_t k = 0; k < 8; ++k ) r[k] = _mm256_loadu_ps(i + k*in_stride);
+            // interleave pairs of rows, then pairs of pairs: each 128-bit lane holds a 4x4 transposed quarter
+            for( std::size_t k = 0; k < 8; k += 2 ) {
+                t[k] = _mm256_unpacklo_ps(r[k], r[k+1]);
+                t[k+1] = _mm256_unpackhi_ps(r[k], r[k+1]);
+            }
+            for( std::size_t k = 0; k < 8; k += 4 ) {
+                r[k] = _mm256_shuffle_ps(t[k], t[k+2], _MM_SHUFFLE(1, 0, 1, 0));
+                r[k+1] = _mm256_shuffle_ps(t[k], t[k+2], _MM_SHUFFLE(3, 2, 3, 2));
+                r[k+2] = _mm256_shuffle_ps(t[k+1], t[k+3], _MM_SHUFFLE(1, 0, 1, 0));
+                r[k+3] = _mm256_shuffle_ps(t[k+1], t[k+3], _MM_SHUFFLE(3, 2, 3, 2));
+            }
+            // and swap the off-diagonal quarters
+            for( std::size_t k = 0; k < 4; ++k ) {
+                _mm256_storeu_ps(o + k*out_stride, _mm256_permute2f128_ps(r[k], r[k+4], 0x20));
+                _mm256_storeu_ps(o + (k+4)*out_stride, _mm256_permute2f128_ps(r[k], r[k+4], 0x31));
+            }
+        } else {
+            const double* i = reinterpret_cast<const double*>(in);
+            double* o = reinterpret_cast<double*>(out);
+            const __m256d r0 = _mm256_loadu_pd(i), r1 = _mm256_loadu_pd(i + in_stride),
+                          r2 = _mm256_loadu_pd(i + 2*in_stride), r3 = _mm256_loadu_pd(i + 3*in_stride);
+            const __m256d t0 = _mm256_unpacklo_pd(r0, r1), t1 = _mm256_unpackhi_pd(r0, r1),
+                          t2 = _mm256_unpacklo_pd(r2, r3), t3 = _mm256_unpackhi_pd(r2, r3);
+            _mm256_storeu_pd(o, _mm256_permute2f128_pd(t0, t2, 0x20));
+            _mm256_storeu_pd(o + out_stride, _mm256_permute2f128_pd(t1, t3, 0x20));
+            _mm256_storeu_pd(o + 2*out_stride, _mm256_permute2f128_pd(t0, t2, 0x31));
+            _mm256_storeu_pd(o + 3*out_stride, _mm256_permute2f128_pd(t1, t3, 0x31));
+        }
+    }
+};
+
+#endif
+
+
+template<class T>
+inline void transpose_scalar(const T* in, std::size_t in_stride, T* out, std::size_t out_stride, std::size_t rows, std::size_t cols) {
+    for( std::size_t r = 0; r < rows; ++r ) {
+        for( std::size_t c = 0; c < cols; ++c ) out[c*out_stride + r] = in[r*in_stride + c];
+    }
+}
+
+
+template<class Kernel, class T>
+inline void transpose_blocks(const T* in, std::size_t in_stride, T* out, std::size_t out_stride, std::size_t rows, std::size_t cols) {
+    constexpr std::size_t k = Kernel::size;
+    const std::size_t full_rows = rows / k * k, full_cols = cols / k * k;
+    for( std::size_t r = 0; r < full_rows; r += k ) {
+        for( std::size_t c = 0; c < full_cols; c += k ) Kernel::block(in + r*in_stride + c, in_stride, out + c*out_stride + r, out_stride);
+    }
+    // right and bottom edges
+    transpose_scalar(in + full_cols, in_stride, out + full_cols*out_stride, out_stride, rows, cols - full_cols);
+    transpose_scalar(in + full_rows*in_stride, in_stride, out + full_rows, out_stride, rows - full_rows, full_cols);
+}
+
+
+/*
+ * Exchanges the 'rows' x 'cols' block at 'a' with the transpose of the 'cols' x 'rows' block at 'b':
+ * the two mirror blocks across the diagonal of a square grid. Each tile of 'a' goes through a buffer,
+ * the mirror tile of 'b' is transposed in its place, then the buffer is copied in the place of the tile of 'b'.
+ */
+template<class Kernel, class T>
+inline void transpose_swap_blocks(T* a, T* b, std::size_t stride, std::size_t rows, std::size_t cols) {
+    constexpr std::size_t k = Kernel::size;
+    const std::size_t full_rows = rows / k * k, full_cols = cols / k * k;
+    std::array<T, k*k> buffer;
+    for( std::size_t r = 0; r < full_rows; r += k ) {
+        for( std::size_t c = 0; c < full_cols; c += k ) {
+            T* tile_a = a + r*stride + c;
+            T* tile_b = b + c*stride + r;
+            Kernel::block(tile_a, stride, buffer.data(), k);
+            Kernel::block(tile_b, stride, tile_a, stride);
+            for( std::size_t i = 0; i < k; ++i ) std::copy_n(buffer.data() + i*k, k, tile_b + i*stride);
+        }
+    }
+    for( std::size_t r = 0; r < rows; ++r ) {
+        for( std::size_t c = r < full_rows ? full_cols : 0; c < cols; ++c ) std::swap(a[r*stride + c], b[c*stride + r]);
+    }
+}
+
+
+// transposes the 'size' x 'size' block at 'p' in place
+template<class Kernel, class T>
+inline void transpose_inplace_blocks(T* p, std::size_t stride, std::size_t size) {
+    constexpr std::size_t k = Kernel::size;
+    const std::size_t full = size / k * k;
+    for( std::size_t d = 0; d < full; d += k ) {
+        Kernel::block(p + d*stride + d, stride, p + d*stride + d, stride);
+        // the tiles right of the diagonal with their mirrors below it
+        transpose_swap_blocks<Kernel>(p + d*stride + d + k, p + (d + k)*stride + d, stride, k, full - d - k);
+    }
+    for( std::size_t r = 0; r < size; ++r ) {
+        for( std::size_t c = std::max(r + 1, full); c < size; ++c ) std::swap(p[r*stride + c], p[c*stride + r]);
+    }
+}
+
+
+// the widest kernel for T on this CPU, handed to 'fn' as a type tag
+template<class T, class Function>
+inline void with_transpose_kernel(Function&& fn) {
+#ifdef VIPER_X86_SIMD
+    if constexpr( is_vectorizable_v<T> && (sizeof(T) == 4 || sizeof(T) == 8) ) {
+        const level cpu = supported();
+        if( cpu >= level::avx2 ) return fn(TransposeAVX2<T>());
+        if constexpr( sizeof(T) == 4 ) {
+            if( cpu >= level::sse42 ) return fn(TransposeSSE42<T>());
+        }
+    }
+#endif
+    fn(TransposeScalar<T>());
+}
+
+
+template<class T>
+inline void transpose(const T* in, std::size_t in_stride, T* out, std::size_t out_stride, std::size_t rows, std::size_t cols) {
+    with_transpose_kernel<T>([&](auto kernel) {
+        transpose_blocks<decltype(kernel)>(in, in_stride, out, out_stride, rows, cols);
+    });
+}
+
+
+template<class T>
+inline void transpose_swap(T* a, T* b, std::size_t stride, std::size_t rows, std::size_t cols) {
+    with_transpose_kernel<T>([&](auto kernel) {
+        transpose_swap_blocks<decltype(kernel)>(a, b, stride, rows, cols);
+    });
+}
+
+
+template<class T>
+inline void transpose_inplace(T* p, std::size_t stride, std::size_t size) {
+    with_transpose_kernel<T>([&](auto kernel) {
+        transpose_inplace_blocks<decltype(kernel)>(p, stride, size);
+    });
+}
+
+/*
+ * Reductions (sum, min, max) and dot products of contiguous values, and reductions of every column
+ * of a row-major block at once, a register of adjacent columns at a time down the rows.
+ * min and max need at least one value, and are NaN when one of the values is, whatever their number
+ * and the path they take. Floating point values are summed in a different order
+ * than a sequential loop would, so the rounding of the result can differ slightly.
+ */
+enum class reduction { sum, min, max };
+
+
+// b != b only for NaN, so it sticks once met; for integers the compiler drops the test
+template<reduction op, class T>
+inline T combine(const T a, const T b) {
+    if constexpr( op == reduction::sum ) return a + b;
+    else if constexpr( op == reduction::min ) return b < a || b != b ? b : a;
+    else return a < b || b != b ? b : a;
+}
+
+
+template<reduction op, class T>
+inline T reduce_scalar(const T* p, std::size_t size) {
+    if( size == 0 ) return T();
+    T result = p[0];
+    for( std::size_t i = 1; i < size; ++i ) result = combine<op>(result, p[i]);
+    return result;
+}
+
+
+template<class T>
+inline T dot_scalar(const T* a, const T* b, std::size_t size) {
+    T result = T();
+    for( std::size_t i = 0; i < size; ++i ) result += a[i] * b[i];
+    return result;
+}
+
+
+// the columns of the 'rows' x 'cols' block at 'p' into out[0, cols), sweeping the block row by row
+template<reduction op, class T>
+inline void reduce_columns_scalar(const T* p, std::size_t stride, std::size_t rows, std::size_t cols, T* out) {
+    if( rows == 0 ) {
+        std::fill_n(out, cols, T());
+        return;
+    }
+    std::copy_n(p, cols, out);
+    for( std::size_t r = 1; r < rows; ++r ) {
+        for( std::size_t c = 0; c < cols; ++c ) out[c] = combine<op>(out[c], p[r*stride + c]);
+    }
+}
+
+
+// the types the reduction kernels have registers of
+template<class T>
+constexpr bool is_reducible_v = std::is_same_v<T, float> || std::is_same_v<T, double> || std::is_same_v<T, std::int32_t>;
+
+
+#ifdef VIPER_X86_SIMD
+
+// a register of T, with the operations the reductions need
+template<class T>
+struct VectorAVX2;
+
+template<>
+struct VectorAVX2<float> {
+    using type = __m256;
+    static constexpr std::size_t size = 8;
+    VIPER_TARGET("avx2") static type load(const float* p) { return _mm256_loadu_ps(p); }
+    VIPER_TARGET("avx2") static void store(float* p, type v) { _mm256_storeu_ps(p, v); }
+    VIPER_TARGET("avx2") static type zero() { return _mm256_setzero_ps(); }
+    VIPER_TARGET("avx2") static type add(type a, type b) { return _mm256_add_ps(a, b); }
+    VIPER_TARGET("avx2") static type mul(type a, type b) { return _mm256_mul_ps(a, b); }
+    // vminps and vmaxps give b when either is NaN, a NaN in a is put back so that it propagates like combine()'s
+    VIPER_TARGET("avx2") static type min(type a, type b) { return _mm256_blendv_ps(_mm256_min_ps(a, b), a, _mm256_cmp_ps(a, a, _CMP_UNORD_Q)); }
+    VIPER_TARGET("avx2") static type max(type a, type b) { return _mm256_blendv_ps(_mm256_max_ps(a, b), a, _mm256_cmp_ps(a, a, _CMP_UNORD_Q)); }
+};
+
+template<>
+struct VectorAVX2<double> {
+    using type = __m256d;
+    static constexpr std::size_t size = 4;
+    VIPER_TARGET("avx2") static type load(const double* p) { return _mm256_loadu_pd(p); }
+    VIPER_TARGET("avx2") static void store(double* p, type v) { _mm256_storeu_pd(p, v); }
+    VIPER_TARGET("avx2") static type zero() { return _mm256_setzero_pd(); }
+    VIPER_TARGET("avx2") static type add(type a, type b) { return _mm256_add_pd(a, b); }
+    VIPER_TARGET("avx2") static type mul(type a, type b) { return _mm256_mul_pd(a, b); }
+    // vminpd and vmaxpd give b when either is NaN, a NaN in a is put back so that it propagates like combine()'s
+    VIPER_TARGET("avx2") static type min(type a, type b) { return _mm256_blendv_pd(_mm256_min_pd(a, b), a, _mm256_cmp_pd(a, a, _CMP_UNORD_Q)); }
+    VIPER_TARGET("avx2") static type max(type a, type b) { return _mm256_blendv_pd(_mm256_max_pd(a, b), a, _mm256_cmp_pd(a, a, _CMP_UNORD_Q)); }
+};
+
+template<>
+struct VectorAVX2<std::int32_t> {
+    using type = __m256i;
+    static constexpr std::size_t size = 8;
+    VIPER_TARGET("avx2") static type load(const std::int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    VIPER_TARGET("avx2") static void store(std::int32_t* p, type v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    VIPER_TARGET("avx2") static type zero() { return _mm256_setzero_si256(); }
+    VIPER_TARGET("avx2") static type add(type a, type b) { return _mm256_add_epi32(a, b); }
+    VIPER_TARGET("avx2") static type mul(type a, type b) { return _mm256_mullo_epi32(a, b); }
+    VIPER_TARGET("avx2") static type min(type a, type b) { return _mm256_min_epi32(a, b); }
+    VIPER_TARGET("avx2") static type max(type a, type b) { return _mm256_max_epi32(a, b); }
+};
+
+
+template<reduction op, class Vector>
+VIPER_TARGET("avx2") inline typename Vector::type combine_avx2(const typename Vector::type a, const typename Vector::type b) {
+    if constexpr( op == reduction::sum ) return Vector::add(a, b);
+    else if constexpr( op == reduction::min ) return Vector::min(a, b);
+    else return Vector::max(a, b);
+}
+
+
+// combines the lanes of a register
+template<reduction op, class T>
+VIPER_TARGET("avx2") inline T horizontal_avx2(const typename VectorAVX2<T>::type v) {
+    using vector = VectorAVX2<T>;
+    std::array<T, vector::size> lanes;
+    vector::store(lanes.data(), v);
+    return reduce_scalar<op>(lanes.data(), lanes.size());
+}
+
+
+// four independent accumulators, so that each addition doesn't wait for the previous one
+template<reduction op, class T>
+VIPER_TARGET("avx2") inline T reduce_avx2(const T* p, std::size_t size) {
+    using vector = VectorAVX2<T>;
+    constexpr std::size_t width = vector::size;
+    if( size < 4*width ) return reduce_scalar<op>(p, size);
+
+    auto acc0 = vector::load(p), acc1 = vector::load(p + width), acc2 = vector::load(p + 2*width), acc3 = vector::load(p + 3*width);
+    std::size_t i = 4*width;
+    for( ; i + 4*width <= size; i += 4*width ) {
+        acc0 = combine_avx2<op, vector>(acc0, vector::load(p + i));
+        acc1 = combine_avx2<op, vector>(acc1, vector::load(p + i + width));
+        acc2 = combine_avx2<op, vector>(acc2, vector::load(p + i + 2*width));
+        acc3 = combine_avx2<op, vector>(acc3, vector::load(p + i + 3*width));
+    }
+    for( ; i + width <= size; i += width ) acc0 = combine_avx2<op, vector>(acc0, vector::load(p + i));
+    acc0 = combine_avx2<op, vector>(combine_avx2<op, vector>(acc0, acc1), combine_avx2<op, vector>(acc2, acc3));
+
+    T result = horizontal_avx2<op, T>(acc0);
+    for( ; i < size; ++i ) result = combine<op>(result, p[i]);
+    return result;
+}
+
+
+template<class T>
+VIPER_TARGET("avx2") inline T dot_avx2(const T* a, const T* b, std::size_t size) {
+    using vector = VectorAVX2<T>;
+    constexpr std::size_t width = vector::size;
+    auto acc0 = vector::zero(), acc1 = vector::zero(), acc2 = vector::zero(), acc3 = vector::zero();
+    std::size_t i = 0;
+    for( ; i + 4*width <= size; i += 4*width ) {
+        acc0 = vector::add(acc0, vector::mul(vector::load(a + i), vector::load(b + i)));
+        acc1 = vector::add(acc1, vector::mul(vector::load(a + i + width), vector::load(b + i + width)));
+        acc2 = vector::add(acc2, vector::mul(vector::load(a + i + 2*width), vector::load(b + i + 2*width)));
+        acc3 = vector::add(acc3, vector::mul(vector::load(a + i + 3*width), vector::load(b + i + 3*width)));
+    }
+    for( ; i + width <= size; i += width ) acc0 = vector::add(acc0, vector::mul(vector::load(a + i), vector::load(b + i)));
+    acc0 = vector::add(vector::add(acc0, acc1), vector::add(acc2, acc3));
+
+    T result = horizontal_avx2<reduction::sum, T>(acc0);
+    for( ; i < size; ++i ) result += a[i] * b[i];
+    return result;
+}
+
+
+/*
+ * Each strip of columns four registers wide (two cache lines) is reduced down all the rows
+ * before moving to the next strip: the accumulators never leave the registers, and every cache line
+ * of the block is loaded once.
+ */
+template<reduction op, class T>
+VIPER_TARGET("avx2") inline void reduce_columns_avx2(const T* p, std::size_t stride, std::size_t rows, std::size_t cols, T* out) {
+    using vector = VectorAVX2<T>;
+    constexpr std::size_t width = vector::size;
+    if( rows == 0 ) return reduce_columns_scalar<op>(p, stride, rows, cols, out);
+
+    std::size_t c = 0;
+    for( ; c + 4*width <= cols; c += 4*width ) {
+        const T* strip = p + c;
+        auto acc0 = vector::load(strip), acc1 = vector::load(strip + width), acc2 = vector::load(strip + 2*width), acc3 = vector::load(strip + 3*width);
+        for( std::size_t r = 1; r < rows; ++r ) {
+            strip += stride;
+            acc0 = combine_avx2<op, vector>(acc0, vector::load(strip));
+            acc1 = combine_avx2<op, vector>(acc1, vector::load(strip + width));
+            acc2 = combine_avx2<op, vector>(acc2, vector::load(strip + 2*width));
+            acc3 = combine_avx2<op, vector>(acc3, vector::load(strip + 3*width));
+        }
+        vector::store(out + c, acc0);
+        vector::store(out + c + width, acc1);
+        vector::store(out + c + 2*width, acc2);
+        vector::store(out + c + 3*width, acc3);
+    }
+    for( ; c + width <= cols; c += width ) {
+        auto acc = vector::load(p + c);
+        for( std::size_t r = 1; r < rows; ++r ) acc = combine_avx2<op, vector>(acc, vector::load(p + r*stride + c));
+        vector::store(out + c, acc);
+    }
+    reduce_columns_scalar<op>(p + c, stride, rows, cols - c, out + c);
+}
+
+#endif
+
+
+template<reduction op, class T>
+inline T reduce(const T* p, std::size_t size) {
+#ifdef VIPER_X86_SIMD
+    if constexpr( is_reducible_v<T> ) {
+        if( supported() >= level::avx2 ) return reduce_avx2<op>(p, size);
+    }
+#endif
+    return reduce_scalar<op>(p, size);
+}
+
+
+template<class T>
+inline T dot(const T* a, const T* b, std::size_t size) {
+#ifdef VIPER_X86_SIMD
+    if constexpr( is_reducible_v<T> ) {
+        if( supported() >= level::avx2 ) return dot_avx2(a, b, size);
+    }
+#endif
+    return dot_scalar(a, b, size);
+}
+
+
+template<reduction op, class T>
+inline void reduce_columns(const T* p, std::size_t stride, std::size_t rows, std::size_t cols, T* out) {
+#ifdef VIPER_X86_SIMD
+    if constexpr( is_reducible_v<T> ) {
+        if( supported() >= level::avx2 ) return reduce_columns_avx2<op>(p, stride, rows, cols, out);
+    }
+#endif
+    reduce_columns_scalar<op>(p, stride, rows, cols, out);
+}
+
+} // closing namespace simd
+
+#endif
@@ -0,0 +1,368 @@
+#ifndef __VIPER_TENSOR__
+#define __VIPER_TENSOR__
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "grid.h"
+
+
+/*
+ * A flat sequence container seen as an N-dimensional array, like grid() sees it as a 2-D one:
+ *
+ * std::vector<float> samples(time * sensors * channels);
+ * auto t = tensor(samples, time, sensors, channels);    // extents known at runtime
+ * auto s = tensor<512, 64, 3>(samples);                  // or at compile time
+ *
+ * t(i, j, k) = 0.f;
+ * auto at_time = t[i];                  // the sensors x channels matrix at time i
+ * auto of_sensor = t.slice<1>(j);       // the time x channels matrix of sensor j
+ * auto signal = of_sensor.slice<1>(k);  // slices of slices: the time series of channel k of sensor j
+ *
+ * Each axis has an extent (its number of elements) and a stride (how many elements apart consecutive ones are),
+ * row-major by default: the last axis is contiguous. Slicing fixes the index along an axis and drops it,
+ * the slice keeps the strides of the remaining axes: nothing is copied, it aliases the container.
+ *
+ * Iterating over a tensor (range-for, or for_each) visits every element once, looping innermost over the axis
+ * whose elements are closest in memory, the contiguous one of a row-major tensor or of any of its slices,
+ * so it walks memory in order rather than jumping a stride at each element.
+ */
+
+
+// extents and strides given as template arguments, see StaticShape
+template<std::size_t... extents>
+struct Extents {};
+
+template<std::ptrdiff_t... strides>
+struct Strides {};
+
+
+// strides of a row-major array of the given extents: the last axis is contiguous
+template<std::size_t rank>
+constexpr std::array<std::ptrdiff_t, rank> row_major_strides(const std::array<std::size_t, rank>& extents) {
+    std::array<std::ptrdiff_t, rank> strides{};
+    std::ptrdiff_t stride = 1;
+    for( std::size_t axis = rank; axis-- > 0; ) {
+        strides[axis] = stride;
+        stride *= static_cast<std::ptrdiff_t>(extents[axis]);
+    }
+    return strides;
+}
+
+
+// extents and strides known at runtime
+template<std::size_t rank_>
+class DynamicShape {
+
+    static_assert(rank_ > 0, "a shape has at least one axis");
+
+    std::array<std::size_t, rank_> _extents;
+    std::array<std::ptrdiff_t, rank_> _strides;
+
+    public:
+
+        static constexpr std::size_t rank = rank_;
+
+        explicit DynamicShape(const std::array<std::size_t, rank>& extents)
+            : DynamicShape(extents, row_major_strides(extents)) {}
+
+        DynamicShape(const std::array<std::size_t, rank>& extents, const std::array<std::ptrdiff_t, rank>& strides)
+            : _extents(extents), _strides(strides) {}
+
+        inline std::size_t extent(std::size_t axis) const noexcept { return _extents[axis]; }
+
+        inline std::ptrdiff_t stride(std::size_t axis) const noexcept { return _strides[axis]; }
+
+        // the same shape without 'axis'
+        inline DynamicShape<rank - 1> without(std::size_t axis) const {
+            std::array<std::size_t, rank - 1> extents;
+            std::array<std::ptrdiff_t, rank - 1> strides;
+            for( std::size_t from = 0, to = 0; from < rank; ++from ) {
+                if( from == axis ) continue;
+                extents[to] = _extents[from];
+                strides[to++] = _strides[from];
+            }
+            return DynamicShape<rank - 1>(extents, strides);
+        }
+
+        template<std::size_t axis>
+        inline DynamicShape<rank - 1> without() const { return without(axis); }
+};
+
+
+/*
+ * Extents and strides known at compile time: the shape takes no room,
+ * and offsets are computed with constants the compiler can fold.
+ */
+template<class Extents, class Strides>
+class StaticShape;
+
+template<std::size_t axis, class Shape, class = std::make_index_sequence<Shape::rank - 1>>
+struct static_shape_without;
+
+template<std::size_t... extents, std::ptrdiff_t... strides>
+class StaticShape<Extents<extents...>, Strides<strides...>> {
+
+    static_assert(sizeof...(extents) > 0, "a shape has at least one axis");
+    static_assert(sizeof...(extents) == sizeof...(strides), "a shape has as many strides as extents");
+
+    public:
+
+        static constexpr std::size_t rank = sizeof...(extents);
+        static constexpr std::array<std::size_t, rank> extents_v{extents...};
+        static constexpr std::array<std::ptrdiff_t, rank> strides_v{strides...};
+
+        constexpr std::size_t extent(std::size_t axis) const noexcept { return extents_v[axis]; }
+
+        constexpr std::ptrdiff_t stride(std::size_t axis) const noexcept { return strides_v[axis]; }
+
+        template<std::size_t axis>
+        constexpr auto without() const { return typename static_shape_without<axis, StaticShape>::type(); }
+};
+
+template<std::size_t axis, class Shape, std::size_t... i>
+struct static_shape_without<axis, Shape, std::index_sequence<i...>> {
+    using type = StaticShape<
+        Extents<Shape::extents_v[i < axis ? i : i + 1]...>,
+        Strides<Shape::strides_v[i < axis ? i : i + 1]...>
+            >;
+};
+
+
+template<class Extents>
+struct row_major_shape;
+
+template<std::size_t... extents>
+struct row_major_shape<Extents<extents...>> {
+
+    template<class Sequence>
+    struct with;
+
+    template<std::size_t... i>
+    struct with<std::index_sequence<i...>> {
+        static constexpr auto strides = row_major_strides<sizeof...(extents)>({extents...});
+        using type = StaticShape<Extents<extents...>, Strides<strides[i]...>>;
+    };
+
+    using type = typename with<std::make_index_sequence<sizeof...(extents)>>::type;
+};
+
+
+/*
+ * Walks every element of a tensor, in the order given by 'extents' and 'strides': the axes of the tensor
+ * from the farthest apart in memory to the closest, see Tensor::begin. The last axis moves fastest,
+ * carrying over to the previous ones like the digits of an odometer.
+ */
+template<class Iterator, std::size_t rank>
+class TensorIterator {
+
+    using traits_t = std::iterator_traits<Iterator>;
+
+    public:
+
+        using difference_type = typename traits_t::difference_type;
+        using value_type = typename traits_t::value_type;
+        using pointer = typename traits_t::pointer;
+        using reference = typename traits_t::reference;
+        using iterator_category = std::forward_iterator_tag;
+
+    private:
+
+        Iterator _first;
+        std::array<std::size_t, rank> _extents, _index;
+        std::array<difference_type, rank> _strides;
+        difference_type _offset, _pos;
+
+    public:
+
+        TensorIterator(Iterator first, const std::array<std::size_t, rank>& extents, const std::array<difference_type, rank>& strides, difference_type pos)
+            : _first(std::move(first)), _extents(extents), _index{}, _strides(strides), _offset(0), _pos(pos) {}
+
+        inline reference operator*() const {
+            return _first[_offset];
+        }
+
+        inline bool operator==(const TensorIterator& rhs) const {
+            return _pos == rhs._pos;
+        }
+
+        inline bool operator!=(const TensorIterator& rhs) const {
+            return _pos != rhs._pos;
+        }
+
+        inline TensorIterator& operator++() {
+            ++_pos;
+            for( std::size_t axis = rank; axis-- > 0; ) {
+                _offset += _strides[axis];
+                if( ++_index[axis] < _extents[axis] ) return *this;
+                _offset -= _strides[axis] * static_cast<difference_type>(_extents[axis]);
+                _index[axis] = 0;
+            }
+            return *this;
+        }
+
+        inline auto operator++(int) {
+            auto iterator{*this};
+            operator++();
+            return iterator;
+        }
+};
+
+
+template<class Iterator, class Shape>
+class Tensor {
+
+    Iterator _first;
+    Shape _shape;
+
+    public:
+
+        static constexpr std::size_t rank = Shape::rank;
+
+        using value_type = typename std::iterator_traits<Iterator>::value_type;
+        using size_type = std::size_t;
+        using difference_type = typename std::iterator_traits<Iterator>::difference_type;
+        using reference = typename std::iterator_traits<Iterator>::reference;
+        using shape_type = Shape;
+        using iterator = TensorIterator<Iterator, rank>;
+        using const_iterator = iterator;
+
+        Tensor(Iterator first, Shape shape = Shape()) : _first(std::move(first)), _shape(std::move(shape)) {}
+
+        // the element at index 0 along every axis
+        inline const Iterator& base() const noexcept { return _first; }
+
+        inline const Shape& shape() const noexcept { return _shape; }
+
+        inline size_type extent(size_type axis) const noexcept { return _shape.extent(axis); }
+
+        inline difference_type stride(size_type axis) const noexcept { return _shape.stride(axis); }
+
+        inline size_type size() const noexcept {
+            size_type size = 1;
+            for( size_type axis = 0; axis < rank; ++axis ) size *= extent(axis);
+            return size;
+        }
+
+        template<class... Indices>
+        inline reference operator()(Indices... indices) const {
+            static_assert(sizeof...(Indices) == rank, "a tensor takes one index per axis");
+            difference_type offset = 0;
+            size_type axis = 0;
+            ((offset += static_cast<difference_type>(indices) * stride(axis++)), ...);
+            return _first[offset];
+        }
+
+        // the slice at 'index' along 'axis', one rank lower
+        template<size_type axis>
+        inline auto slice(size_type index) const {
+            static_assert(rank > 1, "slicing a tensor of rank 1 gives an element, use operator[]");
+            static_assert(axis < rank, "slicing along an axis the tensor doesn't have");
+            auto shape = _shape.template without<axis>();
+            return Tensor<Iterator, decltype(shape)>(_first + static_cast<difference_type>(index) * stride(axis), shape);
+        }
+
+        // same, 'axis' known at runtime, only for shapes known at runtime
+        inline auto slice(size_type axis, size_type index) const {
+            static_assert(rank > 1, "slicing a tensor of rank 1 gives an element, use operator[]");
+            static_assert(std::is_same_v<Shape, DynamicShape<rank>>, "the axis of a slice of a StaticShape must be known at compile time, use slice<axis>(index)");
+            return Tensor<Iterator, DynamicShape<rank - 1>>(_first + static_cast<difference_type>(index) * stride(axis), _shape.without(axis));
+        }
+
+        // the slice at 'index' along the first axis, or the element at 'index' for a tensor of rank 1
+        inline decltype(auto) operator[](size_type index) const {
+            if constexpr( rank == 1 ) return _first[static_cast<difference_type>(index) * stride(0)];
+            else return slice<0>(index);
+        }
+
+        // a tensor of rank 2 whose second axis is contiguous, as a Grid
+        inline Grid<Iterator> as_grid() const {
+            static_assert(rank == 2, "only a tensor of rank 2 is a grid");
+            return Grid<Iterator>(_first, extent(0), extent(1), static_cast<size_type>(stride(0)));
+        }
+
+        // the axes from the farthest apart in memory to the closest, the order in which they are walked
+        inline std::array<size_type, rank> loop_order() const {
+            std::array<size_type, rank> order;
+            for( size_type axis = 0; axis < rank; ++axis ) order[axis] = axis;
+            std::stable_sort(order.begin(), order.end(), [this](size_type a, size_type b) {
+                return std::abs(stride(a)) > std::abs(stride(b));
+            });
+            return order;
+        }
+
+        inline iterator begin() const {
+            const auto order = loop_order();
+            std::array<size_type, rank> extents;
+            std::array<difference_type, rank> strides;
+            for( size_type axis = 0; axis < rank; ++axis ) {
+                extents[axis] = extent(order[axis]);
+                strides[axis] = stride(order[axis]);
+            }
+            return iterator(_first, extents, strides, 0);
+        }
+
+        inline iterator end() const {
+            return iterator(_first, {}, {}, static_cast<difference_type>(size()));
+        }
+
+        inline const_iterator cbegin() const { return begin(); }
+
+        inline const_iterator cend() const { return end(); }
+};
+
+
+template<std::size_t depth, std::size_t rank, class Iterator, class Function>
+inline void for_each_axis(const Iterator& first, const std::array<std::size_t, rank>& extents,
+                          const std::array<std::ptrdiff_t, rank>& strides, Function& fn) {
+    using difference_type = typename std::iterator_traits<Iterator>::difference_type;
+    const auto stride = static_cast<difference_type>(strides[depth]);
+    if constexpr( depth + 1 == rank ) {
+        for( std::size_t i = 0; i < extents[depth]; ++i ) fn(first[static_cast<difference_type>(i) * stride]);
+    } else {
+        for( std::size_t i = 0; i < extents[depth]; ++i ) for_each_axis<depth + 1>(first + static_cast<difference_type>(i) * stride, extents, strides, fn);
+    }
+}
+
+
+/*
+ * Calls fn on every element of 'tensor', in the order of its iterators, with a plain loop for each axis:
+ * the innermost one runs over contiguous elements of a row-major tensor, and compiles like a loop over an array.
+ */
+template<class Iterator, class Shape, class Function>
+inline void for_each(const Tensor<Iterator, Shape>& tensor, Function fn) {
+    constexpr std::size_t rank = Shape::rank;
+    const auto order = tensor.loop_order();
+    std::array<std::size_t, rank> extents;
+    std::array<std::ptrdiff_t, rank> strides;
+    for( std::size_t axis = 0; axis < rank; ++axis ) {
+        extents[axis] = tensor.extent(order[axis]);
+        strides[axis] = tensor.stride(order[axis]);
+    }
+    for_each_axis<0>(tensor.base(), extents, strides, fn);
+}
+
+
+// a row-major tensor of 'container', its extents known at runtime
+template<class SequenceContainer, class... Integers, class = std::enable_if_t<(std::is_integral_v<Integers> && ...)>>
+inline auto tensor(SequenceContainer&& container, Integers... extents) {
+    static_assert(std::is_lvalue_reference_v<SequenceContainer>, "tensor() views a container without owning it, a temporary would be destroyed under the view");
+    using shape_t = DynamicShape<sizeof...(Integers)>;
+    return Tensor<decltype(first_element(container)), shape_t>(first_element(container), shape_t({static_cast<std::size_t>(extents)...}));
+}
+
+
+// a row-major tensor of 'container', its extents known at compile time
+template<std::size_t... extents, class SequenceContainer>
+inline auto tensor(SequenceContainer&& container) {
+    static_assert(std::is_lvalue_reference_v<SequenceContainer>, "tensor() views a container without owning it, a temporary would be destroyed under the view");
+    using shape_t = typename row_major_shape<Extents<extents...>>::type;
+    return Tensor<decltype(first_element(container)), shape_t>(first_element(container));
+}
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef __VIPER_TRAITS__
+#define __VIPER_TRAITS__
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+
+/*
+ * Traits shared by several headers.
+ */
+template<class Container, class = void>
+struct has_size : std::false_type {};
+
+template<class Container>
+struct has_size<Container, std::void_t<decltype(std::declval<const Container&>().size())>> : std::true_type {};
+
+
+template<class Container, class = void>
+struct has_resize : std::false_type {};
+
+template<class Container>
+struct has_resize<Container, std::void_t<decltype(std::declval<Container&>().resize(std::size_t()))>> : std::true_type {};
+
+
+// Container::size_type, or std::size_t for ranges which don't say (a pair of istream iterators...)
+template<class Container, class = void>
+struct size_type_of { using type = std::size_t; };
+
+template<class Container>
+struct size_type_of<Container, std::void_t<typename Container::size_type>> { using type = typename Container::size_type; };
+
+template<class Container>
+using size_type_t = typename size_type_of<Container>::type;
+
+
+// std::forward_list has no size()
+template<class Container>
+inline std::size_t input_size(const Container& in) {
+    if constexpr( has_size<Container>::value ) return in.size();
+    else return static_cast<std::size_t>(std::distance(std::begin(in), std::end(in)));
+}
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef __VIPER_TRANSPOSE__
+#define __VIPER_TRANSPOSE__
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "grid.h"
+#include "simd.h"
+
+
+/*
+ * transpose(in, out) writes the transpose of the grid 'in' into the grid 'out': out(c, r) = in(r, c).
+ * 'out' has to be in.width() rows of in.height() elements, and must not overlap 'in'.
+ * transpose(square) transposes a square grid in place.
+ *
+ * For example, to get contiguous columns before heavy work on each of them:
+ * std::vector<float> samples(rows*cols), by_column(cols*rows);
+ * transpose(grid(samples, rows, cols), grid(by_column, cols, rows));
+ * for( auto column : grid(by_column, cols, rows).rows() ) { ... }
+ *
+ * The grids are cut in two along their larger dimension, again and again, until a block and its transpose
+ * fit in the L1 cache together. Whatever the sizes of the caches, there is a level of the recursion whose blocks
+ * fit each of them (the algorithm is cache-oblivious), and a column of the input is never walked further than a block.
+ * Between contiguous grids of 32-bit or 64-bit arithmetic values, blocks are transposed 8x8 or 4x4 tiles at a time
+ * in SIMD registers, see simd::transpose.
+ */
+
+
+// blocks of at most this many rows and columns are transposed without cutting them further
+constexpr std::size_t transpose_leaf_size = 32;
+
+
+// where a dimension of 'size' elements is cut in two, on a multiple of the widest SIMD tile so only the edges are left over
+inline std::size_t transpose_split(std::size_t size) noexcept {
+    return size / 16 * 8;
+}
+
+
+// grids whose leaf blocks go to the SIMD kernels: plain pointers, to the same arithmetic type
+template<class InIterator, class OutIterator>
+constexpr bool is_simd_transposable_v = std::is_pointer_v<InIterator>
+                                     && std::is_pointer_v<OutIterator>
+                                     && std::is_same_v<std::remove_const_t<std::remove_pointer_t<InIterator>>, std::remove_pointer_t<OutIterator>>
+                                     && simd::is_vectorizable_v<std::remove_pointer_t<OutIterator>>;
+
+
+template<class InIterator, class OutIterator>
+inline void transpose_recursive(const Grid<InIterator>& in, const Grid<OutIterator>& out) {
+    const std::size_t height = in.height(), width = in.width();
+    if( height <= transpose_leaf_size && width <= transpose_leaf_size ) {
+        if constexpr( is_simd_transposable_v<InIterator, OutIterator> ) {
+            simd::transpose(in.base(), in.stride(), out.base(), out.stride(), height, width);
+        } else {
+            for( std::size_t r = 0; r < height; ++r ) {
+                for( std::size_t c = 0; c < width; ++c ) out(c, r) = in(r, c);
+            }
+        }
+    } else if( height >= width ) {
+        const std::size_t top = transpose_split(height);
+        transpose_recursive(in.block(0, 0, top, width), out.block(0, 0, width, top));
+        transpose_recursive(in.block(top, 0, height - top, width), out.block(0, top, width, height - top));
+    } else {
+        const std::size_t left = transpose_split(width);
+        transpose_recursive(in.block(0, 0, height, left), out.block(0, 0, left, height));
+        transpose_recursive(in.block(0, left, height, width - left), out.block(left, 0, width - left, height));
+    }
+}
+
+
+// exchanges the block 'a' with the transpose of 'b', its mirror across the diagonal of the same square grid
+template<class Iterator>
+inline void transpose_swap_recursive(const Grid<Iterator>& a, const Grid<Iterator>& b) {
+    const std::size_t height = a.height(), width = a.width();
+    if( height <= transpose_leaf_size && width <= transpose_leaf_size ) {
+        if constexpr( is_simd_transposable_v<Iterator, Iterator> ) {
+            simd::transpose_swap(a.base(), b.base(), a.stride(), height, width);
+        } else {
+            using std::swap;
+            for( std::size_t r = 0; r < height; ++r ) {
+                for( std::size_t c = 0; c < width; ++c ) swap(a(r, c), b(c, r));
+            }
+        }
+    } else if( height >= width ) {
+        const std::size_t top = transpose_split(height);
+        transpose_swap_recursive(a.block(0, 0, top, width), b.block(0, 0, width, top));
+        transpose_swap_recursive(a.block(top, 0, height - top, width), b.block(0, top, width, height - top));
+    } else {
+        const std::size_t left = transpose_split(width);
+        transpose_swap_recursive(a.block(0, 0, height, left), b.block(0, 0, left, height));
+        transpose_swap_recursive(a.block(0, left, height, width - left), b.block(left, 0, width - left, height));
+    }
+}
+
+
+template<class Iterator>
+inline void transpose_inplace_recursive(const Grid<Iterator>& square) {
+    const std::size_t size = square.height();
+    if( size <= transpose_leaf_size ) {
+        if constexpr( is_simd_transposable_v<Iterator, Iterator> ) {
+            simd::transpose_inplace(square.base(), square.stride(), size);
+        } else {
+            using std::swap;
+            for( std::size_t r = 0; r < size; ++r ) {
+                for( std::size_t c = r + 1; c < size; ++c ) swap(square(r, c), square(c, r));
+            }
+        }
+    } else {
+        // the two blocks on the diagonal in place, the two off it with each other
+        const std::size_t half = transpose_split(size);
+        transpose_inplace_recursive(square.block(0, 0, half, half));
+        transpose_inplace_recursive(square.block(half, half, size - half, size - half));
+        transpose_swap_recursive(square.block(0, half, half, size - half), square.block(half, 0, size - half, half));
+    }
+}
+
+
+template<class InIterator, class OutIterator>
+inline void transpose(const Grid<InIterator>& in, const Grid<OutIterator>& out) {
+    transpose_recursive(in, out);
+}
+
+
+// 'square' has as many rows as columns
+template<class Iterator>
+inline void transpose(const Grid<Iterator>& square) {
+    transpose_inplace_recursive(square);
+}
+
+
+/*
+ * Same, with the dimensions known at compile time like the ones of row<>() and col<>():
+ * 'in' is 'rows' x 'cols', 'out' is 'cols' x 'rows'.
+ *
+ * For example:
+ * std::array<int, 6> in { 0, 1, 2,
+ *                         3, 4, 5 }, out;
+ * transpose<2, 3>(in, out);   // out == { 0, 3, 1, 4, 2, 5 }
+ */
+template<std::size_t rows, std::size_t cols, class InContainer, class OutContainer>
+inline void transpose(const InContainer& in, OutContainer& out) {
+    transpose(grid(in, rows, cols), grid(out, cols, rows));
+}
+
+#endif
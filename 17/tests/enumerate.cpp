@@ -1,9 +1,15 @@
+#include <algorithm>
 #include <array>
 #include <forward_list>
+#include <initializer_list>
+#include <iterator>
 #include <deque>
 #include <list>
 #include <map>
 #include <set>
+#include <sstream>
+#include <string>
+#include <type_traits>
 #include <vector>
 
 #include "catch.hpp"
@@ -113,5 +119,241 @@ TEST_CASE(" enumerate a std::map ", "[enumerate] [map]") {
     }
 }
 
+TEST_CASE(" random access enumeration ", "[enumerate] [random_access]") {
+
+    std::vector<int> container {10,11,12,13,14,15,16,17};
+    auto enumeration = enumerate(container);
+    using iterator_t = decltype(enumeration.begin());
+
+    REQUIRE( std::is_same_v<std::iterator_traits<iterator_t>::iterator_category, std::random_access_iterator_tag> );
+    REQUIRE( enumeration.size() == 8 );
+    REQUIRE( enumeration.end() - enumeration.begin() == 8 );
+    REQUIRE( std::distance(enumeration.begin(), enumeration.end()) == 8 );
+
+    SECTION(" offsets move the index along ") {
+        auto it = enumeration.begin() + 5;
+        REQUIRE( (*it).first == 5 );
+        REQUIRE( (*it).second == 15 );
+        REQUIRE( it[2].first == 7 );
+        REQUIRE( it[-1].second == 14 );
+
+        it -= 3;
+        REQUIRE( (*it).first == 2 );
+        REQUIRE( (*--it).first == 1 );
+        REQUIRE( (*(2 + it)).first == 3 );
+        REQUIRE( it < enumeration.end() );
+        REQUIRE( enumeration.end() > it );
+        REQUIRE( it <= it );
+        REQUIRE( it >= it );
+    }
+
+    SECTION(" splitting in chunks ") {
+        std::size_t sum = 0;
+        const auto first = enumeration.begin();
+        for( std::ptrdiff_t chunk = 0; chunk < 4; ++chunk ) {
+            for( auto it = first + chunk*2; it != first + (chunk+1)*2; ++it ) {
+                sum += (*it).first;
+                REQUIRE( (*it).second == static_cast<int>((*it).first) + 10 );
+            }
+        }
+        REQUIRE( sum == 28 );
+    }
+
+    SECTION(" algorithms needing random access ") {
+        auto found = std::lower_bound(enumeration.begin(), enumeration.end(), 13,
+            [](const auto& pair, int value) { return pair.second < value; });
+        REQUIRE( (*found).first == 3 );
+    }
+
+    SECTION(" other categories are kept ") {
+        std::list<int> li {1,2,3};
+        auto listed = enumerate(li);
+        REQUIRE( std::is_same_v<std::iterator_traits<decltype(listed.begin())>::iterator_category, std::bidirectional_iterator_tag> );
+        REQUIRE( listed.size() == 3 );
+
+        std::forward_list<int> fl {1,2,3};
+        REQUIRE( enumerate(fl).size() == 3 );
+    }
+}
+
+
+TEST_CASE(" end of a node based container ", "[enumerate] [sentinel]") {
+
+    std::forward_list<int> container {1,2,3,4,5};
+    auto enumeration = enumerate(container);
+
+    REQUIRE_FALSE( std::is_same_v<decltype(enumeration.begin()), decltype(enumeration.end())> );
+    REQUIRE( std::is_same_v<decltype(enumerate(std::declval<std::vector<int>&>()).begin()),
+                            decltype(enumerate(std::declval<std::vector<int>&>()).end())> );
+
+    auto it = enumeration.begin();
+    REQUIRE( it != enumeration.end() );
+    REQUIRE_FALSE( enumeration.end() == it );
+    for( int i = 0; i < 5; ++i ) ++it;
+    REQUIRE( it == enumeration.end() );
+    REQUIRE_FALSE( enumeration.end() != it );
+
+    std::size_t last = 0;
+    for( auto&& [index, value] : enumeration ) last = index;
+    REQUIRE( last == 4 );
+}
+
+
+// yields n, n-1... 1, with non-const begin() and neither size() nor size_type, like a generator
+class Countdown {
+
+    int n;
+
+    public:
+
+        class iterator {
+            Countdown* countdown;
+            public:
+                using difference_type = std::ptrdiff_t;
+                using value_type = int;
+                using pointer = const int*;
+                using reference = int;
+                using iterator_category = std::input_iterator_tag;
+
+                explicit iterator(Countdown* countdown) : countdown(countdown) {}
+                int operator*() const { return countdown->n; }
+                iterator& operator++() { if( --countdown->n == 0 ) countdown = nullptr; return *this; }
+                bool operator==(const iterator& rhs) const { return countdown == rhs.countdown; }
+                bool operator!=(const iterator& rhs) const { return countdown != rhs.countdown; }
+        };
+
+        explicit Countdown(int n) : n(n) {}
+        iterator begin() { return iterator(n ? this : nullptr); }
+        iterator end() { return iterator(nullptr); }
+};
+
+
+TEST_CASE(" enumerate a single pass input range ", "[enumerate] [input]") {
+
+    SECTION(" a pair of istream iterators ") {
+        std::istringstream stream("ten eleven twelve");
+        std::vector<std::pair<std::size_t, std::string>> words;
+        for( auto&& [index, word] : enumerate(std::istream_iterator<std::string>(stream), std::istream_iterator<std::string>()) ) {
+            words.emplace_back(index, word);
+        }
+        REQUIRE( words == (std::vector<std::pair<std::size_t, std::string>>{{0, "ten"}, {1, "eleven"}, {2, "twelve"}}) );
+    }
+
+    SECTION(" an empty stream ") {
+        std::istringstream stream;
+        auto enumeration = enumerate(std::istream_iterator<int>(stream), std::istream_iterator<int>());
+        REQUIRE_FALSE( enumeration.begin() != enumeration.end() );
+    }
+
+    SECTION(" a generator ") {
+        Countdown countdown(3);
+        std::size_t count = 0;
+        for( auto&& [index, value] : enumerate(countdown) ) {
+            REQUIRE( static_cast<int>(index) + value == 3 );
+            ++count;
+        }
+        REQUIRE( count == 3 );
+    }
+
+    SECTION(" a pair of iterators over a container ") {
+        std::vector<int> vi {1,2,3,4};
+        for( auto&& [index, value] : enumerate(vi.begin() + 1, vi.end()) ) {
+            value = static_cast<int>(index);
+        }
+        REQUIRE( vi == (std::vector<int>{1,0,1,2}) );
+    }
+}
+
+
+TEST_CASE(" enumerate from a start index, by a step ", "[enumerate] [start]") {
+
+    std::vector<char> vc {'a','b','c','d'};
+
+    SECTION(" start ") {
+        for( auto&& [index, value] : enumerate(vc, 100) ) {
+            REQUIRE( index + 97 - 100 == static_cast<std::size_t>(value) );
+        }
+        REQUIRE( (*enumerate(vc, 100).begin()).first == 100 );
+        REQUIRE( (*--enumerate(vc, 100).end()).first == 103 );
+    }
+
+    SECTION(" step ") {
+        std::vector<std::size_t> indices;
+        for( auto&& [index, value] : enumerate(vc, 10, 5) ) indices.push_back(index);
+        REQUIRE( indices == (std::vector<std::size_t>{10, 15, 20, 25}) );
+
+        auto first = enumerate(vc, 10, 5).begin();
+        REQUIRE( (*(first + 3)).first == 25 );
+    }
+
+    SECTION(" each chunk of a split enumeration keeps its global index ") {
+        auto enumeration = enumerate(vc, 1000, 2);
+        auto chunk = enumeration.begin() + 2;
+        REQUIRE( (*chunk).first == 1004 );
+        REQUIRE( chunk[1].first == 1006 );
+        REQUIRE( chunk[1].second == 'd' );
+        chunk -= 1;
+        REQUIRE( (*chunk).first == 1002 );
+        REQUIRE( enumeration.end() - chunk == 3 );
+    }
+
+    SECTION(" node based containers ") {
+        std::list<int> li {1,2,3};
+        std::size_t last = 0;
+        for( auto&& [index, value] : enumerate(li, 7) ) last = index;
+        REQUIRE( last == 9 );
+    }
+}
+
+
+// counts its copies, to make sure temporaries are moved and l-values referenced
+struct Rows : std::vector<int> {
+
+    static inline std::size_t copies = 0;
+
+    Rows(std::initializer_list<int> values) : std::vector<int>(values) {}
+    Rows(const Rows& rhs) : std::vector<int>(rhs) { ++copies; }
+    Rows(Rows&&) = default;
+    Rows& operator=(const Rows&) = default;
+    Rows& operator=(Rows&&) = default;
+};
+
+
+TEST_CASE(" enumerate a temporary ", "[enumerate] [rvalue]") {
+
+    auto make_rows = [] { return Rows{1,2,3,4,5}; };
+    Rows::copies = 0;
+
+    SECTION(" in a range-for ") {
+        std::size_t sum = 0;
+        for( auto&& [index, value] : enumerate(make_rows()) ) {
+            REQUIRE( static_cast<int>(index) + 1 == value );
+            sum += index;
+        }
+        REQUIRE( sum == 10 );
+        REQUIRE( Rows::copies == 0 );
+    }
+
+    SECTION(" kept past the end of the full expression ") {
+        auto enumeration = enumerate(make_rows(), 10);
+        REQUIRE( enumeration.size() == 5 );
+        REQUIRE( (*(enumeration.begin() + 4)).first == 14 );
+        REQUIRE( (*(enumeration.begin() + 4)).second == 5 );
+        REQUIRE( Rows::copies == 0 );
+    }
+
+    SECTION(" l-values are still referenced ") {
+        Rows rows = make_rows();
+        for( auto&& [index, value] : enumerate(rows) ) value = static_cast<int>(index);
+        REQUIRE( rows == (std::vector<int>{0,1,2,3,4}) );
+        REQUIRE( Rows::copies == 0 );
+
+        const Rows& constant = rows;
+        for( auto&& [index, value] : enumerate(constant) ) REQUIRE( static_cast<int>(index) == value );
+        REQUIRE( Rows::copies == 0 );
+    }
+}
+
+
 // TODO multiset, multimap, unordered_set, unordered_map, unordered_multiset, unordered_multimap
 
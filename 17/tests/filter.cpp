@@ -1,4 +1,11 @@
+#include <algorithm>
 #include <array>
+#include <cstdint>
+#include <deque>
+#include <forward_list>
+#include <list>
+#include <set>
+#include <string>
 #include <vector>
 
 #include "catch.hpp"
@@ -6,10 +13,6 @@
 
 
 using vi_t = std::vector<int>;
-using vi_iter_t = vi_t::iterator;
-using vi_filter_iter_t = FilterIterator<vi_iter_t>;
-
-auto even = [](const int& i) { return i % 2 == 0; };
 
 
 SCENARIO(" filter function ", " [filter] ") {
@@ -29,6 +32,359 @@ SCENARIO(" filter function ", " [filter] ") {
         }
     }
 
+    GIVEN("a std::vector<int> vi = {1,2,3,4,5,6}") {
+
+        vi_t vi = {1,2,3,4,5,6};
+        int threshold = 3;
+        auto above = [threshold](int i) { return i > threshold; };
+
+        WHEN(" filtering into a different container type ") {
+
+            auto filtered = filter<std::set<int>>(above, vi);
+
+            THEN(" the output container holds the selected values ") {
+                REQUIRE( filtered == std::set<int>{4,5,6} );
+            }
+        }
+
+        WHEN(" nothing passes the predicate ") {
+
+            auto filtered = filter([](int i) { return i > 6; }, vi);
+
+            THEN(" the output container is empty ") {
+                REQUIRE( filtered.empty() );
+            }
+        }
+    }
+
+}
+
+
+SCENARIO(" sizing the output of filter ", " [filter], [two_pass], [one_pass] ") {
+
+    GIVEN(" a std::vector<int> of 1000 elements ") {
+
+        vi_t vi(1000);
+        for( std::size_t i = 0; i < vi.size(); ++i ) vi[i] = static_cast<int>(i);
+        auto small = [](int i) { return i < 100; };
+        auto big = [](int i) { return i >= 100; };
+
+        WHEN(" counting first ") {
+
+            auto filtered = filter(two_pass, small, vi);
+
+            THEN(" the output is allocated to the exact size ") {
+                REQUIRE( filtered.size() == 100 );
+                REQUIRE( filtered.capacity() == 100 );
+                REQUIRE( filtered.back() == 99 );
+            }
+        }
+
+        WHEN(" going one pass with few matches ") {
+
+            auto filtered = filter(one_pass, small, vi);
+
+            THEN(" the unused room is given back ") {
+                REQUIRE( filtered.size() == 100 );
+                REQUIRE( filtered.capacity() < 200 );
+            }
+        }
+
+        WHEN(" going one pass with many matches ") {
+
+            auto filtered = filter(one_pass, big, vi);
+
+            THEN(" the output keeps the room reserved for the input ") {
+                REQUIRE( filtered.size() == 900 );
+                REQUIRE( filtered.capacity() == 1000 );
+                REQUIRE( filtered.front() == 100 );
+            }
+        }
+
+        WHEN(" the predicate counts its calls ") {
+
+            std::size_t calls = 0;
+            auto counting = [&calls](int i) { ++calls; return i < 100; };
+
+            THEN(" two_pass calls it twice per element, one_pass once ") {
+                filter(two_pass, counting, vi);
+                REQUIRE( calls == 2*vi.size() );
+                calls = 0;
+                filter(one_pass, counting, vi);
+                REQUIRE( calls == vi.size() );
+            }
+        }
+    }
+
+    GIVEN(" containers without reserve ") {
+
+        std::forward_list<std::string> words {"yo", "mama", "so", "fat"};
+        auto short_word = [](const std::string& word) { return word.size() == 2; };
+
+        THEN(" any strategy builds them from FilterIterators ") {
+            REQUIRE( filter(two_pass, short_word, words) == std::forward_list<std::string>{"yo", "so"} );
+            REQUIRE( filter<std::list<std::string>>(one_pass, short_word, words) == std::list<std::string>{"yo", "so"} );
+            REQUIRE( filter<std::vector<std::string>>(short_word, words) == std::vector<std::string>{"yo", "so"} );
+        }
+    }
+
+    GIVEN(" trivially copyable values without a default constructor ") {
+
+        struct Id {
+            explicit Id(int value) : value(value) {}
+            int value;
+        };
+        std::vector<Id> ids {Id(1), Id(2), Id(3), Id(4)};
+        auto even = [](const Id& id) { return id.value % 2 == 0; };
+
+        THEN(" two_pass reserves rather than resizes ") {
+            auto filtered = filter(two_pass, even, ids);
+            REQUIRE( filtered.size() == 2 );
+            REQUIRE( filtered.capacity() == 2 );
+            REQUIRE( filtered[1].value == 4 );
+        }
+    }
 }
 
 
+SCENARIO(" parallel filter function ", " [filter], [parallel] ") {
+
+    GIVEN(" a large std::vector<int> ") {
+
+        vi_t vi(100'000);
+        for( std::size_t i = 0; i < vi.size(); ++i ) vi[i] = static_cast<int>(i);
+        auto multiple_of_3 = [](int i) { return i % 3 == 0; };
+
+        WHEN(" filtered in parallel into the same container type ") {
+
+            auto filtered = filter(parallel_policy{4, 1}, multiple_of_3, vi);
+
+            THEN(" it matches the sequential filter, in order ") {
+                REQUIRE( filtered == filter(multiple_of_3, vi) );
+            }
+        }
+
+        WHEN(" filtered in parallel into a std::set ") {
+
+            auto filtered = filter<std::set<int>>(parallel_policy{4, 1}, multiple_of_3, vi);
+
+            THEN(" it holds the same values ") {
+                REQUIRE( filtered.size() == 33'334 );
+                REQUIRE( *filtered.rbegin() == 99'999 );
+            }
+        }
+
+        WHEN(" filtered in parallel into a std::vector<bool> ") {
+
+            auto filtered = filter<std::vector<bool>>(parallel_policy{4, 1}, multiple_of_3, vi);
+
+            THEN(" it is written sequentially, its elements share words ") {
+                REQUIRE( is_bit_packed<std::vector<bool>>::value );
+                REQUIRE( filtered == filter<std::vector<bool>>(multiple_of_3, vi) );
+                REQUIRE( filtered.size() == 33'334 );
+                REQUIRE( std::count(filtered.begin(), filtered.end(), false) == 1 );   // only 0 converts to false
+            }
+        }
+
+        WHEN(" filtered in parallel into a std::string ") {
+
+            auto digit = [](int i) { return static_cast<char>('0' + i % 10); };
+            std::string digits;
+            for( auto i : vi ) digits.push_back(digit(i));
+            auto not_zero = [](char c) { return c != '0'; };
+            auto filtered = filter(parallel_policy{4, 1}, not_zero, digits);
+
+            THEN(" it matches the sequential filter, in order ") {
+                REQUIRE( filtered.size() == 90'000 );
+                REQUIRE( filtered == filter(not_zero, digits) );
+            }
+        }
+
+        WHEN(" the input is too small to be split ") {
+
+            auto filtered = filter(par, multiple_of_3, vi_t{1,2,3,4,5,6});
+
+            THEN(" it still filters ") {
+                REQUIRE( filtered == vi_t{3,6} );
+            }
+        }
+    }
+}
+
+
+// counts its copies, moving is free
+struct Payload {
+    static inline std::size_t copies = 0;
+    int value;
+    Payload(int value) : value(value) {}
+    Payload(const Payload& other) : value(other.value) { ++copies; }
+    Payload(Payload&&) = default;
+    Payload& operator=(const Payload& other) { value = other.value; ++copies; return *this; }
+    Payload& operator=(Payload&&) = default;
+};
+
+
+SCENARIO(" filter function on a temporary container ", " [filter], [rvalue] ") {
+
+    auto even_payload = [](const Payload& p) { return p.value % 2 == 0; };
+
+    GIVEN(" a temporary std::vector ") {
+
+        std::vector<Payload> source;
+        for( int i = 0; i < 10; ++i ) source.emplace_back(i);
+        const auto* buffer = source.data();
+        Payload::copies = 0;
+
+        WHEN(" filtered into the same container type ") {
+
+            auto filtered = filter(even_payload, std::move(source));
+
+            THEN(" it is compacted in place, without a single copy ") {
+                REQUIRE( filtered.size() == 5 );
+                REQUIRE( filtered.data() == buffer );
+                REQUIRE( filtered[4].value == 8 );
+                REQUIRE( Payload::copies == 0 );
+            }
+        }
+
+        WHEN(" filtered into another container type ") {
+
+            auto filtered = filter<std::list<Payload>>(even_payload, std::move(source));
+
+            THEN(" the kept elements are moved ") {
+                REQUIRE( filtered.size() == 5 );
+                REQUIRE( filtered.back().value == 8 );
+                REQUIRE( Payload::copies == 0 );
+            }
+        }
+    }
+
+    GIVEN(" temporaries of other container types ") {
+
+        auto short_word = [](const std::string& word) { return word.size() == 2; };
+
+        THEN(" lists, sets and strings are compacted too ") {
+            REQUIRE( filter(short_word, std::list<std::string>{"yo", "mama", "so", "fat"}) == std::list<std::string>{"yo", "so"} );
+            REQUIRE( filter(short_word, std::forward_list<std::string>{"yo", "mama", "so"}) == std::forward_list<std::string>{"yo", "so"} );
+            REQUIRE( filter(short_word, std::set<std::string>{"yo", "mama", "so"}) == std::set<std::string>{"so", "yo"} );
+            REQUIRE( filter([](char c) { return c != ' '; }, std::string("y o m a m a")) == "yomama" );
+        }
+    }
+
+    GIVEN(" an l-value ") {
+
+        std::vector<int> vi {1,2,3,4};
+
+        THEN(" it is left untouched ") {
+            REQUIRE( filter([](int i) { return i > 2; }, vi) == std::vector<int>{3,4} );
+            REQUIRE( vi == std::vector<int>{1,2,3,4} );
+        }
+    }
+}
+
+
+SCENARIO(" in place filter ", " [filter], [filter_inplace] ") {
+
+    auto odd = [](int i) { return i % 2 == 1; };
+
+    GIVEN(" a std::vector<int> ") {
+
+        vi_t vi = {1,2,3,4,5,6,7};
+        const auto* buffer = vi.data();
+
+        WHEN(" filtered in place ") {
+
+            auto size = filter_inplace(odd, vi);
+
+            THEN(" the order is kept, in the same buffer ") {
+                REQUIRE( size == 4 );
+                REQUIRE( vi == vi_t{1,3,5,7} );
+                REQUIRE( vi.data() == buffer );
+                REQUIRE( vi.capacity() == 7 );
+            }
+        }
+
+        WHEN(" filtered in place and shrunk ") {
+
+            filter_inplace(shrink, odd, vi);
+
+            THEN(" the capacity is given back ") {
+                REQUIRE( vi == vi_t{1,3,5,7} );
+                REQUIRE( vi.capacity() == 4 );
+            }
+        }
+
+        WHEN(" filtered in place with a comparison ") {
+
+            vi_t large(1000);
+            for( std::size_t i = 0; i < large.size(); ++i ) large[i] = static_cast<int>(i % 10);
+
+            auto size = filter_inplace(between(3, 4), large);
+
+            THEN(" it goes through the stream compaction ") {
+                REQUIRE( (is_simd_compactable<vi_t, decltype(between(3, 4))>::value) );
+                REQUIRE( size == 200 );
+                REQUIRE( large[0] == 3 );
+                REQUIRE( large[1] == 4 );
+                REQUIRE( large[199] == 4 );
+            }
+        }
+    }
+
+    GIVEN(" other containers ") {
+
+        THEN(" std::deque and std::list are filtered in place too ") {
+            std::deque<int> di {1,2,3,4};
+            REQUIRE( filter_inplace(odd, di) == 2 );
+            REQUIRE( di == std::deque<int>{1,3} );
+
+            std::list<int> li {1,2,3,4};
+            REQUIRE( filter_inplace(gt(2), li) == 2 );
+            REQUIRE( li == std::list<int>{3,4} );
+
+            std::vector<double> vd {0.5, 1.5, 2.5};
+            REQUIRE_FALSE( (is_simd_compactable<decltype(vd), decltype(gt(1))>::value) ); // int vs double: scalar
+            REQUIRE( filter_inplace(gt(1), vd) == 2 );
+        }
+    }
+}
+
+
+SCENARIO(" filter with a comparison ", " [filter], [filter_compact] ") {
+
+    GIVEN(" arrays of arithmetic values ") {
+
+        std::vector<float> vf(1000);
+        std::vector<std::int32_t> vi(1000);
+        for( std::size_t i = 0; i < vf.size(); ++i ) {
+            vf[i] = static_cast<float>(i % 100) / 100.0f;
+            vi[i] = static_cast<std::int32_t>(i % 100) - 50;
+        }
+
+        THEN(" the output only holds the kept values, in order ") {
+            auto large = filter(gt(0.5f), vf);
+            REQUIRE( large.size() == 490 );
+            REQUIRE( large.front() == 0.51f );
+            REQUIRE( std::is_sorted(large.begin(), large.begin() + 49) );
+            REQUIRE( std::all_of(large.begin(), large.end(), [](float f) { return f > 0.5f; }) );
+
+            auto small = filter(between(-2, 2), vi);
+            REQUIRE( small.size() == 50 );
+            REQUIRE( (std::vector<std::int32_t>(small.begin(), small.begin() + 5)) == (std::vector<std::int32_t>{-2, -1, 0, 1, 2}) );
+        }
+
+        THEN(" it gives back what more than half of the output didn't use ") {
+            REQUIRE( filter(lt(-45), vi).capacity() < vi.size() / 2 );
+            REQUIRE( filter(ne(7), vi).size() == 990 );
+        }
+
+        THEN(" it matches the element by element filter ") {
+            auto lambda = [](std::int32_t i) { return i >= 10; };
+            REQUIRE( filter(ge(10), vi) == filter(lambda, vi) );
+            REQUIRE( (filter<std::deque<std::int32_t>>(ge(10), vi)) == (filter<std::deque<std::int32_t>>(lambda, vi)) );
+            REQUIRE( filter(eq(0.25f), vf).size() == 10 );
+            REQUIRE( filter(gt(2.0f), vf).empty() );
+            REQUIRE( filter(gt(0.5f), std::vector<float>{}).empty() );
+        }
+    }
+}
@@ -0,0 +1,164 @@
+#include <atomic>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "../headers/filter.h"
+
+
+/*
+ * Counts the allocations of the containers using it, so the benchmarks can report them
+ * without replacing the global operator new of the whole test binary.
+ */
+static std::atomic<std::size_t> allocations{0};
+
+template<class T>
+struct CountingAllocator {
+    using value_type = T;
+
+    CountingAllocator() = default;
+
+    template<class U>
+    CountingAllocator(const CountingAllocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        ++allocations;
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept { std::allocator<T>().deallocate(p, n); }
+};
+
+template<class T, class U>
+bool operator==(const CountingAllocator<T>&, const CountingAllocator<U>&) noexcept { return true; }
+
+template<class T, class U>
+bool operator!=(const CountingAllocator<T>&, const CountingAllocator<U>&) noexcept { return false; }
+
+template<class T>
+using counted_vector = std::vector<T, CountingAllocator<T>>;
+
+using counted_string = std::basic_string<char, std::char_traits<char>, CountingAllocator<char>>;
+
+
+template<class Function>
+std::size_t count_allocations(Function&& fn) {
+    const std::size_t before = allocations;
+    fn();
+    return allocations - before;
+}
+
+
+TEST_CASE(" filter: sizing the output ", "[.][benchmark][filter]") {
+
+    counted_vector<int> vi(10'000'000);
+    std::iota(vi.begin(), vi.end(), 0);
+    auto keep = [](int i) { return (i & 3) != 0; };
+    const std::size_t expected = vi.size() - vi.size() / 4;
+
+    using fi_t = FilterIterator<decltype(vi)::const_iterator, decltype(keep)>;
+    auto iterator_pair = [&] {
+        return counted_vector<int>(fi_t(vi.cbegin(), vi.cend(), keep), fi_t(vi.cend(), vi.cend(), keep));
+    };
+
+    auto growing = [&] {
+        counted_vector<int> out;
+        for( auto i : vi ) { if( keep(i) ) out.push_back(i); }
+        return out;
+    };
+
+    WARN( "push_back allocations: " << count_allocations(growing) );
+    WARN( "two_pass allocations: " << count_allocations([&] { filter(two_pass, keep, vi); }) );
+    WARN( "one_pass allocations: " << count_allocations([&] { filter(one_pass, keep, vi); }) );
+    WARN( "FilterIterator pair allocations: " << count_allocations(iterator_pair) );
+
+    REQUIRE( count_allocations([&] { filter(two_pass, keep, vi); }) == 1 );
+    REQUIRE( count_allocations([&] { filter(one_pass, keep, vi); }) <= 2 );
+
+    BENCHMARK(" push_back ") {
+        REQUIRE( growing().size() == expected );
+    }
+
+    BENCHMARK(" two_pass ") {
+        REQUIRE( filter(two_pass, keep, vi).size() == expected );
+    }
+
+    BENCHMARK(" one_pass ") {
+        REQUIRE( filter(one_pass, keep, vi).size() == expected );
+    }
+
+    BENCHMARK(" FilterIterator pair ") {
+        REQUIRE( iterator_pair().size() == expected );
+    }
+}
+
+
+TEST_CASE(" filter: temporary vs l-value input ", "[.][benchmark][filter]") {
+
+    auto make_names = [] {
+        counted_vector<counted_string> names(1'000'000);
+        for( std::size_t i = 0; i < names.size(); ++i ) names[i] = ("a name long enough not to fit in SSO #" + std::to_string(i)).c_str();
+        return names;
+    };
+    auto keep = [](const counted_string& name) { return name.back() % 2 == 0; };
+
+    auto names = make_names();
+    WARN( "l-value allocations: " << count_allocations([&] { filter(keep, names); }) );
+    REQUIRE( count_allocations([&] { filter(keep, std::move(names)); }) == 0 );
+
+    BENCHMARK(" l-value ") {
+        auto names = make_names();
+        REQUIRE( filter(keep, names).size() == 500'000 );
+    }
+
+    BENCHMARK(" temporary ") {
+        REQUIRE( filter(keep, make_names()).size() == 500'000 );
+    }
+}
+
+
+TEST_CASE(" filter_inplace: stream compaction ", "[.][benchmark][filter]") {
+
+    std::vector<int> source(1'000'000);
+    for( std::size_t i = 0; i < source.size(); ++i ) source[i] = static_cast<int>((i * 2654435761u) % 1000);
+    auto lambda = [](int i) { return i > 500; };
+
+    auto scalar = source;
+    auto compacted = source;
+    filter_inplace(lambda, scalar);
+    filter_inplace(gt(500), compacted);
+    REQUIRE( scalar == compacted );
+
+    // refilled with assign() so the buffer is reused and the page faults of a fresh copy aren't measured
+    std::vector<int> vi;
+    vi.reserve(source.size());
+
+    BENCHMARK(" erase(remove_if) with a lambda ") {
+        vi.assign(source.begin(), source.end());
+        REQUIRE( filter_inplace(lambda, vi) == scalar.size() );
+    }
+
+    BENCHMARK(" SIMD compaction with gt() ") {
+        vi.assign(source.begin(), source.end());
+        REQUIRE( filter_inplace(gt(500), vi) == scalar.size() );
+    }
+}
+
+
+TEST_CASE(" filter: stream compaction into a new container ", "[.][benchmark][filter]") {
+
+    std::vector<float> vf(1'000'000);
+    for( std::size_t i = 0; i < vf.size(); ++i ) vf[i] = static_cast<float>((i * 2654435761u) % 1000) / 1000.0f;
+    auto lambda = [](float f) { return f > 0.5f; };
+    REQUIRE( filter(lambda, vf) == filter(gt(0.5f), vf) );
+
+    BENCHMARK(" two_pass with a lambda ") {
+        REQUIRE( filter(lambda, vf).size() == 499'000 );
+    }
+
+    BENCHMARK(" SIMD compaction with gt() ") {
+        REQUIRE( filter(gt(0.5f), vf).size() == 499'000 );
+    }
+}
@@ -130,3 +130,41 @@ TEST_CASE(" FilterIterator specialization for pointer types ", " [FilterIterator
 }
 
 
+TEST_CASE(" FilterIterator with the predicate type as a template parameter ", " [FilterIterator], [predicate] ") {
+    std::vector<int> vi {1,2,3,4,5,6};
+    auto odd = [](int i) { return (i&1) == 1; };
+
+    using fi_t = FilterIterator<decltype(vi)::iterator, decltype(odd)>;
+
+    SECTION(" a stateless predicate takes no room ") {
+        REQUIRE( sizeof(fi_t) == 2*sizeof(decltype(vi)::iterator) );
+    }
+
+    SECTION(" the predicate type is deduced ") {
+        FilterIterator it(vi.begin(), vi.end(), odd);
+
+        REQUIRE( std::is_same<decltype(it), fi_t>::value );
+        REQUIRE( *it++ == 1 );
+        REQUIRE( *it++ == 3 );
+        REQUIRE( *it++ == 5 );
+        REQUIRE( it == vi.end() );
+    }
+
+    SECTION(" a predicate with captures is still CopyAssignable ") {
+        int threshold = 4;
+        auto above = [threshold](int i) { return i > threshold; };
+        using above_t = FilterIterator<decltype(vi)::iterator, decltype(above)>;
+
+        REQUIRE( std::is_copy_assignable<above_t>::value );
+        REQUIRE( std::is_move_assignable<above_t>::value );
+
+        auto it = above_t(vi.begin(), vi.end(), above);
+        auto end = above_t(vi.end(), vi.end(), above);
+        REQUIRE( *it == 5 );
+
+        it = end;
+        REQUIRE( it == end );
+        REQUIRE( std::distance(above_t(vi.begin(), vi.end(), above), end) == 2 );
+    }
+}
+
@@ -0,0 +1,46 @@
+#include <numeric>
+#include <vector>
+
+#include "catch.hpp"
+#include "../headers/filter.h"
+
+
+/*
+ * Benchmarks are hidden from the default run, launch them with:
+ * ./tests17 [benchmark]
+ */
+
+TEST_CASE(" FilterIterator: std::function vs template predicate ", "[.][benchmark][FilterIterator]") {
+
+    std::vector<int> vi(10'000'000);
+    std::iota(vi.begin(), vi.end(), 0);
+
+    auto even = [](int i) { return (i&1) == 0; };
+    long long expected = 0;
+    for( auto i : vi ) { if( even(i) ) expected += i; }
+
+    BENCHMARK(" hand-written loop ") {
+        long long sum = 0;
+        for( auto i : vi ) { if( even(i) ) sum += i; }
+        REQUIRE( sum == expected );
+    }
+
+    BENCHMARK(" std::function predicate ") {
+        using fi_t = FilterIterator<decltype(vi)::const_iterator>;
+        long long sum = 0;
+        for( auto it = fi_t(vi.cbegin(), vi.cend(), even); it != vi.cend(); ++it ) sum += *it;
+        REQUIRE( sum == expected );
+    }
+
+    BENCHMARK(" template predicate ") {
+        using fi_t = FilterIterator<decltype(vi)::const_iterator, decltype(even)>;
+        long long sum = 0;
+        for( auto it = fi_t(vi.cbegin(), vi.cend(), even); it != vi.cend(); ++it ) sum += *it;
+        REQUIRE( sum == expected );
+    }
+
+    BENCHMARK(" filter() ") {
+        auto filtered = filter(even, vi);
+        REQUIRE( filtered.size() == vi.size()/2 );
+    }
+}
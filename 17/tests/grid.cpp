@@ -1,11 +1,19 @@
+#include <algorithm>
 #include <array>
+#include <deque>
+#include <iterator>
+#include <list>
+#include <numeric>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "catch.hpp"
 
 #include "../headers/enumerate.h"
 #include "../headers/grid.h"
 #include "../headers/iterator_cast.h"
+#include "../headers/parallel.h"
 
 
 TEST_CASE(" grid ", "[grid]") {
@@ -95,3 +103,375 @@ TEST_CASE(" grid ", "[grid]") {
     }
 
 }
+
+
+TEST_CASE(" runtime grid ", "[grid] [runtime]") {
+
+    // dimensions only known at runtime
+    std::size_t rows = 3, cols = 4;
+    std::vector<int> rectangle(rows*cols);
+    for( std::size_t i = 0; i < rectangle.size(); ++i ) rectangle[i] = static_cast<int>(i);
+
+    SECTION(" row ") {
+        for( std::size_t r = 0; r < rows; ++r ) {
+            auto row_r = row(rectangle, r, rows, cols);
+            REQUIRE( row_r.size() == cols );
+            REQUIRE( std::equal(row_r.begin(), row_r.end(), rectangle.begin() + r*cols) );
+            REQUIRE( row_r[1] == static_cast<int>(r*cols + 1) );
+        }
+        // contiguous containers are walked with plain pointers
+        REQUIRE( std::is_same_v<decltype(row(rectangle, 0, rows, cols).begin()), int*> );
+        REQUIRE( std::is_same_v<decltype(row(std::as_const(rectangle), 0, rows, cols).begin()), const int*> );
+    }
+
+    SECTION(" col ") {
+        for( std::size_t c = 0; c < cols; ++c ) {
+            auto col_c = col(rectangle, c, rows, cols);
+            REQUIRE( col_c.size() == rows );
+            std::size_t i = c;
+            for( const auto& element : col_c ) {
+                REQUIRE( element == rectangle[i] );
+                i += cols;
+            }
+            REQUIRE( col_c.end() - col_c.begin() == static_cast<std::ptrdiff_t>(rows) );
+            REQUIRE( col_c[2] == static_cast<int>(2*cols + c) );
+        }
+
+        auto col_1 = col(rectangle, 1, rows, cols);
+        REQUIRE( std::is_same_v<std::iterator_traits<decltype(col_1.begin())>::iterator_category, std::random_access_iterator_tag> );
+        REQUIRE( *(col_1.begin() + 2) == 9 );
+        REQUIRE( *std::max_element(col_1.begin(), col_1.end()) == 9 );
+    }
+
+    SECTION(" write through the views ") {
+        for( auto&& element : col(rectangle, 0, rows, cols) ) element = -1;
+        for( auto&& element : row(rectangle, 2, rows, cols) ) element *= 10;
+        REQUIRE( rectangle == (std::vector<int>{-1,1,2,3, -1,5,6,7, -10,90,100,110}) );
+    }
+
+    SECTION(" grid ") {
+        auto g = grid(rectangle, rows, cols);
+        REQUIRE( g.height() == rows );
+        REQUIRE( g.width() == cols );
+        REQUIRE( g.size() == rows*cols );
+        REQUIRE( g(2, 1) == 9 );
+
+        g(2, 1) = 42;
+        REQUIRE( rectangle[9] == 42 );
+        REQUIRE( g.row(2)[1] == 42 );
+        REQUIRE( g.col(1)[2] == 42 );
+    }
+
+    SECTION(" containers without data() ") {
+        std::deque<int> dq(rectangle.begin(), rectangle.end());
+        auto col_3 = col(dq, 3, rows, cols);
+        REQUIRE( std::vector<int>(col_3.begin(), col_3.end()) == (std::vector<int>{3, 7, 11}) );
+        auto row_1 = row(dq, 1, rows, cols);
+        REQUIRE( std::vector<int>(row_1.begin(), row_1.end()) == (std::vector<int>{4, 5, 6, 7}) );
+    }
+
+    SECTION(" compile-time and runtime views agree ") {
+        std::array<int, 12> fixed{};
+        std::copy(rectangle.begin(), rectangle.end(), fixed.begin());
+        auto fixed_col = col<2, 3, 4>(fixed);
+        auto runtime_col = col(fixed, 2, 3, 4);
+        REQUIRE( std::equal(fixed_col.begin(), fixed_col.end(), runtime_col.begin()) );
+    }
+}
+
+
+TEST_CASE(" rows and columns of a grid ", "[grid] [runtime]") {
+
+    std::vector<int> rectangle {
+        0, 1, 2, 3,
+        4, 5, 6, 7,
+        8, 9, 10, 11,
+    };
+    auto g = grid(rectangle, 3, 4);
+
+    SECTION(" nested loops ") {
+        int expected = 0;
+        for( auto row : g.rows() ) {
+            for( auto element : row ) REQUIRE( element == expected++ );
+        }
+        REQUIRE( expected == 12 );
+
+        std::vector<int> by_column;
+        for( auto column : g.cols() ) {
+            for( auto element : column ) by_column.push_back(element);
+        }
+        REQUIRE( by_column == (std::vector<int>{0,4,8, 1,5,9, 2,6,10, 3,7,11}) );
+    }
+
+    SECTION(" random access ranges of views ") {
+        auto rows = g.rows();
+        auto cols = g.cols();
+        REQUIRE( rows.size() == 3 );
+        REQUIRE( cols.size() == 4 );
+        REQUIRE( rows.end() - rows.begin() == 3 );
+        REQUIRE( std::is_same_v<std::iterator_traits<decltype(cols.begin())>::iterator_category, std::random_access_iterator_tag> );
+        REQUIRE( rows[1][2] == 6 );
+        REQUIRE( cols[3][2] == 11 );
+        REQUIRE( (*(cols.begin() + 2))[1] == 6 );
+    }
+
+    SECTION(" algorithms ") {
+        std::vector<int> sums(g.height());
+        std::transform(g.rows().begin(), g.rows().end(), sums.begin(), [](auto row) {
+            return std::accumulate(row.begin(), row.end(), 0);
+        });
+        REQUIRE( sums == (std::vector<int>{6, 22, 38}) );
+
+        std::size_t widest = 0;
+        for( auto&& [c, column] : enumerate(g.cols()) ) {
+            if( column[0] > g.col(widest)[0] ) widest = c;
+        }
+        REQUIRE( widest == 3 );
+    }
+
+    SECTION(" parallel over rows ") {
+        std::vector<int> big(1000 * 16, 1);
+        auto big_grid = grid(big, 1000, 16);
+        parallel_for(parallel_policy{4, 1}, enumerate(big_grid.rows()), [](auto&& indexed) {
+            for( auto& element : indexed.second ) element = static_cast<int>(indexed.first);
+        });
+        for( std::size_t r = 0; r < 1000; ++r ) REQUIRE( big_grid(r, 15) == static_cast<int>(r) );
+    }
+
+    SECTION(" writes go to the container ") {
+        for( auto column : g.cols() ) column[0] = -1;
+        REQUIRE( (std::vector<int>(rectangle.begin(), rectangle.begin() + 4)) == (std::vector<int>{-1,-1,-1,-1}) );
+    }
+}
+
+
+TEST_CASE(" tiled traversal ", "[grid] [tiles]") {
+
+    const std::size_t rows = 7, cols = 10;
+    std::vector<int> rectangle(rows*cols);
+    std::iota(rectangle.begin(), rectangle.end(), 0);
+    auto g = grid(rectangle, rows, cols);
+
+    SECTION(" blocks alias their parent ") {
+        auto block = g.block(2, 3, 4, 5);
+        REQUIRE( block.height() == 4 );
+        REQUIRE( block.width() == 5 );
+        REQUIRE( block.stride() == cols );
+        REQUIRE( block(0, 0) == 23 );
+        REQUIRE( block.row(1)[4] == 37 );
+        REQUIRE( block.col(2)[3] == 55 );
+        block(1, 1) = -1;
+        REQUIRE( rectangle[34] == -1 );
+    }
+
+    SECTION(" every element is in exactly one tile ") {
+        auto tiles = g.tiles(3, 4);
+        REQUIRE( tiles.height() == 3 );
+        REQUIRE( tiles.width() == 3 );
+        REQUIRE( tiles.size() == 9 );
+
+        std::vector<int> visits(rectangle.size(), 0);
+        for( auto tile : tiles ) {
+            for( std::size_t r = 0; r < tile.height(); ++r ) {
+                for( std::size_t c = 0; c < tile.width(); ++c ) {
+                    REQUIRE( tile(r, c) == static_cast<int>((tile.top() + r)*cols + tile.left() + c) );
+                    ++visits[static_cast<std::size_t>(tile(r, c))];
+                }
+            }
+        }
+        for( auto visit : visits ) REQUIRE( visit == 1 );
+
+        // edges are cut down to what is left
+        auto last = tiles[tiles.size() - 1];
+        REQUIRE( last.top() == 6 );
+        REQUIRE( last.left() == 8 );
+        REQUIRE( last.height() == 1 );
+        REQUIRE( last.width() == 2 );
+    }
+
+    SECTION(" column sums tile by tile ") {
+        std::vector<long> sums(cols, 0), expected(cols, 0);
+        for( std::size_t c = 0; c < cols; ++c ) {
+            for( auto element : g.col(c) ) expected[c] += element;
+        }
+        for( auto tile : g.tiles(2, 3) ) {
+            for( std::size_t c = 0; c < tile.width(); ++c ) {
+                for( auto element : tile.col(c) ) sums[tile.left() + c] += element;
+            }
+        }
+        REQUIRE( sums == expected );
+    }
+
+    SECTION(" default tile size ") {
+        const auto [height, width] = default_tile_size<float>();
+        REQUIRE( height >= 1 );
+        REQUIRE( height <= l1_cache_ways() );
+        REQUIRE( width % 16 == 0 );
+        REQUIRE( height * width * sizeof(float) <= std::max<std::size_t>(l1_cache_size() / 2, 64 * sizeof(float)) );
+        REQUIRE( g.tiles().size() == 1 );
+    }
+
+    SECTION(" tile size when the system can't tell the cache parameters ") {
+        REQUIRE( cache_parameter(0, 32 * 1024, 4 * 1024, 1024 * 1024) == 32 * 1024 );
+        REQUIRE( cache_parameter(-1, 8, 1, 64) == 8 );
+        REQUIRE( cache_parameter(1 << 30, 8, 1, 64) == 8 );
+        REQUIRE( cache_parameter(48 * 1024, 32 * 1024, 4 * 1024, 1024 * 1024) == 48 * 1024 );
+
+        // the fallbacks: 32KiB, 8 ways
+        REQUIRE( default_tile_size<float>(32 * 1024, 8) == std::make_pair(std::size_t(8), std::size_t(512)) );
+        REQUIRE( default_tile_size<double>(32 * 1024, 8) == std::make_pair(std::size_t(8), std::size_t(256)) );
+        // elements larger than a cache line, or a cache too small for a line per way, still give a tile
+        const auto [height, width] = default_tile_size<std::array<char, 256>>(32 * 1024, 8);
+        REQUIRE( height == 8 );
+        REQUIRE( width == 8 );
+        REQUIRE( default_tile_size<float>(64, 8) == std::make_pair(std::size_t(1), std::size_t(16)) );
+    }
+}
+
+
+TEST_CASE(" layouts of compile-time views ", "[grid] [layout]") {
+
+    // the 2 x 3 grid
+    // 0 1 2
+    // 3 4 5
+    // stored in different layouts
+    auto elements = [](auto view) {
+        std::vector<int> visited;
+        for( auto element : view ) visited.push_back(element);
+        return visited;
+    };
+    auto require_grid = [&](auto column_0, auto column_2, auto row_1) {
+        REQUIRE( elements(column_0) == (std::vector<int>{0, 3}) );
+        REQUIRE( elements(column_2) == (std::vector<int>{2, 5}) );
+        REQUIRE( elements(row_1) == (std::vector<int>{3, 4, 5}) );
+        REQUIRE( column_2[1] == 5 );
+        REQUIRE( row_1[0] == 3 );
+    };
+
+    SECTION(" row-major is the default ") {
+        std::array<int, 6> values { 0, 1, 2, 3, 4, 5 };
+        require_grid(col<0, 2, 3>(values), col<2, 2, 3>(values), row<1, 2, 3>(values));
+        require_grid(col<0, 2, 3, row_major>(values), col<2, 2, 3, row_major>(values), row<1, 2, 3, row_major>(values));
+    }
+
+    SECTION(" column-major ") {
+        std::array<int, 6> values { 0, 3, 1, 4, 2, 5 };
+        require_grid(col<0, 2, 3, column_major>(values), col<2, 2, 3, column_major>(values), row<1, 2, 3, column_major>(values));
+        REQUIRE( column_major::size(2, 3) == values.size() );
+
+        // writes go where the layout says
+        for( auto&& element : row<0, 2, 3, column_major>(values) ) element *= 10;
+        REQUIRE( values == (std::array<int, 6>{ 0, 3, 10, 4, 20, 5 }) );
+    }
+
+    SECTION(" padded ") {
+        std::array<int, 8> by_rows { 0, 1, 2, -1,
+                                     3, 4, 5, -1 };
+        require_grid(col<0, 2, 3, padded_row_major<4>>(by_rows), col<2, 2, 3, padded_row_major<4>>(by_rows), row<1, 2, 3, padded_row_major<4>>(by_rows));
+        REQUIRE( padded_row_major<4>::size(2, 3) == by_rows.size() );
+
+        // a leading dimension of 3 for columns of 2, like BLAS's lda
+        std::vector<int> by_cols { 0, 3, -1,  1, 4, -1,  2, 5, -1 };
+        require_grid(col<0, 2, 3, padded_column_major<3>>(by_cols), col<2, 2, 3, padded_column_major<3>>(by_cols), row<1, 2, 3, padded_column_major<3>>(by_cols));
+    }
+
+    SECTION(" tiled ") {
+        // 2 x 2 tiles, the right ones half empty
+        std::array<int, 8> tiles { 0, 1, 3, 4,
+                                   2, -1, 5, -1 };
+        REQUIRE( tiled<2, 2>::size(2, 3) == tiles.size() );
+        require_grid(col<0, 2, 3, tiled<2, 2>>(tiles), col<2, 2, 3, tiled<2, 2>>(tiles), row<1, 2, 3, tiled<2, 2>>(tiles));
+    }
+
+    SECTION(" containers without random access ") {
+        std::list<int> values { 0, 3, 1, 4, 2, 5 };
+        REQUIRE( elements(row<1, 2, 3, column_major>(values)) == (std::vector<int>{3, 4, 5}) );
+        REQUIRE( elements(col<2, 2, 3>(values)) == (std::vector<int>{1, 5}) );
+    }
+}
+
+
+template<class Iterator>
+long recursive_sum(const Grid<Iterator>& g, std::size_t& leaves) {
+    if( g.size() <= 16 ) {
+        ++leaves;
+        long total = 0;
+        for( auto row : g.rows() ) total += std::accumulate(row.begin(), row.end(), 0L);
+        return total;
+    }
+    auto [first, second] = g.split();
+    return recursive_sum(first, leaves) + recursive_sum(second, leaves);
+}
+
+
+TEST_CASE(" sub-grids ", "[grid] [subgrid]") {
+
+    const std::size_t rows = 30, cols = 20;
+    std::vector<int> values(rows * cols);
+    std::iota(values.begin(), values.end(), 0);
+    auto g = grid(values, rows, cols);
+
+    SECTION(" windows alias their parent ") {
+        auto window = subgrid(g, 10, 5, 8, 6);
+        REQUIRE( window.height() == 8 );
+        REQUIRE( window.width() == 6 );
+        REQUIRE( window.stride() == cols );
+        REQUIRE( window(0, 0) == 10*20 + 5 );
+        REQUIRE( window.row(2)[3] == 12*20 + 8 );
+        REQUIRE( window.col(5)[7] == 17*20 + 10 );
+        REQUIRE( window.col(0).size() == 8 );
+
+        // windows of windows
+        auto inner = subgrid(window, 2, 1, 3, 3);
+        REQUIRE( inner(0, 0) == 12*20 + 6 );
+        REQUIRE( inner.stride() == cols );
+
+        for( auto row : inner.rows() ) {
+            for( auto& element : row ) element = -1;
+        }
+        REQUIRE( std::count(values.begin(), values.end(), -1) == 9 );
+        REQUIRE( values[14*20 + 8] == -1 );
+        REQUIRE( values[15*20 + 8] == 14*20 + 8 + 20 );
+    }
+
+    SECTION(" split ") {
+        auto [top, bottom] = g.split_rows(12);
+        REQUIRE( top.height() == 12 );
+        REQUIRE( bottom.height() == 18 );
+        REQUIRE( bottom(0, 0) == 12*20 );
+
+        auto [left, right] = g.split_cols(5);
+        REQUIRE( left.width() == 5 );
+        REQUIRE( right.width() == 15 );
+        REQUIRE( right(1, 0) == 25 );
+
+        // the larger dimension is halved
+        auto [first, second] = subgrid(g, 0, 0, 4, 10).split();
+        REQUIRE( first.width() == 5 );
+        REQUIRE( second(0, 0) == 5 );
+    }
+
+    SECTION(" divide and conquer ") {
+        std::size_t leaves = 0;
+        REQUIRE( recursive_sum(g, leaves) == std::accumulate(values.begin(), values.end(), 0L) );
+        REQUIRE( leaves >= rows * cols / 16 );
+
+        // workers on blocks, each writing its own
+        std::vector<Grid<int*>> blocks{g};
+        while( blocks.size() < 8 ) {
+            std::vector<Grid<int*>> halves;
+            for( const auto& block : blocks ) {
+                auto [first, second] = block.split();
+                halves.push_back(first);
+                halves.push_back(second);
+            }
+            blocks = halves;
+        }
+        parallel_for(parallel_policy{4, 1}, blocks, [](const Grid<int*>& block) {
+            for( auto row : block.rows() ) {
+                for( auto& element : row ) element = -element;
+            }
+        });
+        REQUIRE( std::all_of(values.begin() + 1, values.end(), [](int element) { return element < 0; }) );
+    }
+}
@@ -0,0 +1,94 @@
+#include <cstddef>
+#include <vector>
+
+#include "catch.hpp"
+#include "../headers/grid.h"
+#include "../headers/grid_storage.h"
+#include "../headers/reduce.h"
+
+
+TEST_CASE(" grid: column sums, tiled vs column by column ", "[.][benchmark][grid]") {
+
+    // larger than the last level cache, so that it comes from memory
+    const std::size_t rows = 8192, cols = 8192;
+    std::vector<float> buffer(rows * cols);
+    for( std::size_t i = 0; i < buffer.size(); ++i ) buffer[i] = static_cast<float>(i % 7);
+    auto g = grid(buffer, rows, cols);
+
+    std::vector<float> expected(cols, 0.f);
+    for( auto row : g.rows() ) {
+        for( std::size_t c = 0; c < cols; ++c ) expected[c] += row[c];
+    }
+
+    BENCHMARK(" row-major sweep (baseline) ") {
+        std::vector<float> sums(cols, 0.f);
+        for( auto row : g.rows() ) {
+            for( std::size_t c = 0; c < cols; ++c ) sums[c] += row[c];
+        }
+        REQUIRE( sums == expected );
+    }
+
+    BENCHMARK(" column by column ") {
+        std::vector<float> sums(cols, 0.f);
+        for( std::size_t c = 0; c < cols; ++c ) {
+            for( auto element : g.col(c) ) sums[c] += element;
+        }
+        REQUIRE( sums == expected );
+    }
+
+    BENCHMARK(" column by column, tile by tile ") {
+        std::vector<float> sums(cols, 0.f);
+        for( auto tile : g.tiles() ) {
+            for( std::size_t c = 0; c < tile.width(); ++c ) {
+                float sum = 0.f;
+                for( auto element : tile.col(c) ) sum += element;
+                sums[tile.left() + c] += sum;
+            }
+        }
+        REQUIRE( sums == expected );
+    }
+}
+
+
+TEST_CASE(" grid: std::vector vs GridStorage ", "[.][benchmark][grid]") {
+
+    // rows 4KiB apart in a std::vector: the elements of a column all fall in the same L1 sets
+    const std::size_t rows = 4096, cols = 1024;
+    std::vector<float> buffer(rows * cols, 1.f);
+    GridStorage<float> storage(rows, cols, 1.f);
+    auto g = grid(buffer, rows, cols);
+
+    BENCHMARK(" column by column, std::vector ") {
+        float total = 0.f;
+        for( auto column : g.cols() ) {
+            for( auto element : column ) total += element;
+        }
+        REQUIRE( total == static_cast<float>(rows * cols) );
+    }
+
+    BENCHMARK(" column by column, GridStorage ") {
+        float total = 0.f;
+        for( auto column : storage.cols() ) {
+            for( auto element : column ) total += element;
+        }
+        REQUIRE( total == static_cast<float>(rows * cols) );
+    }
+
+    // rows of an odd width start anywhere in a std::vector, aligned in a GridStorage
+    const std::size_t odd = 1001;
+    std::vector<float> odd_buffer(rows * odd, 1.f);
+    GridStorage<float> odd_storage(rows, odd, 1.f);
+    auto odd_grid = grid(odd_buffer, rows, odd);
+
+    BENCHMARK(" row sums, std::vector ") {
+        float total = 0.f;
+        for( auto row : odd_grid.rows() ) total += sum(row);
+        REQUIRE( total == static_cast<float>(rows * odd) );
+    }
+
+    BENCHMARK(" row sums, GridStorage ") {
+        float total = 0.f;
+        for( auto row : odd_storage.rows() ) total += sum(row);
+        REQUIRE( total == static_cast<float>(rows * odd) );
+    }
+}
@@ -0,0 +1,108 @@
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "catch.hpp"
+#include "../headers/grid_storage.h"
+#include "../headers/reduce.h"
+#include "../headers/transpose.h"
+
+
+TEST_CASE(" grid storage ", "[grid] [storage]") {
+
+    SECTION(" rows are aligned and padded ") {
+        GridStorage<float> g(7, 1001, 1.f);
+        REQUIRE( g.height() == 7 );
+        REQUIRE( g.width() == 1001 );
+        REQUIRE( g.size() == 7 * 1001 );
+        REQUIRE( g.stride() == 1008 );
+        for( std::size_t r = 0; r < g.height(); ++r ) {
+            REQUIRE( reinterpret_cast<std::uintptr_t>(&g(r, 0)) % 64 == 0 );
+            REQUIRE( g.row(r).size() == 1001 );
+            REQUIRE( g.padded_row(r).size() == 1008 );
+        }
+        // the padding is initialized like the rest
+        REQUIRE( g.padded_row(6)[1007] == 1.f );
+        REQUIRE( sum(g.row(3)) == 1001.f );
+    }
+
+    SECTION(" strides a multiple of 1KiB apart get a cache line more ") {
+        REQUIRE( GridStorage<float>::padded_stride(1024) == 1040 );
+        REQUIRE( GridStorage<float>::padded_stride(256) == 272 );
+        REQUIRE( GridStorage<double>::padded_stride(512) == 520 );
+        REQUIRE( GridStorage<float>::padded_stride(1000) == 1008 );
+        REQUIRE( GridStorage<float>::padded_stride(16) == 16 );
+        REQUIRE( GridStorage<std::uint8_t>::padded_stride(3) == 64 );
+        REQUIRE( GridStorage<float>::padded_stride(0) == 0 );
+        // elements whose size doesn't divide 64 aren't padded
+        struct Rgb { std::uint8_t r, g, b; };
+        REQUIRE( GridStorage<Rgb>::padded_stride(100) == 100 );
+    }
+
+    SECTION(" the views of a grid ") {
+        GridStorage<int> g(5, 6);
+        for( std::size_t r = 0; r < g.height(); ++r ) {
+            for( std::size_t c = 0; c < g.width(); ++c ) g(r, c) = static_cast<int>(r * 10 + c);
+        }
+        REQUIRE( g.col(2)[4] == 42 );
+        REQUIRE( g.row(3)[5] == 35 );
+        REQUIRE( g.rows().size() == 5 );
+        REQUIRE( g.cols()[1][2] == 21 );
+        REQUIRE( g.block(1, 1, 2, 2)(1, 1) == 22 );
+        REQUIRE( sum(g.cols()) == (std::vector<int>{100, 105, 110, 115, 120, 125}) );
+        REQUIRE( subgrid(g.view(), 2, 3, 2, 2)(0, 0) == 23 );
+
+        const auto& constant = g;
+        REQUIRE( constant.row(4)[0] == 40 );
+        REQUIRE( std::is_same_v<decltype(constant.view()), Grid<const int*>> );
+
+        GridStorage<int> t(6, 5);
+        transpose(g.view(), t.view());
+        REQUIRE( t(5, 4) == 45 );
+    }
+
+    SECTION(" copies own their elements ") {
+        GridStorage<std::string> g(2, 3, "yo");
+        GridStorage<std::string> copy(g);
+        copy(1, 2) = "mama";
+        REQUIRE( g(1, 2) == "yo" );
+        REQUIRE( copy(1, 2) == "mama" );
+
+        g = copy;
+        REQUIRE( g(1, 2) == "mama" );
+
+        GridStorage<std::string> moved(std::move(copy));
+        REQUIRE( moved(1, 2) == "mama" );
+        REQUIRE( moved.row(0)[0] == "yo" );
+    }
+
+    SECTION(" moved-from storages are empty, and can be copied and assigned ") {
+        GridStorage<float> g(3, 5, 1.f);
+        GridStorage<float> moved(std::move(g));
+        REQUIRE( g.height() == 0 );
+        REQUIRE( g.width() == 0 );
+        REQUIRE( g.stride() == 0 );
+        REQUIRE( g.data() == nullptr );
+        REQUIRE( g.rows().size() == 0 );
+
+        GridStorage<float> copy(g);
+        REQUIRE( copy.size() == 0 );
+        REQUIRE( copy.data() == nullptr );
+
+        GridStorage<float> other(2, 2);
+        other = g;
+        REQUIRE( other.size() == 0 );
+        other = std::move(moved);
+        REQUIRE( other.height() == 3 );
+        REQUIRE( other(2, 4) == 1.f );
+        REQUIRE( moved.size() == 0 );
+
+        // and reused
+        moved = other;
+        REQUIRE( moved(2, 4) == 1.f );
+        g = GridStorage<float>(1, 1, 2.f);
+        REQUIRE( g(0, 0) == 2.f );
+    }
+}
@@ -1,3 +1,15 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <list>
+#include <map>
+#include <numeric>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "catch.hpp"
@@ -16,3 +28,285 @@ TEST_CASE(" 'in' function ", " [in] ") {
     REQUIRE( in(std::vector<int>{1,2,3,4}, 3) ); // std::vector<int>{...} is an r-value
 
 }
+
+
+template<class T>
+void require_same_as_std_find() {
+    // long enough to go through the unrolled loop, the single register loop and the scalar tail
+    for( std::size_t size : {0, 1, 3, 7, 16, 31, 32, 33, 64, 127, 128, 129, 200} ) {
+        std::vector<T> haystack(size);
+        std::iota(haystack.begin(), haystack.end(), T(1));
+
+        REQUIRE_FALSE( in(haystack, T(0)) );
+        for( std::size_t pos = 0; pos < size; ++pos ) {
+            REQUIRE( in(haystack, haystack[pos]) );
+            REQUIRE( simd::find(haystack.data(), haystack.data() + size, haystack[pos]) == haystack.data() + pos );
+        }
+    }
+}
+
+
+TEST_CASE(" 'in' over contiguous arithmetic containers ", " [in], [simd] ") {
+
+    SECTION(" every element width ") {
+        require_same_as_std_find<std::int8_t>();
+        require_same_as_std_find<std::uint16_t>();
+        require_same_as_std_find<std::int32_t>();
+        require_same_as_std_find<std::uint64_t>();
+        require_same_as_std_find<float>();
+        require_same_as_std_find<double>();
+    }
+
+    SECTION(" first match wins with duplicates ") {
+        std::vector<short> vs(100, 7);
+        vs[40] = 9;
+        vs[80] = 9;
+        REQUIRE( simd::find(vs.data(), vs.data() + vs.size(), short(9)) == vs.data() + 40 );
+    }
+
+    SECTION(" std::array ") {
+        std::array<std::uint16_t, 50> whitelist{};
+        whitelist[49] = 443;
+        REQUIRE( in(whitelist, 443) );
+        REQUIRE_FALSE( in(whitelist, 80) );
+    }
+
+    SECTION(" std::string ") {
+        std::string str = "the quick brown fox jumps over the lazy dog";
+        REQUIRE( in(str, 'z') );
+        REQUIRE_FALSE( in(str, '!') );
+    }
+
+    SECTION(" floating point equality ") {
+        std::vector<float> vf(40, 1.5f);
+        vf[33] = -0.0f;
+        REQUIRE( in(vf, 0.0f) );
+        REQUIRE_FALSE( in(vf, 2.5f) );
+    }
+
+    SECTION(" needles of another type are compared, not converted ") {
+        std::vector<std::uint8_t> bytes(40, 1);
+        bytes[0] = 44;
+        REQUIRE( in(bytes, 44) );
+        REQUIRE_FALSE( in(bytes, 300) );    // 300 would wrap to 44
+        REQUIRE_FALSE( in(bytes, -212) );
+
+        std::vector<int> vi = {2, 5};
+        REQUIRE( in(vi, 2.0) );
+        REQUIRE_FALSE( in(vi, 2.5) );       // 2.5 would truncate to 2
+        REQUIRE_FALSE( in(vi, 1e300) );
+
+        std::vector<float> vf(40, 0.1f);
+        REQUIRE( in(vf, 0.1f) );
+        REQUIRE_FALSE( in(vf, 0.1) );       // no float equals the double 0.1
+        REQUIRE( in(vf, static_cast<double>(0.1f)) );
+    }
+
+    SECTION(" non-contiguous containers still work ") {
+        REQUIRE( is_contiguous_arithmetic_v<std::vector<int>> );
+        REQUIRE_FALSE( is_contiguous_arithmetic_v<std::list<int>> );
+        REQUIRE_FALSE( is_contiguous_arithmetic_v<std::vector<std::string>> );
+        REQUIRE( in(std::list<int>{1,2,3}, 3) );
+    }
+}
+
+
+TEST_CASE(" 'in' over associative containers ", " [in], [associative] ") {
+
+    SECTION(" std::set ") {
+        std::set<int> container {1,2,3,4};
+        REQUIRE( has_member_find<decltype(container), int>::value );
+        REQUIRE( in(container, 3) );
+        REQUIRE_FALSE( in(container, 5) );
+    }
+
+    SECTION(" std::unordered_set ") {
+        std::unordered_set<std::string> container {"alpha", "bravo"};
+        REQUIRE( in(container, std::string("bravo")) );
+        REQUIRE_FALSE( in(container, std::string("charlie")) );
+    }
+
+    SECTION(" std::map looks up keys ") {
+        std::map<char, std::string> container { {'a', "alpha"}, {'b', "bravo"} };
+        REQUIRE( in(container, 'a') );
+        REQUIRE_FALSE( in(container, 'c') );
+    }
+
+    SECTION(" std::unordered_map looks up keys ") {
+        std::unordered_map<int, int> container { {1, 10}, {2, 20} };
+        REQUIRE( in(container, 2) );
+        REQUIRE_FALSE( in(container, 20) );
+    }
+
+    SECTION(" needles of another type are not converted to the key type ") {
+        std::set<std::uint8_t> bytes {44, 1};
+        std::unordered_set<std::uint8_t> hashed_bytes {44, 1};
+        REQUIRE( in(bytes, 44) );
+        REQUIRE_FALSE( in(bytes, 300) );            // 300 would wrap to 44
+        REQUIRE_FALSE( in(hashed_bytes, 300) );
+        REQUIRE_FALSE( in(hashed_bytes, -212) );
+        REQUIRE( in(hashed_bytes, 1.0) );
+
+        std::set<int> ints {2};
+        std::unordered_set<std::int64_t> hashed_ints {2};
+        REQUIRE( in(ints, 2.0) );
+        REQUIRE_FALSE( in(ints, 2.5) );             // 2.5 would truncate to 2
+        REQUIRE_FALSE( in(hashed_ints, 2.5) );
+        REQUIRE_FALSE( in(hashed_ints, 1e300) );
+        REQUIRE( in(std::map<int, int>{ {2, 0} }, 2.0) );
+        REQUIRE_FALSE( in(std::map<int, int>{ {2, 0} }, 2.5) );
+
+        std::vector<int> needles(2*in_batch_threshold, 300);
+        needles[0] = 44;
+        auto mask = in_mask(bytes, needles);
+        REQUIRE( mask[0] );
+        REQUIRE( std::count(mask.begin(), mask.end(), true) == 1 );
+    }
+
+    SECTION(" std::string is not associative ") {
+        REQUIRE_FALSE( has_member_find<std::string, char>::value );
+    }
+}
+
+
+TEST_CASE(" 'in' over a sorted container ", " [in], [sorted] ") {
+
+    SECTION(" every value and every gap of sorted vectors of many sizes ") {
+        for( int size = 0; size < 70; ++size ) {
+            std::vector<int> even(size);
+            for( int i = 0; i < size; ++i ) even[i] = 2*i;
+
+            for( int value = -1; value <= 2*size; ++value ) {
+                REQUIRE( in(sorted(even), value) == (value >= 0 && value % 2 == 0 && value < 2*size) );
+            }
+        }
+    }
+
+    SECTION(" duplicates ") {
+        std::vector<int> vi {1,1,1,2,2,5,5,5,5};
+        REQUIRE( in(sorted(vi), 1) );
+        REQUIRE( in(sorted(vi), 2) );
+        REQUIRE( in(sorted(vi), 5) );
+        REQUIRE_FALSE( in(sorted(vi), 3) );
+    }
+
+    SECTION(" custom order ") {
+        std::vector<std::string> words {"delta", "charlie", "bravo", "alpha"};
+        REQUIRE( in(sorted(words, std::greater<>()), std::string("charlie")) );
+        REQUIRE_FALSE( in(sorted(words, std::greater<>()), std::string("echo")) );
+    }
+
+    SECTION(" non random access container ") {
+        std::list<int> li {1,3,5,7};
+        REQUIRE( in(sorted(li), 5) );
+        REQUIRE_FALSE( in(sorted(li), 4) );
+    }
+
+    SECTION(" NaN is found nowhere, like in an unsorted scan ") {
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        std::vector<double> vd {1, 2, 3};
+        std::list<double> ld {1, 2, 3};
+        REQUIRE_FALSE( in(vd, nan) );
+        REQUIRE_FALSE( in(sorted(vd), nan) );
+        REQUIRE_FALSE( in(sorted(ld), nan) );
+        REQUIRE( in(sorted(vd), 3.0) );
+        REQUIRE( in(sorted(ld), 1.0) );
+    }
+}
+
+
+TEST_CASE(" batch membership ", " [in], [batch] ") {
+
+    std::vector<int> whitelist = {80, 443, 8080};
+
+    SECTION(" a few needles ") {
+        std::vector<int> ports = {22, 80, 443};
+
+        REQUIRE( in_mask(whitelist, ports) == std::vector<bool>{false, true, true} );
+        REQUIRE( in_any(whitelist, ports) );
+        REQUIRE_FALSE( in_all(whitelist, ports) );
+        REQUIRE( in_all(whitelist, std::vector<int>{443, 80}) );
+        REQUIRE_FALSE( in_any(whitelist, std::vector<int>{1, 2}) );
+    }
+
+    SECTION(" no needles ") {
+        std::vector<int> none;
+
+        REQUIRE( in_mask(whitelist, none).empty() );
+        REQUIRE_FALSE( in_any(whitelist, none) );
+        REQUIRE( in_all(whitelist, none) );
+    }
+
+    SECTION(" enough needles to index the haystack ") {
+        std::vector<int> haystack(1000);
+        std::iota(haystack.rbegin(), haystack.rend(), 0); // unsorted on purpose
+        std::vector<int> needles(3*in_batch_threshold);
+        std::iota(needles.begin(), needles.end(), 990);
+
+        auto mask = in_mask(haystack, needles);
+        REQUIRE( mask.size() == needles.size() );
+        for( std::size_t i = 0; i < needles.size(); ++i ) {
+            REQUIRE( mask[i] == (needles[i] < 1000) );
+        }
+        REQUIRE( in_any(haystack, needles) );
+        REQUIRE_FALSE( in_all(haystack, needles) );
+    }
+
+    SECTION(" hashable values ") {
+        std::list<std::string> haystack;
+        std::vector<std::string> needles;
+        for( std::size_t i = 0; i < 2*in_batch_threshold; ++i ) {
+            haystack.push_back(std::to_string(2*i));
+            needles.push_back(std::to_string(i));
+        }
+
+        auto mask = in_mask(haystack, needles);
+        for( std::size_t i = 0; i < needles.size(); ++i ) {
+            REQUIRE( mask[i] == (i % 2 == 0) );
+        }
+    }
+
+    SECTION(" needles of another type, below and above the threshold ") {
+        std::vector<std::uint8_t> bytes = {44, 1, 2};
+        std::vector<float> floats = {0.1f, 0.5f, std::numeric_limits<float>::quiet_NaN()};
+        for( std::size_t count : {std::size_t(1), in_batch_threshold - 1, in_batch_threshold, 2*in_batch_threshold} ) {
+            std::vector<int> ints(count, 300);
+            ints[0] = 1;
+            std::vector<double> doubles(count, 0.1);
+            doubles[0] = 0.5;
+
+            auto mask = in_mask(bytes, ints);
+            REQUIRE( mask.size() == count );
+            REQUIRE( mask[0] );
+            REQUIRE( std::count(mask.begin(), mask.end(), true) == 1 );
+            REQUIRE( in_all(bytes, ints) == (count == 1) );
+
+            mask = in_mask(floats, doubles);
+            REQUIRE( mask[0] );
+            REQUIRE( std::count(mask.begin(), mask.end(), true) == 1 );
+            REQUIRE( in_any(floats, doubles) );
+        }
+    }
+
+    SECTION(" NaN needles, below and above the threshold ") {
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        std::vector<double> haystack {1, 2, 3};
+        for( std::size_t count : {std::size_t(3), in_batch_threshold, 2*in_batch_threshold} ) {
+            std::vector<double> needles(count, nan);
+            auto mask = in_mask(haystack, needles);
+            REQUIRE( mask.size() == count );
+            REQUIRE( std::count(mask.begin(), mask.end(), true) == 0 );
+            REQUIRE_FALSE( in_any(haystack, needles) );
+
+            needles.back() = 2;
+            REQUIRE( in_mask(haystack, needles).back() );
+            REQUIRE( in_any(haystack, needles) );
+        }
+    }
+
+    SECTION(" containers with their own lookup ") {
+        std::map<char, std::string> container { {'a', "alpha"}, {'b', "bravo"} };
+        REQUIRE( in_mask(container, std::string("abc")) == std::vector<bool>{true, true, false} );
+        REQUIRE( in_all(sorted(whitelist), std::set<int>{80, 8080}) );
+    }
+}
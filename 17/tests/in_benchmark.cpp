@@ -0,0 +1,59 @@
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include "catch.hpp"
+#include "../headers/in.h"
+
+
+TEST_CASE(" in: linear, SIMD and sorted lookups ", "[.][benchmark][in]") {
+
+    std::vector<std::int32_t> haystack(50'000);
+    std::iota(haystack.begin(), haystack.end(), 0);
+    std::vector<std::int32_t> needles(1'000);
+    for( std::size_t i = 0; i < needles.size(); ++i ) needles[i] = static_cast<std::int32_t>((i * 7919) % 100'000);
+
+    std::size_t expected = 0;
+    for( auto needle : needles ) expected += std::find(haystack.cbegin(), haystack.cend(), needle) != haystack.cend();
+
+    BENCHMARK(" std::find ") {
+        std::size_t found = 0;
+        for( auto needle : needles ) found += std::find(haystack.cbegin(), haystack.cend(), needle) != haystack.cend();
+        REQUIRE( found == expected );
+    }
+
+    BENCHMARK(" in() ") {
+        std::size_t found = 0;
+        for( auto needle : needles ) found += in(haystack, needle);
+        REQUIRE( found == expected );
+    }
+
+    BENCHMARK(" in(sorted()) ") {
+        std::size_t found = 0;
+        for( auto needle : needles ) found += in(sorted(haystack), needle);
+        REQUIRE( found == expected );
+    }
+}
+
+
+TEST_CASE(" in: one needle at a time vs batch ", "[.][benchmark][in]") {
+
+    std::vector<std::int32_t> haystack(50'000);
+    std::iota(haystack.rbegin(), haystack.rend(), 0);
+    std::vector<std::int32_t> needles(10'000);
+    for( std::size_t i = 0; i < needles.size(); ++i ) needles[i] = static_cast<std::int32_t>((i * 7919) % 100'000);
+
+    std::size_t expected = 0;
+    for( auto needle : needles ) expected += in(haystack, needle);
+
+    BENCHMARK(" in() per needle ") {
+        std::size_t found = 0;
+        for( auto needle : needles ) found += in(haystack, needle);
+        REQUIRE( found == expected );
+    }
+
+    BENCHMARK(" in_mask() ") {
+        auto mask = in_mask(haystack, needles);
+        REQUIRE( static_cast<std::size_t>(std::count(mask.cbegin(), mask.cend(), true)) == expected );
+    }
+}
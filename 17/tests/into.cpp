@@ -1,3 +1,4 @@
+#include <string>
 #include <vector>
 
 #include "catch.hpp"
@@ -40,3 +41,41 @@ SCENARIO( " 'into' with a unary fn ", "[into], [transform]") {
 }
 
 
+
+SCENARIO( " parallel 'into' with a unary fn ", "[into], [transform], [parallel]") {
+
+    GIVEN(" a std::vector<int> ") {
+
+        std::vector<int> vi(10'000);
+        for( std::size_t i = 0; i < vi.size(); ++i ) vi[i] = static_cast<int>(i);
+
+        WHEN(" transformed in parallel into a std::vector<std::string> ") {
+            auto to_string = [](const int& i) { return std::to_string(i); };
+            auto strings = into<std::vector<std::string>>(parallel_policy{8, 1}, to_string, vi);
+
+            THEN(" must match in size, content and order ") {
+                REQUIRE( strings.size() == vi.size() );
+                REQUIRE( strings == into<std::vector<std::string>>(to_string, vi) );
+            }
+        }
+
+        WHEN(" transformed in parallel into a std::string ") {
+            auto digit = [](const int& i) { return static_cast<char>('0' + i % 10); };
+            auto digits = into<std::string>(parallel_policy{8, 1}, digit, vi);
+
+            THEN(" it matches the sequential transform ") {
+                REQUIRE( digits.size() == vi.size() );
+                REQUIRE( digits == into<std::string>(digit, vi) );
+            }
+        }
+
+        WHEN(" transformed in parallel into a std::vector<bool> ") {
+            auto odd = [](const int& i) { return i % 2 == 1; };
+            auto bits = into<std::vector<bool>>(parallel_policy{8, 1}, odd, vi);
+
+            THEN(" it matches the sequential transform ") {
+                REQUIRE( bits == into<std::vector<bool>>(odd, vi) );
+            }
+        }
+    }
+}
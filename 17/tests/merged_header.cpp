@@ -39,4 +39,11 @@ TEST_CASE(" make sure merged header has all the interfaces ", " [merged] ") {
         REQUIRE( str == "1234" );
     }
 
+    SECTION(" pipeline ") {
+        auto even = [](int i) { return i % 2 == 0; };
+        auto str = container | filter(even) | transform([](int i) { return (char)(i+48); }) | into<std::string>();
+
+        REQUIRE( str == "24" );
+    }
+
 }
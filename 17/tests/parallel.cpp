@@ -0,0 +1,128 @@
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "catch.hpp"
+#include "../headers/enumerate.h"
+#include "../headers/parallel.h"
+
+
+TEST_CASE(" chunk_count ", " [parallel] ") {
+
+    REQUIRE( chunk_count(parallel_policy{4, 10}, 0) == 1 );
+    REQUIRE( chunk_count(parallel_policy{4, 10}, 25) == 2 );
+    REQUIRE( chunk_count(parallel_policy{4, 10}, 1000) == 4 );
+    REQUIRE( chunk_count(parallel_policy{1, 1}, 1000) == 1 );
+    REQUIRE( chunk_count(par, 1) == 1 );
+
+    // the grain is left to the caller unless the policy sets one
+    REQUIRE( chunk_count(parallel_policy{4}, 1000) == 1 );
+    REQUIRE( chunk_count(parallel_policy{4}, 4 * default_grain) == 4 );
+    REQUIRE( chunk_count(parallel_policy{4}, 10, 1) == 4 );
+    REQUIRE( chunk_count(parallel_policy{4, 5}, 10, 1) == 2 );
+}
+
+
+TEST_CASE(" parallel_chunks ", " [parallel] ") {
+
+    SECTION(" every index is visited exactly once ") {
+        for( std::size_t chunks : {1, 2, 3, 7, 16} ) {
+            std::vector<std::atomic<int>> visits(1001);
+            std::vector<int> chunk_seen(chunks, 0);
+            parallel_chunks(chunks, visits.size(), [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+                ++chunk_seen[chunk];
+                for( auto i = begin; i < end; ++i ) ++visits[i];
+            });
+            for( auto& visit : visits ) REQUIRE( visit == 1 );
+            for( auto seen : chunk_seen ) REQUIRE( seen == 1 );
+        }
+    }
+
+    SECTION(" exceptions reach the caller ") {
+        auto throwing = [](std::size_t chunk, std::size_t, std::size_t) {
+            if( chunk == 2 ) throw std::runtime_error("chunk 2");
+        };
+        REQUIRE_THROWS_AS( parallel_chunks(4, 100, throwing), std::runtime_error );
+    }
+
+    SECTION(" nested calls don't deadlock ") {
+        std::atomic<int> total{0};
+        parallel_chunks(8, 8, [&](std::size_t, std::size_t, std::size_t) {
+            parallel_chunks(8, 8, [&](std::size_t, std::size_t begin, std::size_t end) {
+                total += static_cast<int>(end - begin);
+            });
+        });
+        REQUIRE( total == 64 );
+    }
+}
+
+
+TEST_CASE(" parallel_for ", " [parallel] [parallel_for] ") {
+
+    SECTION(" every (index, value) pair is visited exactly once ") {
+        for( std::size_t size : {0, 1, 7, 100, 1001} ) {
+            std::vector<int> values(size);
+            for( std::size_t i = 0; i < size; ++i ) values[i] = static_cast<int>(i) * 2;
+            std::vector<std::atomic<int>> visits(size);
+            std::atomic<int> mismatches{0};
+
+            // Catch's assertions aren't thread safe, check after the fact
+            parallel_for(parallel_policy{4, 1}, enumerate(values), [&](auto&& indexed) {
+                if( indexed.second != static_cast<int>(indexed.first) * 2 ) ++mismatches;
+                ++visits[indexed.first];
+            });
+            for( auto& visit : visits ) REQUIRE( visit == 1 );
+            REQUIRE( mismatches == 0 );
+        }
+    }
+
+    SECTION(" skewed work is stolen, the index stays global ") {
+        std::vector<std::atomic<int>> visits(512);
+        std::atomic<std::size_t> lowest{1000000};
+        parallel_for(parallel_policy{8, 1}, enumerate(visits, 1000), [&](auto&& indexed) {
+            // the first elements cost far more than the others
+            volatile std::size_t spin = indexed.first < 1016 ? 20000 : 0;
+            while( spin ) spin = spin - 1;
+            ++indexed.second;
+            for( auto seen = lowest.load(); indexed.first < seen && !lowest.compare_exchange_weak(seen, indexed.first); ) {}
+        });
+        for( auto& visit : visits ) REQUIRE( visit == 1 );
+        REQUIRE( lowest == 1000 );
+    }
+
+    SECTION(" values are written through ") {
+        std::vector<int> values(10000, 1);
+        parallel_for(parallel_policy{4, 16}, values, [](int& value) { value *= 3; });
+        for( auto value : values ) REQUIRE( value == 3 );
+
+        parallel_for(enumerate(values), [](auto&& indexed) { indexed.second = static_cast<int>(indexed.first); });
+        for( std::size_t i = 0; i < values.size(); ++i ) REQUIRE( values[i] == static_cast<int>(i) );
+    }
+
+    SECTION(" exceptions reach the caller ") {
+        std::vector<int> values(1000);
+        auto throwing = [](auto&& indexed) {
+            if( indexed.first == 500 ) throw std::runtime_error("element 500");
+        };
+        REQUIRE_THROWS_AS( parallel_for(parallel_policy{4, 1}, enumerate(values), throwing), std::runtime_error );
+    }
+}
+
+
+TEST_CASE(" work stealing blocks ", " [parallel] [parallel_for] ") {
+
+    WorkStealingBlocks work(3, 10);
+    std::vector<int> runs(10, 0);
+    std::size_t block;
+
+    // thread 0 runs its own blocks first, in order
+    REQUIRE( work.next(0, block) );
+    REQUIRE( block == 0 );
+    ++runs[block];
+
+    // then everything, thread 0 steals the rest
+    while( work.next(0, block) ) ++runs[block];
+    REQUIRE_FALSE( work.next(1, block) );
+    REQUIRE_FALSE( work.next(2, block) );
+    for( auto run : runs ) REQUIRE( run == 1 );
+}
@@ -0,0 +1,76 @@
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "catch.hpp"
+#include "../headers/enumerate.h"
+#include "../headers/filter.h"
+#include "../headers/iterator_cast.h"
+
+
+TEST_CASE(" parallel filter and into: scaling with threads ", "[.][benchmark][parallel]") {
+
+    std::vector<long long> records(20'000'000);
+    for( std::size_t i = 0; i < records.size(); ++i ) records[i] = static_cast<long long>(i * 2654435761u % 1'000'003);
+
+    auto keep = [](long long record) { return record % 7 < 3; };
+    auto transform = [](long long record) { return static_cast<double>(record) * 1.5 + 1.0; };
+    const auto expected = filter(keep, records).size();
+
+    const std::size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    for( std::size_t threads = 1; threads <= max_threads; threads *= 2 ) {
+        const parallel_policy policy{threads};
+        // BENCHMARK keeps a reference to its name
+        const std::string filter_name = " filter with " + std::to_string(threads) + " thread(s) ";
+        const std::string into_name = " into with " + std::to_string(threads) + " thread(s) ";
+
+        BENCHMARK(filter_name) {
+            REQUIRE( filter(policy, keep, records).size() == expected );
+        }
+
+        BENCHMARK(into_name) {
+            REQUIRE( into<std::vector<double>>(policy, transform, records).size() == records.size() );
+        }
+    }
+}
+
+
+TEST_CASE(" parallel_for over enumerate: skewed workload ", "[.][benchmark][parallel]") {
+
+    // the cost of an element grows with its index, so the last chunk of an even split is by far the longest
+    std::vector<double> values(20'000);
+    auto work = [](std::pair<std::size_t, double&> indexed) {
+        double x = static_cast<double>(indexed.first);
+        for( std::size_t i = 0; i < indexed.first / 8; ++i ) x = std::sqrt(x + 1.0);
+        indexed.second = x;
+    };
+    auto checksum = [&values] { return std::accumulate(values.begin(), values.end(), 0.0); };
+
+    for( auto&& indexed : enumerate(values) ) work(indexed);
+    const double expected = checksum();
+
+    const std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    const parallel_policy policy{threads, 1};
+
+    BENCHMARK(" serial loop ") {
+        for( auto&& indexed : enumerate(values) ) work(indexed);
+        REQUIRE( checksum() == expected );
+    }
+
+    BENCHMARK(" even split, one chunk per thread ") {
+        auto first = enumerate(values).begin();
+        parallel_chunks(threads, values.size(), [&](std::size_t, std::size_t begin, std::size_t end) {
+            for( auto i = begin; i < end; ++i ) work(first[static_cast<std::ptrdiff_t>(i)]);
+        });
+        REQUIRE( checksum() == expected );
+    }
+
+    BENCHMARK(" parallel_for, work stealing ") {
+        parallel_for(policy, enumerate(values), work);
+        REQUIRE( checksum() == expected );
+    }
+}
@@ -0,0 +1,123 @@
+#include <forward_list>
+#include <list>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "catch.hpp"
+#include "../headers/pipeline.h"
+
+
+auto is_even = [](int i) { return i % 2 == 0; };
+auto square = [](int i) { return i * i; };
+
+
+SCENARIO(" lazy pipelines ", " [pipeline] ") {
+
+    GIVEN(" a std::vector<int> vi = {1,2,3,4,5,6} ") {
+
+        std::vector<int> vi = {1,2,3,4,5,6};
+
+        WHEN(" filtering and transforming into a std::vector ") {
+
+            auto squares = vi | filter(is_even) | transform(square) | into<std::vector<int>>();
+
+            THEN(" only even numbers were squared ") {
+                REQUIRE( squares == std::vector<int>{4, 16, 36} );
+            }
+        }
+
+        WHEN(" enumerating the output of a filter ") {
+
+            auto indexed = vi | filter(is_even) | enumerate() | into<std::vector<std::pair<std::size_t, int>>>();
+
+            THEN(" indices count the filtered elements ") {
+                REQUIRE( indexed == std::vector<std::pair<std::size_t, int>>{ {0, 2}, {1, 4}, {2, 6} } );
+            }
+        }
+
+        WHEN(" taking the first elements ") {
+
+            THEN(" take stops early ") {
+                REQUIRE( (vi | take(2) | into<std::vector<int>>()) == std::vector<int>{1, 2} );
+                REQUIRE( (vi | take(0) | into<std::vector<int>>()).empty() );
+                REQUIRE( (vi | take(100) | into<std::vector<int>>()) == vi );
+            }
+        }
+
+        WHEN(" iterating a pipeline with a range-for ") {
+
+            std::vector<std::pair<std::size_t, int>> seen;
+            for( auto&& [index, value] : vi | filter(is_even) | transform(square) | enumerate() | take(2) ) {
+                seen.emplace_back(index, value);
+            }
+
+            THEN(" each stage ran once per element ") {
+                REQUIRE( seen == std::vector<std::pair<std::size_t, int>>{ {0, 4}, {1, 16} } );
+            }
+        }
+
+        WHEN(" writing through a pipeline ") {
+
+            for( auto&& [index, value] : vi | filter(is_even) | enumerate() ) {
+                value = static_cast<int>(index);
+            }
+
+            THEN(" the source container was modified ") {
+                REQUIRE( vi == std::vector<int>{1, 0, 3, 1, 5, 2} );
+            }
+        }
+
+        WHEN(" filtering the output of enumerate ") {
+
+            auto odd_index = [](const auto& pair) { return pair.first % 2 == 1; };
+            auto second = [](const auto& pair) { return pair.second; };
+            auto values = vi | enumerate() | filter(odd_index) | transform(second) | into<std::vector<int>>();
+
+            THEN(" the values at odd indices remain ") {
+                REQUIRE( values == std::vector<int>{2, 4, 6} );
+            }
+        }
+    }
+
+    GIVEN(" stages counting their calls ") {
+
+        std::vector<int> vi(1000);
+        for( std::size_t i = 0; i < vi.size(); ++i ) vi[i] = static_cast<int>(i);
+        std::size_t filtered = 0, transformed = 0;
+        auto counting_filter = [&filtered](int i) { ++filtered; return i % 2 == 0; };
+        auto counting_transform = [&transformed](int i) { ++transformed; return i + 1; };
+
+        WHEN(" only the first 3 elements are taken ") {
+
+            auto first = vi | filter(counting_filter) | transform(counting_transform) | take(3) | into<std::vector<int>>();
+
+            THEN(" nothing past the third element was computed ") {
+                REQUIRE( first == std::vector<int>{1, 3, 5} );
+                REQUIRE( filtered == 5 );
+                REQUIRE( transformed == 3 );
+            }
+        }
+    }
+
+    GIVEN(" a temporary source ") {
+
+        auto make_words = [] { return std::list<std::string>{"yo", "mama", "so", "fat"}; };
+
+        THEN(" the pipeline owns it ") {
+            auto pipeline = make_words() | filter([](const std::string& word) { return word.size() == 2; });
+            REQUIRE( (pipeline | into<std::set<std::string>>()) == std::set<std::string>{"so", "yo"} );
+        }
+    }
+
+    GIVEN(" a single pass friendly source ") {
+
+        std::forward_list<int> fl {1,2,3,4};
+
+        THEN(" a pipeline can materialize into a std::string ") {
+            auto to_char = [](int i) { return static_cast<char>('0' + i); };
+            REQUIRE( (fl | transform(to_char) | into<std::string>()) == "1234" );
+        }
+    }
+}
@@ -0,0 +1,121 @@
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "catch.hpp"
+#include "../headers/predicates.h"
+
+
+TEST_CASE(" comparison predicates ", " [predicates] ") {
+
+    REQUIRE( eq(3)(3) );
+    REQUIRE_FALSE( eq(3)(4) );
+    REQUIRE( ne(3)(4) );
+    REQUIRE( lt(3)(2) );
+    REQUIRE_FALSE( lt(3)(3) );
+    REQUIRE( le(3)(3) );
+    REQUIRE( gt(3)(4) );
+    REQUIRE_FALSE( gt(3)(3) );
+    REQUIRE( ge(3)(3) );
+    REQUIRE( between(1, 3)(1) );
+    REQUIRE( between(1, 3)(3) );
+    REQUIRE_FALSE( between(1, 3)(4) );
+
+    REQUIRE( is_comparison<decltype(gt(1.0f))>::value );
+    auto lambda = [](int i) { return i > 1; };
+    REQUIRE_FALSE( is_comparison<decltype(lambda)>::value );
+}
+
+
+template<simd::compare op, class T>
+void require_same_as_scalar(const std::vector<T>& values, T a, T b) {
+    for( std::size_t size : {0, 1, 3, 4, 7, 8, 9, 15, 16, 17, 100, 1000} ) {
+        std::vector<T> expected;
+        for( std::size_t i = 0; i < size; ++i ) {
+            if( simd::test<op>(values[i], a, b) ) expected.push_back(values[i]);
+        }
+
+        std::vector<T> in_place(values.begin(), values.begin() + size);
+        auto last = simd::compact<op>(in_place.data(), in_place.data() + size, in_place.data(), a, b);
+        in_place.resize(last - in_place.data());
+        REQUIRE( in_place == expected );
+
+        std::vector<T> out(size);
+        last = simd::compact<op>(values.data(), values.data() + size, out.data(), a, b);
+        out.resize(last - out.data());
+        REQUIRE( out == expected );
+
+#ifdef VIPER_X86_SIMD
+        // simd::compact picks the best kernel for this CPU, check the others too
+        if constexpr( sizeof(T) == 4 || sizeof(T) == 8 ) {
+            if( simd::supported() >= simd::level::avx2 ) {
+                std::vector<T> avx2(size);
+                last = simd::compact_avx2<op>(values.data(), values.data() + size, avx2.data(), a, b);
+                avx2.resize(last - avx2.data());
+                REQUIRE( avx2 == expected );
+            }
+            if( simd::supported() >= simd::level::avx512 ) {
+                std::vector<T> avx512(values.begin(), values.begin() + size);
+                last = simd::compact_avx512<op>(avx512.data(), avx512.data() + size, avx512.data(), a, b);
+                avx512.resize(last - avx512.data());
+                REQUIRE( avx512 == expected );
+            }
+        }
+#endif
+    }
+}
+
+
+template<class T>
+void require_all_comparisons(T a, T b) {
+    std::mt19937 random(42);
+    std::vector<T> values(1000);
+    // a small range, so that equality happens
+    for( auto& value : values ) value = static_cast<T>(a + static_cast<T>(random() % 16)) - static_cast<T>(4);
+
+    require_same_as_scalar<simd::compare::eq>(values, a, b);
+    require_same_as_scalar<simd::compare::ne>(values, a, b);
+    require_same_as_scalar<simd::compare::lt>(values, a, b);
+    require_same_as_scalar<simd::compare::le>(values, a, b);
+    require_same_as_scalar<simd::compare::gt>(values, a, b);
+    require_same_as_scalar<simd::compare::ge>(values, a, b);
+    require_same_as_scalar<simd::compare::between>(values, a, b);
+}
+
+
+TEST_CASE(" stream compaction ", " [predicates], [simd] ") {
+
+    SECTION(" 32 bit lanes ") {
+        require_all_comparisons<std::int32_t>(-2, 5);
+        require_all_comparisons<std::uint32_t>(4, 9);
+        require_all_comparisons<float>(-2.0f, 5.0f);
+    }
+
+    SECTION(" 64 bit lanes ") {
+        require_all_comparisons<std::int64_t>(-2, 5);
+        require_all_comparisons<std::uint64_t>(4, 9);
+        require_all_comparisons<double>(-2.0, 5.0);
+    }
+
+    SECTION(" 8 and 16 bit lanes use the scalar kernel ") {
+        require_all_comparisons<std::int8_t>(-2, 5);
+        require_all_comparisons<std::uint16_t>(4, 9);
+    }
+
+    SECTION(" unsigned values above the signed range ") {
+        const std::uint32_t big = std::numeric_limits<std::uint32_t>::max() - 3;
+        std::vector<std::uint32_t> values {1, big, 2, big + 1, 3, big + 2, 4, big + 3, 5};
+        auto last = simd::compact<simd::compare::gt>(values.data(), values.data() + values.size(), values.data(), 10u, 10u);
+        REQUIRE( std::vector<std::uint32_t>(values.data(), last) == std::vector<std::uint32_t>{big, big + 1, big + 2, big + 3} );
+    }
+
+    SECTION(" NaN never passes ordered comparisons ") {
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        std::vector<float> values(16, nan);
+        values[3] = 1.0f;
+        auto last = simd::compact<simd::compare::ge>(values.data(), values.data() + values.size(), values.data(), 0.0f, 0.0f);
+        REQUIRE( last - values.data() == 1 );
+        REQUIRE( values[0] == 1.0f );
+    }
+}
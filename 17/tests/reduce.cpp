@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "catch.hpp"
+#include "../headers/reduce.h"
+
+
+// whether an unqualified max(x) picks up one of Viper's reductions
+template<class T, class = void>
+struct has_max : std::false_type {};
+
+template<class T>
+struct has_max<T, std::void_t<decltype(max(std::declval<const T&>()))>> : std::true_type {};
+
+
+TEST_CASE(" reductions of rows and columns ", "[reduce]") {
+
+    std::array<int, 12> fixed { 3, 1, 4, 1,
+                                5, 9, 2, 6,
+                                5, 3, 5, 8 };
+
+    SECTION(" compile-time views ") {
+        REQUIRE( sum(row<1, 3, 4>(fixed)) == 22 );
+        REQUIRE( min(row<0, 3, 4>(fixed)) == 1 );
+        REQUIRE( max(row<2, 3, 4>(fixed)) == 8 );
+        REQUIRE( sum(col<1, 3, 4>(fixed)) == 13 );
+        REQUIRE( min(col<3, 3, 4>(fixed)) == 1 );
+        REQUIRE( max(col<0, 3, 4>(fixed)) == 5 );
+        REQUIRE( dot(row<0, 3, 4>(fixed), row<1, 3, 4>(fixed)) == 15 + 9 + 8 + 6 );
+        REQUIRE( dot(col<0, 3, 4>(fixed), col<2, 3, 4>(fixed)) == 12 + 10 + 25 );
+
+        // the columns of a column-major grid are contiguous
+        REQUIRE( is_contiguous_view<decltype(col<1, 4, 3, column_major>(fixed))>::value );
+        REQUIRE_FALSE( is_contiguous_view<decltype(row<1, 4, 3, column_major>(fixed))>::value );
+        REQUIRE( sum(col<1, 4, 3, column_major>(fixed)) == 5 + 9 + 2 + 6 );
+        REQUIRE( max(row<1, 4, 3, column_major>(fixed)) == 9 );
+    }
+
+    SECTION(" runtime views ") {
+        auto g = grid(fixed, 3, 4);
+        REQUIRE( sum(g.row(2)) == 21 );
+        REQUIRE( max(g.col(1)) == 9 );
+        REQUIRE( min(g.block(1, 1, 2, 3).row(1)) == 3 );
+        REQUIRE( sum(g.cols()) == (std::vector<int>{13, 13, 11, 15}) );
+        REQUIRE( max(g.cols()) == (std::vector<int>{5, 9, 5, 8}) );
+        REQUIRE( min(g.rows()) == (std::vector<int>{1, 2, 3}) );
+        REQUIRE( sum(g.block(0, 1, 3, 2).cols()) == (std::vector<int>{13, 11}) );
+    }
+
+    SECTION(" containers without data() ") {
+        std::deque<int> dq(fixed.begin(), fixed.end());
+        auto g = grid(dq, 3, 4);
+        REQUIRE( sum(g.row(1)) == 22 );
+        REQUIRE( sum(row<1, 3, 4>(dq)) == 22 );
+        REQUIRE( min(g.cols()) == (std::vector<int>{3, 1, 2, 1}) );
+        REQUIRE( dot(g.col(0), g.col(0)) == 59 );
+    }
+
+    SECTION(" empty views ") {
+        std::vector<float> empty;
+        REQUIRE( sum(row(empty, 0, 0, 0)) == 0.f );
+        REQUIRE( sum(grid(empty, 0, 0).cols()).empty() );
+    }
+
+    SECTION(" only rows and columns are reduced ") {
+        REQUIRE( has_max<RowView<int*>>::value );
+        REQUIRE( has_max<ColumnView<const float*>>::value );
+        REQUIRE( has_max<decltype(col<1, 3, 4>(fixed))>::value );
+        REQUIRE( has_max<decltype(grid(fixed, 3, 4).cols())>::value );
+        REQUIRE_FALSE( has_max<std::vector<int>>::value );
+        REQUIRE_FALSE( has_max<std::array<int, 12>>::value );
+        REQUIRE_FALSE( has_max<int>::value );
+    }
+}
+
+
+template<class T>
+void require_same_as_scalar(std::size_t rows, std::size_t cols) {
+    // small integers, so that float sums are exact whatever the order of the additions
+    std::vector<T> values(rows * cols);
+    for( std::size_t i = 0; i < values.size(); ++i ) values[i] = static_cast<T>(static_cast<int>(i * 7919 % 61) - 30);
+    auto g = grid(values, rows, cols);
+
+    std::vector<T> sums(cols, T()), minima(cols), maxima(cols);
+    for( std::size_t c = 0; c < cols; ++c ) {
+        auto column = g.col(c);
+        sums[c] = std::accumulate(column.begin(), column.end(), T());
+        minima[c] = *std::min_element(column.begin(), column.end());
+        maxima[c] = *std::max_element(column.begin(), column.end());
+    }
+    REQUIRE( sum(g.cols()) == sums );
+    REQUIRE( min(g.cols()) == minima );
+    REQUIRE( max(g.cols()) == maxima );
+
+    for( std::size_t r = 0; r < rows; ++r ) {
+        auto row = g.row(r);
+        REQUIRE( sum(row) == std::accumulate(row.begin(), row.end(), T()) );
+        REQUIRE( min(row) == *std::min_element(row.begin(), row.end()) );
+        REQUIRE( max(row) == *std::max_element(row.begin(), row.end()) );
+        REQUIRE( dot(row, g.row(0)) == std::inner_product(row.begin(), row.end(), g.row(0).begin(), T()) );
+    }
+}
+
+
+TEST_CASE(" SIMD reductions agree with the scalar ones ", "[reduce] [simd]") {
+    for( std::size_t rows : {1, 2, 7, 33} ) {
+        for( std::size_t cols : {1, 5, 8, 31, 32, 33, 64, 100, 257} ) {
+            require_same_as_scalar<float>(rows, cols);
+            require_same_as_scalar<double>(rows, cols);
+            require_same_as_scalar<std::int32_t>(rows, cols);
+            require_same_as_scalar<std::int64_t>(rows, cols);
+        }
+    }
+}
+
+
+template<class T>
+void require_nan_propagates() {
+    const T nan = std::numeric_limits<T>::quiet_NaN();
+    // shorter and longer than the four registers the SIMD kernels start with, NaN first, in the middle, in the tail
+    for( std::size_t size : {1, 5, 8, 31, 32, 33, 64, 100} ) {
+        for( std::size_t at : {std::size_t(0), size / 2, size - 1} ) {
+            std::vector<T> values(size);
+            std::iota(values.begin(), values.end(), T(1));
+            values[at] = nan;
+            auto line = row(values, 0, 1, size);
+            REQUIRE( std::isnan(max(line)) );
+            REQUIRE( std::isnan(min(line)) );
+
+            // the same values as a column, among columns without NaN
+            std::vector<T> block(size * 40, T(1));
+            for( std::size_t r = 0; r < size; ++r ) block[r*40 + 17] = values[r];
+            auto maxima = max(grid(block, size, 40).cols());
+            auto minima = min(grid(block, size, 40).cols());
+            for( std::size_t c = 0; c < 40; ++c ) {
+                REQUIRE( std::isnan(maxima[c]) == (c == 17) );
+                REQUIRE( std::isnan(minima[c]) == (c == 17) );
+            }
+        }
+    }
+}
+
+
+TEST_CASE(" min and max of values with a NaN are NaN, whatever their number ", "[reduce] [simd]") {
+    require_nan_propagates<float>();
+    require_nan_propagates<double>();
+}
@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "catch.hpp"
+#include "../headers/reduce.h"
+
+
+TEST_CASE(" reductions: iterator loops vs SIMD ", "[.][benchmark][reduce]") {
+
+    const std::size_t rows = 4096, cols = 4096;
+    std::vector<float> buffer(rows * cols);
+    for( std::size_t i = 0; i < buffer.size(); ++i ) buffer[i] = static_cast<float>(i % 7);
+    auto g = grid(buffer, rows, cols);
+
+    // small integers, the float sums are exact whatever the order of the additions
+    std::vector<float> expected(cols, 0.f);
+    for( auto row : g.rows() ) {
+        for( std::size_t c = 0; c < cols; ++c ) expected[c] += row[c];
+    }
+
+    BENCHMARK(" row sums, range-for ") {
+        std::vector<float> sums(rows);
+        for( std::size_t r = 0; r < rows; ++r ) {
+            for( auto element : g.row(r) ) sums[r] += element;
+        }
+        REQUIRE( sums[0] > 0.f );
+    }
+
+    BENCHMARK(" row sums, sum(rows()) ") {
+        REQUIRE( sum(g.rows())[0] > 0.f );
+    }
+
+    BENCHMARK(" column sums, range-for over col views ") {
+        std::vector<float> sums(cols);
+        for( std::size_t c = 0; c < cols; ++c ) {
+            for( auto element : g.col(c) ) sums[c] += element;
+        }
+        REQUIRE( sums == expected );
+    }
+
+    BENCHMARK(" column sums, sum(cols()) ") {
+        REQUIRE( sum(g.cols()) == expected );
+    }
+
+    BENCHMARK(" column maxima, range-for over col views ") {
+        std::vector<float> maxima(cols);
+        for( std::size_t c = 0; c < cols; ++c ) {
+            for( auto element : g.col(c) ) maxima[c] = std::max(maxima[c], element);
+        }
+        REQUIRE( maxima[0] == 6.f );
+    }
+
+    BENCHMARK(" column maxima, max(cols()) ") {
+        REQUIRE( max(g.cols())[0] == 6.f );
+    }
+
+    BENCHMARK(" dot products of rows, loops ") {
+        float total = 0.f;
+        for( std::size_t r = 0; r < rows; ++r ) {
+            auto row = g.row(r);
+            auto first = g.row(0).begin();
+            for( auto element : row ) total += element * *first++;
+        }
+        REQUIRE( total > 0.f );
+    }
+
+    BENCHMARK(" dot products of rows, dot() ") {
+        float total = 0.f;
+        for( auto row : g.rows() ) total += dot(row, g.row(0));
+        REQUIRE( total > 0.f );
+    }
+
+    // the compile-time views walk their columns with std::advance
+    static std::array<float, 512*512> fixed;
+    std::copy_n(buffer.begin(), fixed.size(), fixed.begin());
+
+    BENCHMARK(" sum of a compile-time row, range-for ") {
+        float total = 0.f;
+        for( int i = 0; i < 1000; ++i ) {
+            for( auto element : row<7, 512, 512>(fixed) ) total += element;
+        }
+        REQUIRE( total > 0.f );
+    }
+
+    BENCHMARK(" sum of a compile-time row, sum() ") {
+        float total = 0.f;
+        for( int i = 0; i < 1000; ++i ) total += sum(row<7, 512, 512>(fixed));
+        REQUIRE( total > 0.f );
+    }
+}
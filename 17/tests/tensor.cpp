@@ -0,0 +1,114 @@
+#include <array>
+#include <deque>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+#include "catch.hpp"
+#include "../headers/tensor.h"
+
+
+TEST_CASE(" tensor ", "[tensor]") {
+
+    // time x sensor x channel, the value of each element is its offset in the container
+    const std::size_t time = 4, sensors = 3, channels = 5;
+    std::vector<int> samples(time * sensors * channels);
+    std::iota(samples.begin(), samples.end(), 0);
+    auto offset = [&](std::size_t t, std::size_t s, std::size_t c) { return static_cast<int>((t*sensors + s)*channels + c); };
+
+    SECTION(" runtime extents ") {
+        auto t = tensor(samples, time, sensors, channels);
+        REQUIRE( t.rank == 3 );
+        REQUIRE( t.size() == samples.size() );
+        REQUIRE( t.extent(1) == sensors );
+        REQUIRE( t.stride(0) == static_cast<std::ptrdiff_t>(sensors * channels) );
+        REQUIRE( t.stride(2) == 1 );
+        REQUIRE( t(2, 1, 3) == offset(2, 1, 3) );
+
+        t(2, 1, 3) = -1;
+        REQUIRE( samples[static_cast<std::size_t>(offset(2, 1, 3))] == -1 );
+    }
+
+    SECTION(" compile-time extents ") {
+        auto t = tensor<4, 3, 5>(samples);
+        REQUIRE( std::is_empty_v<decltype(t)::shape_type> );
+        REQUIRE( decltype(t)::shape_type::strides_v == (std::array<std::ptrdiff_t, 3>{15, 5, 1}) );
+        REQUIRE( t(3, 2, 4) == offset(3, 2, 4) );
+
+        auto of_sensor = t.slice<1>(2);
+        REQUIRE( std::is_same_v<decltype(of_sensor)::shape_type, StaticShape<Extents<4, 5>, Strides<15, 1>>> );
+        REQUIRE( of_sensor(3, 1) == offset(3, 2, 1) );
+    }
+
+    SECTION(" slicing along every axis ") {
+        auto t = tensor(samples, time, sensors, channels);
+        for( std::size_t i = 0; i < time; ++i ) {
+            auto at_time = t[i];
+            REQUIRE( at_time.rank == 2 );
+            REQUIRE( at_time.extent(0) == sensors );
+            REQUIRE( at_time(2, 4) == offset(i, 2, 4) );
+        }
+        auto of_sensor = t.slice<1>(1);
+        REQUIRE( of_sensor.extent(0) == time );
+        REQUIRE( of_sensor.extent(1) == channels );
+        REQUIRE( of_sensor(3, 2) == offset(3, 1, 2) );
+
+        auto of_channel = t.slice(2, 4);
+        REQUIRE( of_channel.stride(1) == static_cast<std::ptrdiff_t>(channels) );
+        REQUIRE( of_channel(1, 2) == offset(1, 2, 4) );
+
+        // down to a line of elements
+        auto signal = of_sensor.slice<1>(2);
+        REQUIRE( signal.rank == 1 );
+        for( std::size_t i = 0; i < time; ++i ) REQUIRE( signal[i] == offset(i, 1, 2) );
+
+        signal[0] = -7;
+        REQUIRE( t(0, 1, 2) == -7 );
+    }
+
+    SECTION(" iteration walks memory in order ") {
+        auto t = tensor(samples, time, sensors, channels);
+        std::vector<int> visited(t.begin(), t.end());
+        REQUIRE( visited == samples );
+
+        // a slice along the contiguous axis: its elements are channels apart
+        std::vector<int> expected;
+        for( std::size_t i = 0; i < time; ++i ) {
+            for( std::size_t s = 0; s < sensors; ++s ) expected.push_back(offset(i, s, 3));
+        }
+        auto of_channel = t.slice<2>(3);
+        REQUIRE( std::vector<int>(of_channel.begin(), of_channel.end()) == expected );
+
+        std::vector<int> by_for_each;
+        for_each(of_channel, [&](int element) { by_for_each.push_back(element); });
+        REQUIRE( by_for_each == expected );
+    }
+
+    SECTION(" strides of your own ") {
+        // the same buffer seen channel x sensor x time: iteration still walks it in memory order
+        auto t = Tensor(samples.data(), DynamicShape<3>({channels, sensors, time}, {1, static_cast<std::ptrdiff_t>(channels), static_cast<std::ptrdiff_t>(sensors * channels)}));
+        REQUIRE( t(4, 2, 3) == offset(3, 2, 4) );
+        REQUIRE( t.loop_order() == (std::array<std::size_t, 3>{2, 1, 0}) );
+        REQUIRE( std::vector<int>(t.begin(), t.end()) == samples );
+
+        int sum = 0;
+        for_each(t, [&](int& element) { sum += element; element = 0; });
+        REQUIRE( sum == static_cast<int>(samples.size() * (samples.size() - 1) / 2) );
+        REQUIRE( std::accumulate(samples.begin(), samples.end(), 0) == 0 );
+    }
+
+    SECTION(" a slice of rank 2 is a grid ") {
+        auto at_time = tensor(samples, time, sensors, channels)[2];
+        auto g = at_time.as_grid();
+        REQUIRE( g.height() == sensors );
+        REQUIRE( g.width() == channels );
+        REQUIRE( g.col(3)[1] == offset(2, 1, 3) );
+    }
+
+    SECTION(" containers without data() ") {
+        std::deque<int> dq(samples.begin(), samples.end());
+        auto t = tensor(dq, time, sensors, channels);
+        REQUIRE( t.slice<1>(2)(1, 4) == offset(1, 2, 4) );
+        REQUIRE( std::vector<int>(t.begin(), t.end()) == samples );
+    }
+}
@@ -0,0 +1,138 @@
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <numeric>
+#include <vector>
+
+#include "catch.hpp"
+#include "../headers/transpose.h"
+
+
+template<class T>
+std::vector<T> numbered(std::size_t size) {
+    std::vector<T> values(size);
+    for( std::size_t i = 0; i < size; ++i ) values[i] = static_cast<T>(i % 101);
+    return values;
+}
+
+
+template<class T>
+void require_transposed(std::size_t rows, std::size_t cols) {
+    const auto in = numbered<T>(rows * cols);
+    std::vector<T> out(rows * cols);
+    transpose(grid(in, rows, cols), grid(out, cols, rows));
+    for( std::size_t r = 0; r < rows; ++r ) {
+        for( std::size_t c = 0; c < cols; ++c ) REQUIRE( out[c*rows + r] == in[r*cols + c] );
+    }
+
+    if( rows == cols ) {
+        auto square = in;
+        transpose(grid(square, rows, cols));
+        REQUIRE( square == out );
+    }
+}
+
+
+TEST_CASE(" transpose ", "[transpose]") {
+
+    SECTION(" small grids ") {
+        std::array<int, 6> in { 0, 1, 2,
+                                3, 4, 5 }, out{};
+        transpose<2, 3>(in, out);
+        REQUIRE( out == (std::array<int, 6>{ 0, 3, 1, 4, 2, 5 }) );
+
+        std::array<int, 4> square { 1, 2,
+                                    3, 4 };
+        transpose(grid(square, 2, 2));
+        REQUIRE( square == (std::array<int, 4>{ 1, 3, 2, 4 }) );
+    }
+
+    SECTION(" every size around the tiles and the leaves ") {
+        for( std::size_t rows : {0, 1, 3, 4, 7, 8, 9, 16, 31, 32, 33, 65, 100} ) {
+            for( std::size_t cols : {1, 4, 8, 13, 32, 40, 100} ) {
+                require_transposed<float>(rows, cols);
+                require_transposed<double>(rows, cols);
+            }
+        }
+        for( std::size_t size : {5, 8, 12, 33, 64, 97, 130} ) {
+            require_transposed<std::int32_t>(size, size);
+            require_transposed<std::int64_t>(size, size);
+            require_transposed<std::int8_t>(size, size);
+            require_transposed<std::uint16_t>(size, size + 3);
+        }
+    }
+
+    SECTION(" blocks of larger grids ") {
+        // a 20x30 block at (5, 7) of a 50x60 grid into a 30x20 block at (2, 3) of a 40x40 grid
+        const auto in = numbered<float>(50 * 60);
+        std::vector<float> out(40 * 40, -1.f);
+        transpose(grid(in, 50, 60).block(5, 7, 20, 30), grid(out, 40, 40).block(2, 3, 30, 20));
+        auto out_grid = grid(out, 40, 40);
+        for( std::size_t r = 0; r < 40; ++r ) {
+            for( std::size_t c = 0; c < 40; ++c ) {
+                const bool inside = r >= 2 && r < 32 && c >= 3 && c < 23;
+                REQUIRE( out_grid(r, c) == (inside ? in[(5 + c - 3)*60 + 7 + r - 2] : -1.f) );
+            }
+        }
+
+        // in place, leaving the rest of the grid alone
+        auto square = numbered<double>(70 * 80);
+        const auto before = square;
+        transpose(grid(square, 70, 80).block(1, 2, 67, 67));
+        for( std::size_t r = 0; r < 70; ++r ) {
+            for( std::size_t c = 0; c < 80; ++c ) {
+                const bool inside = r >= 1 && r < 68 && c >= 2 && c < 69;
+                REQUIRE( square[r*80 + c] == (inside ? before[(c - 2 + 1)*80 + r - 1 + 2] : before[r*80 + c]) );
+            }
+        }
+    }
+
+    SECTION(" containers without data() ") {
+        const auto values = numbered<int>(45 * 38);
+        std::deque<int> in(values.begin(), values.end()), out(values.size());
+        transpose(grid(in, 45, 38), grid(out, 38, 45));
+        for( std::size_t r = 0; r < 45; ++r ) {
+            for( std::size_t c = 0; c < 38; ++c ) REQUIRE( out[c*45 + r] == in[r*38 + c] );
+        }
+
+        std::deque<int> square(values.begin(), values.begin() + 40*40);
+        transpose(grid(square, 40, 40));
+        for( std::size_t r = 0; r < 40; ++r ) {
+            for( std::size_t c = 0; c < 40; ++c ) REQUIRE( square[c*40 + r] == values[r*40 + c] );
+        }
+    }
+}
+
+
+template<class Kernel, class T>
+void require_kernel_transposes() {
+    const std::size_t rows = 21, cols = 19, stride = 24;
+    const auto in = numbered<T>(rows * stride);
+    std::vector<T> out(cols * rows), expected(cols * rows);
+    simd::transpose_blocks<Kernel>(in.data(), stride, out.data(), rows, rows, cols);
+    simd::transpose_scalar(in.data(), stride, expected.data(), rows, rows, cols);
+    REQUIRE( out == expected );
+
+    auto square = numbered<T>(rows * stride);
+    simd::transpose_inplace_blocks<Kernel>(square.data() + 1, stride, rows);
+    for( std::size_t r = 0; r < rows; ++r ) {
+        for( std::size_t c = 0; c < rows; ++c ) REQUIRE( square[r*stride + c + 1] == in[c*stride + r + 1] );
+    }
+}
+
+
+TEST_CASE(" transpose kernels ", "[transpose] [simd]") {
+    require_kernel_transposes<simd::TransposeScalar<float>, float>();
+#ifdef VIPER_X86_SIMD
+    if( simd::supported() >= simd::level::sse42 ) {
+        require_kernel_transposes<simd::TransposeSSE42<float>, float>();
+        require_kernel_transposes<simd::TransposeSSE42<std::int32_t>, std::int32_t>();
+    }
+    if( simd::supported() >= simd::level::avx2 ) {
+        require_kernel_transposes<simd::TransposeAVX2<float>, float>();
+        require_kernel_transposes<simd::TransposeAVX2<std::uint32_t>, std::uint32_t>();
+        require_kernel_transposes<simd::TransposeAVX2<double>, double>();
+        require_kernel_transposes<simd::TransposeAVX2<std::int64_t>, std::int64_t>();
+    }
+#endif
+}
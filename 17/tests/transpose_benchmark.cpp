@@ -0,0 +1,42 @@
+#include <cstddef>
+#include <vector>
+
+#include "catch.hpp"
+#include "../headers/transpose.h"
+
+
+TEST_CASE(" transpose: through column views vs cache-oblivious ", "[.][benchmark][transpose]") {
+
+    // larger than the last level cache, and a multiple of 4KiB apart from one row to the next
+    const std::size_t rows = 8192, cols = 8192;
+    std::vector<float> in(rows * cols), out(rows * cols);
+    for( std::size_t i = 0; i < in.size(); ++i ) in[i] = static_cast<float>(i % 1009);
+    auto g = grid(in, rows, cols);
+    auto checked = [&] { return out[3*rows + 5] == in[5*cols + 3] && out.back() == in.back(); };
+
+    BENCHMARK(" copy through col views ") {
+        auto destination = out.begin();
+        for( auto column : g.cols() ) {
+            for( auto element : column ) *destination++ = element;
+        }
+        REQUIRE( checked() );
+    }
+
+    BENCHMARK(" element by element, row-major reads ") {
+        for( std::size_t r = 0; r < rows; ++r ) {
+            for( std::size_t c = 0; c < cols; ++c ) out[c*rows + r] = in[r*cols + c];
+        }
+        REQUIRE( checked() );
+    }
+
+    BENCHMARK(" transpose ") {
+        transpose(g, grid(out, cols, rows));
+        REQUIRE( checked() );
+    }
+
+    BENCHMARK(" transpose in place ") {
+        transpose(grid(in, rows, cols));
+        REQUIRE( in[3] == static_cast<float>((3*cols) % 1009) );
+        transpose(grid(in, rows, cols));
+    }
+}
@@ -1,88 +1,84 @@
-#include <utility>
-#include <functional>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <functional>
 #include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#if !defined(VIPER_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
 
 
 namespace viper {
 
-#ifndef __VIPER_RANGE__
-#define __VIPER_RANGE__
-
-
-
-template <class T>
-
-class RangeIterator {
-
-    T _value;
-
-    public:
-        constexpr RangeIterator(const T value):_value(value) {}
-
-        using difference_type = typename std::iterator_traits<T*>::difference_type;
-        using value_type = typename std::iterator_traits<T*>::value_type;
-        using pointer = typename std::iterator_traits<T*>::pointer;
-        using reference = typename std::iterator_traits<T*>::reference;
-        using iterator_category = typename std::iterator_traits<T*>::iterator_category;
-
-        constexpr inline bool operator==(const RangeIterator& rhs) const {
-            return _value == rhs._value;
-        }
+#ifndef __VIPER_TRAITS__
+#define __VIPER_TRAITS__
 
-        constexpr inline bool operator!=(const RangeIterator& rhs) const {
-            return _value != rhs._value;
-        }
 
-        constexpr inline difference_type operator-(const RangeIterator& rhs) const {
-            return _value - rhs._value;
-        }
 
-        constexpr inline T operator*() const {
-            return _value;
-        }
+/*
+ * Traits shared by several headers.
+ */
+template<class Container, class = void>
+struct has_size : std::false_type {};
 
-        constexpr inline RangeIterator& operator++() {
-            ++_value;
-            return *this;
-        }
+template<class Container>
+struct has_size<Container, std::void_t<decltype(std::declval<const Container&>().size())>> : std::true_type {};
 
-        constexpr inline auto operator++(int) {
-            auto iterator{*this};
-            operator++();
-            return iterator;
-        }
-        
-};
 
+template<class Container, class = void>
+struct has_resize : std::false_type {};
 
-template <class T>
+template<class Container>
+struct has_resize<Container, std::void_t<decltype(std::declval<Container&>().resize(std::size_t()))>> : std::true_type {};
 
-class Range {
 
-    RangeIterator<T> _start, _stop;
+// Container::size_type, or std::size_t for ranges which don't say (a pair of istream iterators...)
+template<class Container, class = void>
+struct size_type_of { using type = std::size_t; };
 
-    public:
-        constexpr Range(const T start, const T stop):_start(start), _stop(stop) {}
+template<class Container>
+struct size_type_of<Container, std::void_t<typename Container::size_type>> { using type = typename Container::size_type; };
 
-        constexpr inline RangeIterator<T> begin() const { return _start; }
+template<class Container>
+using size_type_t = typename size_type_of<Container>::type;
 
-        constexpr inline RangeIterator<T> end() const { return _stop; }
 
-};
+// std::forward_list has no size()
+template<class Container>
+inline std::size_t input_size(const Container& in) {
+    if constexpr( has_size<Container>::value ) return in.size();
+    else return static_cast<std::size_t>(std::distance(std::begin(in), std::end(in)));
+}
 
+#endif
+#ifndef __VIPER_ENUMERATE__
+#define __VIPER_ENUMERATE__
 
-template<class T>
-constexpr Range<T> range(const T& start, const T& stop) {
-    return Range<T>(start, stop);
-}
 
-#endif 
 
 
 /*
  * This header provides an 'enumerate' function that behave similarly to Python's 'enumerate'.
- * For a given indexable container, it returns an iterator.
+ * For a given container, or any range down to a single pass input range, it returns an iterator.
  * That iterator can be dereferenced into a pair of (index, value).
  *
  * For example:
@@ -100,404 +96,4264 @@ constexpr Range<T> range(const T& start, const T& stop) {
 template<class Indexable>
 class Enumerate {
 
-    const Indexable & data;
+    using size_type = size_type_t<std::remove_reference_t<Indexable>>;
 
-    public:
-    Enumerate(const Indexable& container) noexcept :data(container) {}
+    // a reference to an l-value container, the container itself when it was an r-value (moved in, see enumerate)
+    Indexable data;
+    size_type start, step;
 
+    public:
+    Enumerate(Indexable&& container, size_type start = 0, size_type step = 1)
+        :data(std::forward<Indexable>(container)), start(start), step(step) {}
+
+    /*
+     * Has the category of the iterator it wraps: over a random access container it is random access too,
+     * so it can be offset, subtracted, compared and split in chunks in constant time,
+     * the index moving along with the underlying iterator.
+     * The index is carried by the iterator, 'step' apart from one element to the next.
+     */
     template<typename IterType>
     class Iterator {
 
         using type = std::remove_reference_t<Indexable>;
-        using iterator_type = typename type::iterator;
-        using reference = typename type::reference;
-        using size_type = typename type::size_type;
-        using value_type = typename type::value_type;
+        using size_type = size_type_t<type>;
 
         IterType iter;
         size_type index;
+        size_type step;
 
         public:
-            Iterator(const size_type& index, const IterType& iter): index(index), iter(iter) {}
 
-            inline auto operator*() const {
-                return std::make_pair(index, std::ref(*iter));
+            // (index, value) pairs are built on the fly, the value is a reference when the underlying iterator yields one
+            using reference = std::pair<size_type, decltype(*std::declval<const IterType&>())>;
+            using value_type = reference;
+            using pointer = void;
+            using difference_type = typename std::iterator_traits<IterType>::difference_type;
+            using iterator_category = typename std::iterator_traits<IterType>::iterator_category;
+
+            Iterator(const size_type& index, const IterType& iter, const size_type& step = 1): iter(iter), index(index), step(step) {}
+
+            inline const IterType& base() const noexcept { return iter; }
+
+            inline reference operator*() const {
+                return reference(index, *iter);
             }
 
-            inline auto operator++() {
-                ++index;
+            inline reference operator[](difference_type n) const {
+                return reference(index + n*step, iter[n]);
+            }
+
+            inline Iterator& operator++() {
+                index += step;
                 ++iter;
                 return *this;
             }
 
-            inline auto operator!=(const Iterator<IterType>& rhs) const {
+            inline auto operator++(int) {
+                auto iterator{*this};
+                operator++();
+                return iterator;
+            }
+
+            inline Iterator& operator--() {
+                index -= step;
+                --iter;
+                return *this;
+            }
+
+            inline auto operator--(int) {
+                auto iterator{*this};
+                operator--();
+                return iterator;
+            }
+
+            inline Iterator& operator+=(difference_type n) {
+                index += n*step;
+                iter += n;
+                return *this;
+            }
+
+            inline Iterator& operator-=(difference_type n) {
+                index -= n*step;
+                iter -= n;
+                return *this;
+            }
+
+            inline Iterator operator+(difference_type n) const {
+                auto iterator{*this};
+                return iterator += n;
+            }
+
+            friend inline Iterator operator+(difference_type n, const Iterator& rhs) {
+                return rhs + n;
+            }
+
+            inline Iterator operator-(difference_type n) const {
+                auto iterator{*this};
+                return iterator -= n;
+            }
+
+            inline difference_type operator-(const Iterator<IterType>& rhs) const {
+                return iter - rhs.iter;
+            }
+
+            inline bool operator==(const Iterator<IterType>& rhs) const {
+                return iter == rhs.iter;
+            }
+
+            inline bool operator!=(const Iterator<IterType>& rhs) const {
                 return iter != rhs.iter;
             }
 
+            inline bool operator<(const Iterator<IterType>& rhs) const {
+                return iter < rhs.iter;
+            }
+
+            inline bool operator>(const Iterator<IterType>& rhs) const {
+                return iter > rhs.iter;
+            }
+
+            inline bool operator<=(const Iterator<IterType>& rhs) const {
+                return iter <= rhs.iter;
+            }
+
+            inline bool operator>=(const Iterator<IterType>& rhs) const {
+                return iter >= rhs.iter;
+            }
+
+    };
+
+    /*
+     * End of an enumeration whose size isn't known in constant time (std::list, std::map...):
+     * it only holds the underlying end, an iterator reaches it when its underlying iterator does,
+     * so the container is walked once, without counting its elements first.
+     */
+    template<typename IterType>
+    class Sentinel {
+
+        IterType iter;
+
+        public:
+
+            explicit Sentinel(const IterType& iter): iter(iter) {}
+
+            inline const IterType& base() const noexcept { return iter; }
+
+            friend inline bool operator==(const Iterator<IterType>& lhs, const Sentinel& rhs) {
+                return lhs.base() == rhs.iter;
+            }
+
+            friend inline bool operator!=(const Iterator<IterType>& lhs, const Sentinel& rhs) {
+                return lhs.base() != rhs.iter;
+            }
+
+            friend inline bool operator==(const Sentinel& lhs, const Iterator<IterType>& rhs) {
+                return lhs.iter == rhs.base();
+            }
+
+            friend inline bool operator!=(const Sentinel& lhs, const Iterator<IterType>& rhs) {
+                return lhs.iter != rhs.base();
+            }
     };
 
-    inline auto begin() { return Iterator<decltype(data.begin())>(0, data.begin()); }
+    inline auto begin() { return Iterator<decltype(data.begin())>(start, data.begin(), step); }
+
+    // an Iterator over random access containers, whose last index is known for free, a Sentinel otherwise
+    inline auto end() {
+        using iterator_t = decltype(data.end());
+        if constexpr( std::is_base_of_v<std::random_access_iterator_tag, typename std::iterator_traits<iterator_t>::iterator_category> ) {
+            return Iterator<iterator_t>(start + (data.end() - data.begin())*step, data.end(), step);
+        } else {
+            return Sentinel<iterator_t>(data.end());
+        }
+    }
 
-    inline auto end() { return Iterator<decltype(data.end())>(std::distance(data.begin(), data.end()), data.end()); }
+    inline std::size_t size() const { return input_size(data); }
 
 };
 
 
+/*
+ * An l-value container is referenced, an r-value one is moved into the Enumerate,
+ * so enumerating a temporary neither copies it nor leaves a dangling reference:
+ *
+ * for( auto&& [index, row] : enumerate(make_rows()) ) { ... }
+ */
 template<class Indexable>
-inline auto enumerate(Indexable&& container) noexcept {
-    return Enumerate<decltype(container)>(std::forward<Indexable>(container));
+inline auto enumerate(Indexable&& container) noexcept(std::is_lvalue_reference_v<Indexable> || std::is_nothrow_move_constructible_v<Indexable>) {
+    return Enumerate<Indexable>(std::forward<Indexable>(container));
 }
 
 
-
-template<class Container>
-constexpr bool in(const Container& c, typename Container::const_reference value) {
-    return std::find(c.cbegin(), c.cend(), value) != c.cend();
+/*
+ * Same, counting from 'start' rather than 0, like Python's enumerate(container, start),
+ * and optionally by 'step': a worker on a shard of the rows gets their global ids for free.
+ *
+ * For example:
+ * for( auto&& [id, row] : enumerate(shard, shard_base) ) { ... }         // shard_base, shard_base+1...
+ * for( auto&& [offset, row] : enumerate(rows, 0, row_size) ) { ... }     // 0, row_size, 2*row_size...
+ */
+template<class Indexable>
+inline auto enumerate(Indexable&& container, std::size_t start, std::size_t step = 1) {
+    return Enumerate<Indexable>(std::forward<Indexable>(container), start, step);
 }
 
-template<class Container>
-constexpr bool in(const Container& c, typename Container::value_type&& value) {
-    return std::find(c.cbegin(), c.cend(), value) != c.cend();
-}
 
-template<class Container>
-constexpr bool in(Container&& c, typename Container::value_type&& value) {
-    return std::find(c.cbegin(), c.cend(), value) != c.cend();
-}
+/*
+ * The [first, last) range of a pair of iterators, held by value,
+ * so single pass sources which aren't containers can be enumerated as they are read.
+ *
+ * For example:
+ * std::ifstream log("huge.log");
+ * for( auto&& [number, word] : enumerate(std::istream_iterator<std::string>(log), std::istream_iterator<std::string>()) ) { ... }
+ */
+template<class Iterator>
+class IteratorPair {
 
+    Iterator first, last;
 
-#ifndef __VIPER_GRID__
-#define __VIPER_GRID__
+    public:
 
+        using size_type = std::size_t;
 
+        IteratorPair(Iterator first, Iterator last) : first(std::move(first)), last(std::move(last)) {}
 
+        inline Iterator begin() const { return first; }
 
-template<std::size_t column_number, std::size_t rows, std::size_t cols, class SequenceContainer>
-class ColumnDimension {
+        inline Iterator end() const { return last; }
+};
 
-    protected:
 
-    const SequenceContainer& data;
+template<class Iterator, class = typename std::iterator_traits<Iterator>::iterator_category>
+inline auto enumerate(Iterator first, Iterator last) {
+    return Enumerate<IteratorPair<Iterator>>(IteratorPair<Iterator>(std::move(first), std::move(last)));
+}
+
+#endif
+#ifndef __VIPER_FUNCTION_BOX__
+#define __VIPER_FUNCTION_BOX__
+
+
+
+/*
+ * Stores the callable of an iterator adaptor (FilterIterator's predicate, Iter's conversion) by value.
+ *
+ * Stateless callables (captureless lambdas, std::less<>, ...) become an empty base and take no room at all.
+ * Lambdas with captures are not assignable, so they are re-built in place on assignment
+ * to keep the iterator CopyAssignable.
+ */
+template<class Function, bool = std::is_empty_v<Function> && !std::is_final_v<Function>>
+class FunctionBox : private Function {
 
     public:
 
-    template<typename iterator>
-    class ColumnIterator {
+        constexpr FunctionBox(const Function& function) : Function(function) {}
 
-        public:
+        constexpr FunctionBox(Function&& function) : Function(std::move(function)) {}
 
-            using difference_type = typename std::iterator_traits<iterator>::difference_type;
-            using value_type = typename std::iterator_traits<iterator>::value_type;
-            using pointer = typename std::iterator_traits<iterator>::pointer;
-            using reference = typename std::iterator_traits<iterator>::reference;
-            using const_reference = typename std::iterator_traits<iterator>::reference;
-            using iterator_category = typename std::iterator_traits<iterator>::iterator_category;
+        FunctionBox(const FunctionBox&) = default;
 
-        protected:
+        FunctionBox(FunctionBox&&) = default;
 
-            iterator _iter;
+        // nothing to assign, an empty callable has no state
+        constexpr FunctionBox& operator=(const FunctionBox&) noexcept { return *this; }
 
-        public:
+        constexpr FunctionBox& operator=(FunctionBox&&) noexcept { return *this; }
 
-            ColumnIterator(const iterator& iter): _iter(iter) {}
+        constexpr Function& function() noexcept { return *this; }
 
-            inline typename std::conditional<std::is_const<iterator>::value, const_reference, reference>::type operator*() const {
-                return *_iter;
+        constexpr const Function& function() const noexcept { return *this; }
+};
+
+
+template<class Function>
+class FunctionBox<Function, false> {
+
+    static constexpr bool assignable = std::is_copy_assignable_v<Function> && std::is_move_assignable_v<Function>;
+
+    std::conditional_t<assignable, Function, std::optional<Function>> _function;
+
+    public:
+
+        constexpr FunctionBox(const Function& function) : _function(function) {}
+
+        constexpr FunctionBox(Function&& function) : _function(std::move(function)) {}
+
+        FunctionBox(const FunctionBox&) = default;
+
+        FunctionBox(FunctionBox&&) = default;
+
+        FunctionBox& operator=(const FunctionBox& other) {
+            if( this != &other ) {
+                if constexpr( assignable ) {
+                    _function = other._function;
+                } else {
+                    _function.emplace(*other._function);
+                }
             }
+            return *this;
+        }
 
-            inline auto operator!=(const ColumnIterator<iterator>& rhs) const {
-                return _iter != rhs._iter;
+        FunctionBox& operator=(FunctionBox&& other) {
+            if( this != &other ) {
+                if constexpr( assignable ) {
+                    _function = std::move(other._function);
+                } else {
+                    _function.emplace(std::move(*other._function));
+                }
             }
+            return *this;
+        }
 
-            inline auto operator++() {
-                std::advance(_iter, cols);
-                return *this;
+        constexpr Function& function() noexcept {
+            if constexpr( assignable ) return _function; else return *_function;
+        }
+
+        constexpr const Function& function() const noexcept {
+            if constexpr( assignable ) return _function; else return *_function;
+        }
+};
+
+#endif
+#ifndef __VIPER_FILTER_ITERATOR__
+#define __VIPER_FILTER_ITERATOR__
+
+
+
+
+/*
+ * Iterates over [begin, end) skipping the elements for which the predicate returns false.
+ *
+ * The predicate type is a template parameter, so a lambda is called directly and can be inlined.
+ * It defaults to a std::function for when the type of the callable can't be named,
+ * at the cost of an indirect call per element.
+ *
+ * For example:
+ * auto even = [](int i) { return i % 2 == 0; };
+ * FilterIterator it(vi.begin(), vi.end(), even); // FilterIterator<std::vector<int>::iterator, decltype(even)>
+ */
+template<class Iterator, class Predicate = std::function< bool (typename std::iterator_traits<Iterator>::reference) >>
+class FilterIterator : private FunctionBox<Predicate> {
+
+    using box_t = FunctionBox<Predicate>;
+    using traits_t = std::iterator_traits<Iterator>;
+
+    public:
+
+        using predicate_t = Predicate;
+        using iterator_type = Iterator;
+        using difference_type = typename traits_t::difference_type;
+        using value_type = typename traits_t::value_type;
+        using pointer = typename traits_t::pointer;
+        using reference = typename traits_t::reference;
+        // skipping elements means we can't jump ahead, at best we move forward
+        using iterator_category = std::conditional_t<
+            std::is_base_of_v<std::forward_iterator_tag, typename traits_t::iterator_category>,
+            std::forward_iterator_tag,
+            typename traits_t::iterator_category
+                >;
+
+    private:
+
+        Iterator _iter, _end;
+
+        inline void move_to_next_valid_value() {
+            while( (_iter != _end) && !box_t::function()(*_iter) ) ++_iter;
+        }
+
+    public:
+
+        FilterIterator(Iterator begin, Iterator end, Predicate filter)
+            : box_t(std::move(filter)), _iter(std::move(begin)), _end(std::move(end)) {
+                move_to_next_valid_value();
             }
 
-    };
+        FilterIterator(const FilterIterator&) = default;
 
-    using container_t = std::remove_reference_t<SequenceContainer>;
-    using value_type = typename container_t::value_type;
-    using size_type = typename container_t::size_type;
-    using difference_type = typename container_t::difference_type;
-    using reference = typename container_t::reference;
-    using const_reference = typename container_t::const_reference;
-    using pointer = typename container_t::pointer;
-    using const_pointer = typename container_t::const_pointer;
-    using iterator = ColumnIterator<typename container_t::iterator>;
-    using const_iterator = ColumnIterator<typename container_t::const_iterator>;
+        FilterIterator(FilterIterator&&) = default;
 
-    constexpr ColumnDimension(const SequenceContainer& container)
-        :data(container) {}
+        FilterIterator& operator=(const FilterIterator&) = default;
+
+        FilterIterator& operator=(FilterIterator&&) = default;
+
+        inline const Iterator& base() const noexcept { return _iter; }
+
+        inline const Predicate& predicate() const noexcept { return box_t::function(); }
+
+        inline bool operator==(const FilterIterator& rhs) const {
+            return _iter == rhs._iter;
+        }
+
+        inline bool operator!=(const FilterIterator& rhs) const {
+            return _iter != rhs._iter;
+        }
+
+        inline bool operator==(const Iterator& rhs) const {
+            return _iter == rhs;
+        }
+
+        inline bool operator!=(const Iterator& rhs) const {
+            return _iter != rhs;
+        }
+
+        inline reference operator*() const {
+            return *_iter;
+        }
+
+        inline FilterIterator& operator++() {
+            ++_iter;
+            move_to_next_valid_value();
+            return *this;
+        }
+
+        inline auto operator++(int) {
+            auto iterator{*this};
+            operator++();
+            return iterator;
+        }
+};
+
+#endif
+#ifndef __VIPER_PARALLEL__
+#define __VIPER_PARALLEL__
+
+
+
+/*
+ * Execution policy for the parallel overloads of Viper's functions.
+ *
+ * For example:
+ * auto evens = filter(par, even, records);                  // as many chunks as hardware threads
+ * auto evens = filter(parallel_policy{8}, even, records);   // at most 8 chunks
+ *
+ * 'threads' caps the number of chunks the input is split into (0 means one per hardware thread),
+ * 'grain' is the minimum number of elements per chunk, so small inputs aren't worth waking a thread for.
+ * 0 lets each function pick its own: default_grain for filter and into, whose elements are cheap,
+ * one element for parallel_for, whose elements are expected to be expensive.
+ */
+struct parallel_policy {
+    std::size_t threads = 0;
+    std::size_t grain = 0;
+};
+
+inline constexpr std::size_t default_grain = 4096;
+
+inline constexpr parallel_policy par{};
+
+
+/*
+ * The thread pool backing the parallel policy.
+ * Tasks go through a single queue, a thread waiting on its tasks helps running the queue,
+ * so parallel calls can be nested without running out of workers.
+ */
+class ThreadPool {
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable ready;
+    bool stopping = false;
+
+    void work() {
+        for(;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if( tasks.empty() ) return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    public:
+
+        explicit ThreadPool(std::size_t threads) {
+            workers.reserve(threads);
+            for( std::size_t i = 0; i < threads; ++i ) workers.emplace_back([this] { work(); });
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            ready.notify_all();
+            for( auto& worker : workers ) worker.join();
+        }
+
+        // the calling thread works too, so one less than the hardware threads
+        static ThreadPool& instance() {
+            static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+            return pool;
+        }
+
+        inline std::size_t size() const noexcept { return workers.size(); }
+
+        void submit(std::function<void()> task) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                tasks.push_back(std::move(task));
+            }
+            ready.notify_one();
+        }
+
+        // runs one queued task on the calling thread, false when there was none
+        bool try_run_one() {
+            std::function<void()> task;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if( tasks.empty() ) return false;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+            return true;
+        }
+};
+
+
+// number of chunks the policy splits 'size' elements into, 'fallback_grain' when the policy leaves the grain to the caller
+inline std::size_t chunk_count(const parallel_policy& policy, std::size_t size, std::size_t fallback_grain = default_grain) noexcept {
+    const std::size_t threads = policy.threads ? policy.threads : std::max(1u, std::thread::hardware_concurrency());
+    const std::size_t grain = std::max<std::size_t>(1, policy.grain ? policy.grain : fallback_grain);
+    return std::max<std::size_t>(1, std::min(threads, size / grain));
+}
+
+
+/*
+ * Containers whose neighbouring elements share memory: std::vector<bool> packs them in words,
+ * writing two of them from different threads is a data race even at different indices.
+ * The parallel overloads fill these sequentially.
+ */
+template<class Container>
+struct is_bit_packed : std::false_type {};
+
+template<class Allocator>
+struct is_bit_packed<std::vector<bool, Allocator>> : std::true_type {};
+
+
+/*
+ * Splits [0, size) into 'chunks' contiguous ranges of nearly equal size
+ * and calls fn(chunk, begin, end) for each of them, the first one on the calling thread.
+ * Returns once all of them are done, re-throwing the first exception thrown by fn.
+ */
+template<class Function>
+void parallel_chunks(std::size_t chunks, std::size_t size, Function&& fn) {
+    auto bounds = [chunks, size](std::size_t chunk) { return chunk * size / chunks; };
+
+    if( chunks <= 1 ) {
+        fn(std::size_t(0), std::size_t(0), size);
+        return;
+    }
+
+    std::mutex mutex;
+    std::condition_variable done;
+    std::size_t remaining = chunks - 1;
+    std::exception_ptr error;
+
+    auto& pool = ThreadPool::instance();
+    for( std::size_t chunk = 1; chunk < chunks; ++chunk ) {
+        pool.submit([&, chunk] {
+            std::exception_ptr chunk_error;
+            try {
+                fn(chunk, bounds(chunk), bounds(chunk+1));
+            } catch(...) {
+                chunk_error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            if( chunk_error && !error ) error = chunk_error;
+            if( --remaining == 0 ) done.notify_one();
+        });
+    }
+
+    try {
+        fn(std::size_t(0), bounds(0), bounds(1));
+    } catch(...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if( !error ) error = std::current_exception();
+    }
+
+    for(;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if( remaining == 0 ) break;
+        }
+        if( !pool.try_run_one() ) {
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [&remaining] { return remaining == 0; });
+            break;
+        }
+    }
+
+    if( error ) std::rethrow_exception(error);
+}
+
+
+/*
+ * Blocks of work handed out to the threads of a parallel_for.
+ * Each thread starts with its own contiguous share of the blocks and runs them front to back,
+ * once it runs out it steals the back half of what another thread has left,
+ * so a thread stuck on expensive elements gets helped rather than waited for.
+ * Blocks only move under their owner's lock, so each of them runs exactly once.
+ */
+class WorkStealingBlocks {
+
+    struct alignas(64) Share {
+        std::mutex mutex;
+        std::size_t begin = 0, end = 0;
+    };
+
+    std::vector<Share> shares;
+
+    public:
+
+        WorkStealingBlocks(std::size_t threads, std::size_t blocks) : shares(threads) {
+            for( std::size_t thread = 0; thread < threads; ++thread ) {
+                shares[thread].begin = thread * blocks / threads;
+                shares[thread].end = (thread + 1) * blocks / threads;
+            }
+        }
+
+        // next block for 'thread', from its own share or stolen from another one, false once there is no work left
+        bool next(std::size_t thread, std::size_t& block) {
+            auto& own = shares[thread];
+            {
+                std::lock_guard<std::mutex> lock(own.mutex);
+                if( own.begin != own.end ) {
+                    block = own.begin++;
+                    return true;
+                }
+            }
+            for( std::size_t k = 1; k < shares.size(); ++k ) {
+                auto& victim = shares[(thread + k) % shares.size()];
+                std::size_t begin, end;
+                {
+                    std::lock_guard<std::mutex> lock(victim.mutex);
+                    if( victim.begin == victim.end ) continue;
+                    end = victim.end;
+                    begin = end - std::max<std::size_t>(1, (end - victim.begin) / 2);
+                    victim.end = begin;
+                }
+                std::lock_guard<std::mutex> lock(own.mutex);
+                block = begin;
+                own.begin = begin + 1;
+                own.end = end;
+                return true;
+            }
+            return false;
+        }
+};
+
+
+/*
+ * Calls fn(element) for every element of a random access range, in parallel, each element exactly once.
+ * Made for enumerate(), so the index comes along with the value:
+ *
+ * parallel_for(enumerate(images), [](auto&& indexed) { thumbnails[indexed.first] = thumbnail(indexed.second); });
+ *
+ * The range is cut in blocks balanced between threads by work stealing (see WorkStealingBlocks),
+ * elements whose cost varies a lot don't leave threads idle. The policy bounds the number of threads;
+ * unless it sets a grain, even a few elements are spread over all of them, a few blocks per thread,
+ * pass a larger grain (parallel_policy{0, 4096}) when each element is cheap.
+ */
+template<class Range, class Function>
+void parallel_for(const parallel_policy& policy, Range&& range, Function&& fn) {
+    const auto first = std::begin(range);
+    using category = typename std::iterator_traits<std::remove_const_t<decltype(first)>>::iterator_category;
+    static_assert(std::is_base_of_v<std::random_access_iterator_tag, category>, "parallel_for needs a random access range");
+
+    const auto size = static_cast<std::size_t>(std::end(range) - first);
+    const std::size_t threads = chunk_count(policy, size, 1);
+    // a few blocks per thread are enough for stealing to even the load out
+    const std::size_t blocks = std::min(size, threads * 8);
+    if( threads <= 1 || blocks == 0 ) {
+        for( auto it = first; it != first + size; ++it ) fn(*it);
+        return;
+    }
+
+    WorkStealingBlocks work(threads, blocks);
+    std::atomic<bool> failed{false};
+    parallel_chunks(threads, threads, [&](std::size_t thread, std::size_t, std::size_t) {
+        std::size_t block;
+        while( !failed.load(std::memory_order_relaxed) && work.next(thread, block) ) {
+            auto it = first + static_cast<std::ptrdiff_t>(block * size / blocks);
+            const auto last = first + static_cast<std::ptrdiff_t>((block + 1) * size / blocks);
+            try {
+                for( ; it != last; ++it ) fn(*it);
+            } catch(...) {
+                failed = true;
+                throw;
+            }
+        }
+    });
+}
+
+
+template<class Range, class Function>
+void parallel_for(Range&& range, Function&& fn) {
+    parallel_for(par, std::forward<Range>(range), std::forward<Function>(fn));
+}
+
+#endif
+#ifndef __VIPER_SIMD__
+#define __VIPER_SIMD__
+
+
+/*
+ * SIMD kernels shared by the other headers.
+ *
+ * Viper is header-only, so we can't ask for -mavx2: the kernels are compiled with a per-function
+ * target attribute and picked at runtime from the CPU features, falling back to plain scalar code.
+ * Define VIPER_NO_SIMD to always use the scalar code.
+ */
+#if !defined(VIPER_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define VIPER_X86_SIMD 1
+#define VIPER_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+
+namespace simd {
+
+// ordered, each level implies the ones before it
+enum class level { scalar, sse42, avx2, avx512 };
+
+
+inline level detect() noexcept {
+#ifdef VIPER_X86_SIMD
+    __builtin_cpu_init();
+    if( __builtin_cpu_supports("avx512f") ) return level::avx512;
+    if( __builtin_cpu_supports("avx2") ) return level::avx2;
+    if( __builtin_cpu_supports("sse4.2") ) return level::sse42;
+#endif
+    return level::scalar;
+}
+
+
+// the CPU won't change while we're running, ask once
+inline level supported() noexcept {
+    static const level cpu = detect();
+    return cpu;
+}
+
+
+// the types our kernels can compare a whole register of at once
+template<class T>
+constexpr bool is_vectorizable_v = std::is_arithmetic_v<T>
+                                && !std::is_same_v<T, bool>
+                                && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+
+
+#ifdef VIPER_X86_SIMD
+
+template<class T>
+VIPER_TARGET("sse4.2") inline __m128i broadcast_sse42(const T value) {
+    if constexpr( std::is_same_v<T, float> ) return _mm_castps_si128(_mm_set1_ps(value));
+    else if constexpr( std::is_same_v<T, double> ) return _mm_castpd_si128(_mm_set1_pd(value));
+    else if constexpr( sizeof(T) == 1 ) return _mm_set1_epi8(static_cast<char>(value));
+    else if constexpr( sizeof(T) == 2 ) return _mm_set1_epi16(static_cast<short>(value));
+    else if constexpr( sizeof(T) == 4 ) return _mm_set1_epi32(static_cast<int>(value));
+    else return _mm_set1_epi64x(static_cast<long long>(value));
+}
+
+
+// all ones in the lanes of [p, p+16 bytes) equal to the needle
+template<class T>
+VIPER_TARGET("sse4.2") inline __m128i equal_sse42(const T* p, const __m128i needle) {
+    if constexpr( std::is_same_v<T, float> ) {
+        return _mm_castps_si128(_mm_cmpeq_ps(_mm_loadu_ps(p), _mm_castsi128_ps(needle)));
+    } else if constexpr( std::is_same_v<T, double> ) {
+        return _mm_castpd_si128(_mm_cmpeq_pd(_mm_loadu_pd(p), _mm_castsi128_pd(needle)));
+    } else {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        if constexpr( sizeof(T) == 1 ) return _mm_cmpeq_epi8(block, needle);
+        else if constexpr( sizeof(T) == 2 ) return _mm_cmpeq_epi16(block, needle);
+        else if constexpr( sizeof(T) == 4 ) return _mm_cmpeq_epi32(block, needle);
+        else return _mm_cmpeq_epi64(block, needle);
+    }
+}
+
+
+template<class T>
+VIPER_TARGET("sse4.2") const T* find_sse42(const T* first, const T* last, const T value) {
+    constexpr std::ptrdiff_t lanes = 16 / sizeof(T);
+    const __m128i needle = broadcast_sse42(value);
+    for( ; last - first >= 4*lanes; first += 4*lanes ) {
+        const __m128i m0 = equal_sse42(first, needle);
+        const __m128i m1 = equal_sse42(first + lanes, needle);
+        const __m128i m2 = equal_sse42(first + 2*lanes, needle);
+        const __m128i m3 = equal_sse42(first + 3*lanes, needle);
+        if( _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(m0, m1), _mm_or_si128(m2, m3))) ) break;
+    }
+    for( ; last - first >= lanes; first += lanes ) {
+        const unsigned mask = _mm_movemask_epi8(equal_sse42(first, needle));
+        if( mask ) return first + __builtin_ctz(mask) / sizeof(T);
+    }
+    return std::find(first, last, value);
+}
+
+
+template<class T>
+VIPER_TARGET("avx2") inline __m256i broadcast_avx2(const T value) {
+    if constexpr( std::is_same_v<T, float> ) return _mm256_castps_si256(_mm256_set1_ps(value));
+    else if constexpr( std::is_same_v<T, double> ) return _mm256_castpd_si256(_mm256_set1_pd(value));
+    else if constexpr( sizeof(T) == 1 ) return _mm256_set1_epi8(static_cast<char>(value));
+    else if constexpr( sizeof(T) == 2 ) return _mm256_set1_epi16(static_cast<short>(value));
+    else if constexpr( sizeof(T) == 4 ) return _mm256_set1_epi32(static_cast<int>(value));
+    else return _mm256_set1_epi64x(static_cast<long long>(value));
+}
+
+
+// all ones in the lanes of [p, p+32 bytes) equal to the needle
+template<class T>
+VIPER_TARGET("avx2") inline __m256i equal_avx2(const T* p, const __m256i needle) {
+    if constexpr( std::is_same_v<T, float> ) {
+        return _mm256_castps_si256(_mm256_cmp_ps(_mm256_loadu_ps(p), _mm256_castsi256_ps(needle), _CMP_EQ_OQ));
+    } else if constexpr( std::is_same_v<T, double> ) {
+        return _mm256_castpd_si256(_mm256_cmp_pd(_mm256_loadu_pd(p), _mm256_castsi256_pd(needle), _CMP_EQ_OQ));
+    } else {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        if constexpr( sizeof(T) == 1 ) return _mm256_cmpeq_epi8(block, needle);
+        else if constexpr( sizeof(T) == 2 ) return _mm256_cmpeq_epi16(block, needle);
+        else if constexpr( sizeof(T) == 4 ) return _mm256_cmpeq_epi32(block, needle);
+        else return _mm256_cmpeq_epi64(block, needle);
+    }
+}
+
+
+template<class T>
+VIPER_TARGET("avx2") const T* find_avx2(const T* first, const T* last, const T value) {
+    constexpr std::ptrdiff_t lanes = 32 / sizeof(T);
+    const __m256i needle = broadcast_avx2(value);
+    // 4 registers per step to keep the load ports busy, then narrow down on the block with the hit
+    for( ; last - first >= 4*lanes; first += 4*lanes ) {
+        const __m256i m0 = equal_avx2(first, needle);
+        const __m256i m1 = equal_avx2(first + lanes, needle);
+        const __m256i m2 = equal_avx2(first + 2*lanes, needle);
+        const __m256i m3 = equal_avx2(first + 3*lanes, needle);
+        const __m256i any = _mm256_or_si256(_mm256_or_si256(m0, m1), _mm256_or_si256(m2, m3));
+        if( !_mm256_testz_si256(any, any) ) break;
+    }
+    for( ; last - first >= lanes; first += lanes ) {
+        const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(equal_avx2(first, needle)));
+        if( mask ) return first + __builtin_ctz(mask) / sizeof(T);
+    }
+    return std::find(first, last, value);
+}
+
+#endif
+
+
+/*
+ * Same as std::find(first, last, value) over a contiguous array of arithmetic values,
+ * comparing a whole register of values per instruction when the CPU supports it.
+ */
+template<class T>
+inline const T* find(const T* first, const T* last, const T value) {
+    static_assert(is_vectorizable_v<T>, "simd::find only compares arithmetic values");
+#ifdef VIPER_X86_SIMD
+    const level cpu = supported();
+    if( cpu >= level::avx2 ) return find_avx2(first, last, value);
+    if( cpu >= level::sse42 ) return find_sse42(first, last, value);
+#endif
+    return std::find(first, last, value);
+}
+
+
+/*
+ * Stream compaction: copies the values of [first, last) passing the comparison to 'out', keeping their order,
+ * and returns the end of the output. 'out' may be 'first', the values are then compacted in place,
+ * otherwise it must have room for last-first values: whole registers are stored, not just the values kept.
+ *
+ * Comparisons are the ones of 'Comparison' (predicates.h), 'between' includes both bounds.
+ */
+enum class compare { eq, ne, lt, le, gt, ge, between };
+
+
+template<compare op, class T, class U>
+constexpr bool test(const T& x, const U& a, const U& b) {
+    if constexpr( op == compare::eq ) return x == a;
+    else if constexpr( op == compare::ne ) return x != a;
+    else if constexpr( op == compare::lt ) return x < a;
+    else if constexpr( op == compare::le ) return x <= a;
+    else if constexpr( op == compare::gt ) return x > a;
+    else if constexpr( op == compare::ge ) return x >= a;
+    else return a <= x && x <= b;
+}
+
+
+// branchless: every value is written, the output only moves forward when it passes
+template<compare op, class T>
+inline T* compact_scalar(const T* first, const T* last, T* out, const T a, const T b) {
+    for( ; first != last; ++first ) {
+        const T value = *first;
+        *out = value;
+        out += test<op>(value, a, b);
+    }
+    return out;
+}
+
+
+// lane indices moving the selected 32 bit lanes of a 256 bit register to the front, per 8 bit mask
+constexpr std::array<std::array<std::uint32_t, 8>, 256> make_compaction_table_32() {
+    std::array<std::array<std::uint32_t, 8>, 256> table{};
+    for( std::size_t mask = 0; mask < 256; ++mask ) {
+        std::size_t k = 0;
+        for( std::uint32_t lane = 0; lane < 8; ++lane ) {
+            if( mask & (std::size_t(1) << lane) ) table[mask][k++] = lane;
+        }
+    }
+    return table;
+}
+
+
+// same for 64 bit lanes, as pairs of 32 bit lanes, per 4 bit mask
+constexpr std::array<std::array<std::uint32_t, 8>, 16> make_compaction_table_64() {
+    std::array<std::array<std::uint32_t, 8>, 16> table{};
+    for( std::size_t mask = 0; mask < 16; ++mask ) {
+        std::size_t k = 0;
+        for( std::uint32_t lane = 0; lane < 4; ++lane ) {
+            if( mask & (std::size_t(1) << lane) ) {
+                table[mask][k++] = 2*lane;
+                table[mask][k++] = 2*lane + 1;
+            }
+        }
+    }
+    return table;
+}
+
+inline constexpr auto compaction_table_32 = make_compaction_table_32();
+
+inline constexpr auto compaction_table_64 = make_compaction_table_64();
+
+
+#ifdef VIPER_X86_SIMD
+
+template<class T, int predicate>
+VIPER_TARGET("avx2") inline __m256i compare_float_avx2(const __m256i x, const __m256i y) {
+    if constexpr( std::is_same_v<T, float> ) return _mm256_castps_si256(_mm256_cmp_ps(_mm256_castsi256_ps(x), _mm256_castsi256_ps(y), predicate));
+    else return _mm256_castpd_si256(_mm256_cmp_pd(_mm256_castsi256_pd(x), _mm256_castsi256_pd(y), predicate));
+}
+
+
+template<class T>
+VIPER_TARGET("avx2") inline __m256i greater_avx2(__m256i x, __m256i y) {
+    if constexpr( std::is_unsigned_v<T> ) {
+        // no unsigned comparison in AVX2: flip the sign bits and compare signed
+        const __m256i sign = sizeof(T) == 8 ? _mm256_set1_epi64x(static_cast<long long>(1ull << 63)) : _mm256_set1_epi32(static_cast<int>(1u << 31));
+        x = _mm256_xor_si256(x, sign);
+        y = _mm256_xor_si256(y, sign);
+    }
+    if constexpr( sizeof(T) == 8 ) return _mm256_cmpgt_epi64(x, y); else return _mm256_cmpgt_epi32(x, y);
+}
+
+
+template<class T>
+VIPER_TARGET("avx2") inline __m256i equal_lanes_avx2(const __m256i x, const __m256i y) {
+    if constexpr( sizeof(T) == 8 ) return _mm256_cmpeq_epi64(x, y); else return _mm256_cmpeq_epi32(x, y);
+}
+
+
+// all ones in the 32 or 64 bit lanes of 'values' passing the comparison
+template<compare op, class T>
+VIPER_TARGET("avx2") inline __m256i test_avx2(const __m256i values, const __m256i a, const __m256i b) {
+    if constexpr( std::is_floating_point_v<T> ) {
+        // ordered comparisons are false for NaN, like the scalar operators, != is the unordered one
+        if constexpr( op == compare::eq ) return compare_float_avx2<T, _CMP_EQ_OQ>(values, a);
+        else if constexpr( op == compare::ne ) return compare_float_avx2<T, _CMP_NEQ_UQ>(values, a);
+        else if constexpr( op == compare::lt ) return compare_float_avx2<T, _CMP_LT_OQ>(values, a);
+        else if constexpr( op == compare::le ) return compare_float_avx2<T, _CMP_LE_OQ>(values, a);
+        else if constexpr( op == compare::gt ) return compare_float_avx2<T, _CMP_GT_OQ>(values, a);
+        else if constexpr( op == compare::ge ) return compare_float_avx2<T, _CMP_GE_OQ>(values, a);
+        else return _mm256_and_si256(compare_float_avx2<T, _CMP_GE_OQ>(values, a), compare_float_avx2<T, _CMP_LE_OQ>(values, b));
+    } else {
+        const __m256i ones = _mm256_set1_epi32(-1);
+        if constexpr( op == compare::eq ) return equal_lanes_avx2<T>(values, a);
+        else if constexpr( op == compare::ne ) return _mm256_xor_si256(equal_lanes_avx2<T>(values, a), ones);
+        else if constexpr( op == compare::lt ) return greater_avx2<T>(a, values);
+        else if constexpr( op == compare::le ) return _mm256_xor_si256(greater_avx2<T>(values, a), ones);
+        else if constexpr( op == compare::gt ) return greater_avx2<T>(values, a);
+        else if constexpr( op == compare::ge ) return _mm256_xor_si256(greater_avx2<T>(a, values), ones);
+        else return _mm256_xor_si256(_mm256_or_si256(greater_avx2<T>(a, values), greater_avx2<T>(values, b)), ones);
+    }
+}
+
+
+template<compare op, class T>
+VIPER_TARGET("avx2,popcnt") T* compact_avx2(const T* first, const T* last, T* out, const T a, const T b) {
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8, "AVX2 compaction works on 32 or 64 bit lanes");
+    constexpr std::ptrdiff_t lanes = 32 / sizeof(T);
+    const __m256i va = broadcast_avx2(a);
+    const __m256i vb = broadcast_avx2(b);
+    for( ; last - first >= lanes; first += lanes ) {
+        // the whole block is loaded before anything is stored, and out <= first, so compacting in place is safe
+        const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+        const __m256i selected = test_avx2<op, T>(values, va, vb);
+        unsigned mask;
+        const std::uint32_t* permutation;
+        if constexpr( sizeof(T) == 4 ) {
+            mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(selected)));
+            permutation = compaction_table_32[mask].data();
+        } else {
+            mask = static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(selected)));
+            permutation = compaction_table_64[mask].data();
+        }
+        const __m256i shuffle = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(permutation));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_permutevar8x32_epi32(values, shuffle));
+        out += __builtin_popcount(mask);
+    }
+    return compact_scalar<op>(first, last, out, a, b);
+}
+
+
+template<class T>
+VIPER_TARGET("avx512f") inline __m512i broadcast_avx512(const T value) {
+    if constexpr( std::is_same_v<T, float> ) return _mm512_castps_si512(_mm512_set1_ps(value));
+    else if constexpr( std::is_same_v<T, double> ) return _mm512_castpd_si512(_mm512_set1_pd(value));
+    else if constexpr( sizeof(T) == 4 ) return _mm512_set1_epi32(static_cast<int>(value));
+    else return _mm512_set1_epi64(static_cast<long long>(value));
+}
+
+
+// AVX-512 compares straight into a mask register, signed, unsigned or floating point
+template<class T, int predicate>
+VIPER_TARGET("avx512f") inline unsigned compare_avx512(const __m512i x, const __m512i y) {
+    if constexpr( std::is_same_v<T, float> ) return _mm512_cmp_ps_mask(_mm512_castsi512_ps(x), _mm512_castsi512_ps(y), predicate);
+    else if constexpr( std::is_same_v<T, double> ) return _mm512_cmp_pd_mask(_mm512_castsi512_pd(x), _mm512_castsi512_pd(y), predicate);
+    else if constexpr( sizeof(T) == 4 && std::is_signed_v<T> ) return _mm512_cmp_epi32_mask(x, y, predicate);
+    else if constexpr( sizeof(T) == 4 ) return _mm512_cmp_epu32_mask(x, y, predicate);
+    else if constexpr( std::is_signed_v<T> ) return _mm512_cmp_epi64_mask(x, y, predicate);
+    else return _mm512_cmp_epu64_mask(x, y, predicate);
+}
+
+
+// one bit per 32 or 64 bit lane of 'values' passing the comparison
+template<compare op, class T>
+VIPER_TARGET("avx512f") inline unsigned test_avx512(const __m512i values, const __m512i a, const __m512i b) {
+    if constexpr( std::is_floating_point_v<T> ) {
+        if constexpr( op == compare::eq ) return compare_avx512<T, _CMP_EQ_OQ>(values, a);
+        else if constexpr( op == compare::ne ) return compare_avx512<T, _CMP_NEQ_UQ>(values, a);
+        else if constexpr( op == compare::lt ) return compare_avx512<T, _CMP_LT_OQ>(values, a);
+        else if constexpr( op == compare::le ) return compare_avx512<T, _CMP_LE_OQ>(values, a);
+        else if constexpr( op == compare::gt ) return compare_avx512<T, _CMP_GT_OQ>(values, a);
+        else if constexpr( op == compare::ge ) return compare_avx512<T, _CMP_GE_OQ>(values, a);
+        else return compare_avx512<T, _CMP_GE_OQ>(values, a) & compare_avx512<T, _CMP_LE_OQ>(values, b);
+    } else {
+        if constexpr( op == compare::eq ) return compare_avx512<T, _MM_CMPINT_EQ>(values, a);
+        else if constexpr( op == compare::ne ) return compare_avx512<T, _MM_CMPINT_NE>(values, a);
+        else if constexpr( op == compare::lt ) return compare_avx512<T, _MM_CMPINT_LT>(values, a);
+        else if constexpr( op == compare::le ) return compare_avx512<T, _MM_CMPINT_LE>(values, a);
+        else if constexpr( op == compare::gt ) return compare_avx512<T, _MM_CMPINT_NLE>(values, a);
+        else if constexpr( op == compare::ge ) return compare_avx512<T, _MM_CMPINT_NLT>(values, a);
+        else return compare_avx512<T, _MM_CMPINT_NLT>(values, a) & compare_avx512<T, _MM_CMPINT_LE>(values, b);
+    }
+}
+
+
+/*
+ * The compress instruction packs the selected lanes in a register, no table needed.
+ * It is stored with a plain full width store rather than a compress-store to memory,
+ * which is microcoded and much slower on some CPUs, hence the same room requirement on 'out' as AVX2.
+ */
+template<compare op, class T>
+VIPER_TARGET("avx512f,popcnt") T* compact_avx512(const T* first, const T* last, T* out, const T a, const T b) {
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8, "AVX-512 compaction works on 32 or 64 bit lanes");
+    constexpr std::ptrdiff_t lanes = 64 / sizeof(T);
+    const __m512i va = broadcast_avx512(a);
+    const __m512i vb = broadcast_avx512(b);
+    for( ; last - first >= lanes; first += lanes ) {
+        const __m512i values = _mm512_loadu_si512(first);
+        const unsigned mask = test_avx512<op, T>(values, va, vb);
+        __m512i packed;
+        if constexpr( sizeof(T) == 4 ) packed = _mm512_maskz_compress_epi32(static_cast<__mmask16>(mask), values);
+        else packed = _mm512_maskz_compress_epi64(static_cast<__mmask8>(mask), values);
+        _mm512_storeu_si512(out, packed);
+        out += __builtin_popcount(mask);
+    }
+    return compact_scalar<op>(first, last, out, a, b);
+}
+
+#endif
+
+
+template<compare op, class T>
+inline T* compact(const T* first, const T* last, T* out, const T a, const T b = T()) {
+    static_assert(is_vectorizable_v<T>, "simd::compact only compares arithmetic values");
+#ifdef VIPER_X86_SIMD
+    if constexpr( sizeof(T) == 4 || sizeof(T) == 8 ) {
+        const level cpu = supported();
+        if( cpu >= level::avx512 ) return compact_avx512<op>(first, last, out, a, b);
+        if( cpu >= level::avx2 ) return compact_avx2<op>(first, last, out, a, b);
+    }
+#endif
+    return compact_scalar<op>(first, last, out, a, b);
+}
+
+
+/*
+ * Transposition of small blocks: out(c, r) = in(r, c) for the 'rows' x 'cols' block at 'in',
+ * both blocks row-major, their rows 'in_stride' and 'out_stride' elements apart.
+ * Square tiles of 8x8 (32-bit) or 4x4 (64-bit) elements are transposed in registers,
+ * 4x4 with SSE for 32-bit values, the edges element by element.
+ *
+ * A kernel's block() loads its whole tile before it stores anything, so in and out may be the same tile.
+ */
+template<class T>
+struct TransposeScalar {
+    static constexpr std::size_t size = 1;
+
+    static inline void block(const T* in, std::size_t, T* out, std::size_t) { *out = *in; }
+};
+
+
+#ifdef VIPER_X86_SIMD
+
+template<class T>
+struct TransposeSSE42 {
+    static_assert(sizeof(T) == 4, "the SSE kernel transposes 32-bit values");
+    static constexpr std::size_t size = 4;
+
+    VIPER_TARGET("sse4.2") static void block(const T* in, std::size_t in_stride, T* out, std::size_t out_stride) {
+        const float* i = reinterpret_cast<const float*>(in);
+        float* o = reinterpret_cast<float*>(out);
+        __m128 r0 = _mm_loadu_ps(i), r1 = _mm_loadu_ps(i + in_stride),
+               r2 = _mm_loadu_ps(i + 2*in_stride), r3 = _mm_loadu_ps(i + 3*in_stride);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _mm_storeu_ps(o, r0);
+        _mm_storeu_ps(o + out_stride, r1);
+        _mm_storeu_ps(o + 2*out_stride, r2);
+        _mm_storeu_ps(o + 3*out_stride, r3);
+    }
+};
+
+
+template<class T>
+struct TransposeAVX2 {
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8, "the AVX2 kernel transposes 32-bit and 64-bit values");
+    static constexpr std::size_t size = 32 / sizeof(T);
+
+    VIPER_TARGET("avx2") static void block(const T* in, std::size_t in_stride, T* out, std::size_t out_stride) {
+        if constexpr( sizeof(T) == 4 ) {
+            const float* i = reinterpret_cast<const float*>(in);
+            float* o = reinterpret_cast<float*>(out);
+            __m256 r[8], t[8];
+            for( std::size_t k = 0; k < 8; ++k ) r[k] = _mm256_loadu_ps(i + k*in_stride);
+            // interleave pairs of rows, then pairs of pairs: each 128-bit lane holds a 4x4 transposed quarter
+            for( std::size_t k = 0; k < 8; k += 2 ) {
+                t[k] = _mm256_unpacklo_ps(r[k], r[k+1]);
+                t[k+1] = _mm256_unpackhi_ps(r[k], r[k+1]);
+            }
+            for( std::size_t k = 0; k < 8; k += 4 ) {
+                r[k] = _mm256_shuffle_ps(t[k], t[k+2], _MM_SHUFFLE(1, 0, 1, 0));
+                r[k+1] = _mm256_shuffle_ps(t[k], t[k+2], _MM_SHUFFLE(3, 2, 3, 2));
+                r[k+2] = _mm256_shuffle_ps(t[k+1], t[k+3], _MM_SHUFFLE(1, 0, 1, 0));
+                r[k+3] = _mm256_shuffle_ps(t[k+1], t[k+3], _MM_SHUFFLE(3, 2, 3, 2));
+            }
+            // and swap the off-diagonal quarters
+            for( std::size_t k = 0; k < 4; ++k ) {
+                _mm256_storeu_ps(o + k*out_stride, _mm256_permute2f128_ps(r[k], r[k+4], 0x20));
+                _mm256_storeu_ps(o + (k+4)*out_stride, _mm256_permute2f128_ps(r[k], r[k+4], 0x31));
+            }
+        } else {
+            const double* i = reinterpret_cast<const double*>(in);
+            double* o = reinterpret_cast<double*>(out);
+            const __m256d r0 = _mm256_loadu_pd(i), r1 = _mm256_loadu_pd(i + in_stride),
+                          r2 = _mm256_loadu_pd(i + 2*in_stride), r3 = _mm256_loadu_pd(i + 3*in_stride);
+            const __m256d t0 = _mm256_unpacklo_pd(r0, r1), t1 = _mm256_unpackhi_pd(r0, r1),
+                          t2 = _mm256_unpacklo_pd(r2, r3), t3 = _mm256_unpackhi_pd(r2, r3);
+            _mm256_storeu_pd(o, _mm256_permute2f128_pd(t0, t2, 0x20));
+            _mm256_storeu_pd(o + out_stride, _mm256_permute2f128_pd(t1, t3, 0x20));
+            _mm256_storeu_pd(o + 2*out_stride, _mm256_permute2f128_pd(t0, t2, 0x31));
+            _mm256_storeu_pd(o + 3*out_stride, _mm256_permute2f128_pd(t1, t3, 0x31));
+        }
+    }
+};
+
+#endif
+
+
+template<class T>
+inline void transpose_scalar(const T* in, std::size_t in_stride, T* out, std::size_t out_stride, std::size_t rows, std::size_t cols) {
+    for( std::size_t r = 0; r < rows; ++r ) {
+        for( std::size_t c = 0; c < cols; ++c ) out[c*out_stride + r] = in[r*in_stride + c];
+    }
+}
+
+
+template<class Kernel, class T>
+inline void transpose_blocks(const T* in, std::size_t in_stride, T* out, std::size_t out_stride, std::size_t rows, std::size_t cols) {
+    constexpr std::size_t k = Kernel::size;
+    const std::size_t full_rows = rows / k * k, full_cols = cols / k * k;
+    for( std::size_t r = 0; r < full_rows; r += k ) {
+        for( std::size_t c = 0; c < full_cols; c += k ) Kernel::block(in + r*in_stride + c, in_stride, out + c*out_stride + r, out_stride);
+    }
+    // right and bottom edges
+    transpose_scalar(in + full_cols, in_stride, out + full_cols*out_stride, out_stride, rows, cols - full_cols);
+    transpose_scalar(in + full_rows*in_stride, in_stride, out + full_rows, out_stride, rows - full_rows, full_cols);
+}
+
+
+/*
+ * Exchanges the 'rows' x 'cols' block at 'a' with the transpose of the 'cols' x 'rows' block at 'b':
+ * the two mirror blocks across the diagonal of a square grid. Each tile of 'a' goes through a buffer,
+ * the mirror tile of 'b' is transposed in its place, then the buffer is copied in the place of the tile of 'b'.
+ */
+template<class Kernel, class T>
+inline void transpose_swap_blocks(T* a, T* b, std::size_t stride, std::size_t rows, std::size_t cols) {
+    constexpr std::size_t k = Kernel::size;
+    const std::size_t full_rows = rows / k * k, full_cols = cols / k * k;
+    std::array<T, k*k> buffer;
+    for( std::size_t r = 0; r < full_rows; r += k ) {
+        for( std::size_t c = 0; c < full_cols; c += k ) {
+            T* tile_a = a + r*stride + c;
+            T* tile_b = b + c*stride + r;
+            Kernel::block(tile_a, stride, buffer.data(), k);
+            Kernel::block(tile_b, stride, tile_a, stride);
+            for( std::size_t i = 0; i < k; ++i ) std::copy_n(buffer.data() + i*k, k, tile_b + i*stride);
+        }
+    }
+    for( std::size_t r = 0; r < rows; ++r ) {
+        for( std::size_t c = r < full_rows ? full_cols : 0; c < cols; ++c ) std::swap(a[r*stride + c], b[c*stride + r]);
+    }
+}
+
+
+// transposes the 'size' x 'size' block at 'p' in place
+template<class Kernel, class T>
+inline void transpose_inplace_blocks(T* p, std::size_t stride, std::size_t size) {
+    constexpr std::size_t k = Kernel::size;
+    const std::size_t full = size / k * k;
+    for( std::size_t d = 0; d < full; d += k ) {
+        Kernel::block(p + d*stride + d, stride, p + d*stride + d, stride);
+        // the tiles right of the diagonal with their mirrors below it
+        transpose_swap_blocks<Kernel>(p + d*stride + d + k, p + (d + k)*stride + d, stride, k, full - d - k);
+    }
+    for( std::size_t r = 0; r < size; ++r ) {
+        for( std::size_t c = std::max(r + 1, full); c < size; ++c ) std::swap(p[r*stride + c], p[c*stride + r]);
+    }
+}
+
+
+// the widest kernel for T on this CPU, handed to 'fn' as a type tag
+template<class T, class Function>
+inline void with_transpose_kernel(Function&& fn) {
+#ifdef VIPER_X86_SIMD
+    if constexpr( is_vectorizable_v<T> && (sizeof(T) == 4 || sizeof(T) == 8) ) {
+        const level cpu = supported();
+        if( cpu >= level::avx2 ) return fn(TransposeAVX2<T>());
+        if constexpr( sizeof(T) == 4 ) {
+            if( cpu >= level::sse42 ) return fn(TransposeSSE42<T>());
+        }
+    }
+#endif
+    fn(TransposeScalar<T>());
+}
+
+
+template<class T>
+inline void transpose(const T* in, std::size_t in_stride, T* out, std::size_t out_stride, std::size_t rows, std::size_t cols) {
+    with_transpose_kernel<T>([&](auto kernel) {
+        transpose_blocks<decltype(kernel)>(in, in_stride, out, out_stride, rows, cols);
+    });
+}
+
+
+template<class T>
+inline void transpose_swap(T* a, T* b, std::size_t stride, std::size_t rows, std::size_t cols) {
+    with_transpose_kernel<T>([&](auto kernel) {
+        transpose_swap_blocks<decltype(kernel)>(a, b, stride, rows, cols);
+    });
+}
+
+
+template<class T>
+inline void transpose_inplace(T* p, std::size_t stride, std::size_t size) {
+    with_transpose_kernel<T>([&](auto kernel) {
+        transpose_inplace_blocks<decltype(kernel)>(p, stride, size);
+    });
+}
+
+/*
+ * Reductions (sum, min, max) and dot products of contiguous values, and reductions of every column
+ * of a row-major block at once, a register of adjacent columns at a time down the rows.
+ * min and max need at least one value, and are NaN when one of the values is, whatever their number
+ * and the path they take. Floating point values are summed in a different order
+ * than a sequential loop would, so the rounding of the result can differ slightly.
+ */
+enum class reduction { sum, min, max };
+
+
+// b != b only for NaN, so it sticks once met; for integers the compiler drops the test
+template<reduction op, class T>
+inline T combine(const T a, const T b) {
+    if constexpr( op == reduction::sum ) return a + b;
+    else if constexpr( op == reduction::min ) return b < a || b != b ? b : a;
+    else return a < b || b != b ? b : a;
+}
+
+
+template<reduction op, class T>
+inline T reduce_scalar(const T* p, std::size_t size) {
+    if( size == 0 ) return T();
+    T result = p[0];
+    for( std::size_t i = 1; i < size; ++i ) result = combine<op>(result, p[i]);
+    return result;
+}
+
+
+template<class T>
+inline T dot_scalar(const T* a, const T* b, std::size_t size) {
+    T result = T();
+    for( std::size_t i = 0; i < size; ++i ) result += a[i] * b[i];
+    return result;
+}
+
+
+// the columns of the 'rows' x 'cols' block at 'p' into out[0, cols), sweeping the block row by row
+template<reduction op, class T>
+inline void reduce_columns_scalar(const T* p, std::size_t stride, std::size_t rows, std::size_t cols, T* out) {
+    if( rows == 0 ) {
+        std::fill_n(out, cols, T());
+        return;
+    }
+    std::copy_n(p, cols, out);
+    for( std::size_t r = 1; r < rows; ++r ) {
+        for( std::size_t c = 0; c < cols; ++c ) out[c] = combine<op>(out[c], p[r*stride + c]);
+    }
+}
+
+
+// the types the reduction kernels have registers of
+template<class T>
+constexpr bool is_reducible_v = std::is_same_v<T, float> || std::is_same_v<T, double> || std::is_same_v<T, std::int32_t>;
+
+
+#ifdef VIPER_X86_SIMD
+
+// a register of T, with the operations the reductions need
+template<class T>
+struct VectorAVX2;
+
+template<>
+struct VectorAVX2<float> {
+    using type = __m256;
+    static constexpr std::size_t size = 8;
+    VIPER_TARGET("avx2") static type load(const float* p) { return _mm256_loadu_ps(p); }
+    VIPER_TARGET("avx2") static void store(float* p, type v) { _mm256_storeu_ps(p, v); }
+    VIPER_TARGET("avx2") static type zero() { return _mm256_setzero_ps(); }
+    VIPER_TARGET("avx2") static type add(type a, type b) { return _mm256_add_ps(a, b); }
+    VIPER_TARGET("avx2") static type mul(type a, type b) { return _mm256_mul_ps(a, b); }
+    // vminps and vmaxps give b when either is NaN, a NaN in a is put back so that it propagates like combine()'s
+    VIPER_TARGET("avx2") static type min(type a, type b) { return _mm256_blendv_ps(_mm256_min_ps(a, b), a, _mm256_cmp_ps(a, a, _CMP_UNORD_Q)); }
+    VIPER_TARGET("avx2") static type max(type a, type b) { return _mm256_blendv_ps(_mm256_max_ps(a, b), a, _mm256_cmp_ps(a, a, _CMP_UNORD_Q)); }
+};
+
+template<>
+struct VectorAVX2<double> {
+    using type = __m256d;
+    static constexpr std::size_t size = 4;
+    VIPER_TARGET("avx2") static type load(const double* p) { return _mm256_loadu_pd(p); }
+    VIPER_TARGET("avx2") static void store(double* p, type v) { _mm256_storeu_pd(p, v); }
+    VIPER_TARGET("avx2") static type zero() { return _mm256_setzero_pd(); }
+    VIPER_TARGET("avx2") static type add(type a, type b) { return _mm256_add_pd(a, b); }
+    VIPER_TARGET("avx2") static type mul(type a, type b) { return _mm256_mul_pd(a, b); }
+    // vminpd and vmaxpd give b when either is NaN, a NaN in a is put back so that it propagates like combine()'s
+    VIPER_TARGET("avx2") static type min(type a, type b) { return _mm256_blendv_pd(_mm256_min_pd(a, b), a, _mm256_cmp_pd(a, a, _CMP_UNORD_Q)); }
+    VIPER_TARGET("avx2") static type max(type a, type b) { return _mm256_blendv_pd(_mm256_max_pd(a, b), a, _mm256_cmp_pd(a, a, _CMP_UNORD_Q)); }
+};
+
+template<>
+struct VectorAVX2<std::int32_t> {
+    using type = __m256i;
+    static constexpr std::size_t size = 8;
+    VIPER_TARGET("avx2") static type load(const std::int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    VIPER_TARGET("avx2") static void store(std::int32_t* p, type v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    VIPER_TARGET("avx2") static type zero() { return _mm256_setzero_si256(); }
+    VIPER_TARGET("avx2") static type add(type a, type b) { return _mm256_add_epi32(a, b); }
+    VIPER_TARGET("avx2") static type mul(type a, type b) { return _mm256_mullo_epi32(a, b); }
+    VIPER_TARGET("avx2") static type min(type a, type b) { return _mm256_min_epi32(a, b); }
+    VIPER_TARGET("avx2") static type max(type a, type b) { return _mm256_max_epi32(a, b); }
+};
+
+
+template<reduction op, class Vector>
+VIPER_TARGET("avx2") inline typename Vector::type combine_avx2(const typename Vector::type a, const typename Vector::type b) {
+    if constexpr( op == reduction::sum ) return Vector::add(a, b);
+    else if constexpr( op == reduction::min ) return Vector::min(a, b);
+    else return Vector::max(a, b);
+}
+
+
+// combines the lanes of a register
+template<reduction op, class T>
+VIPER_TARGET("avx2") inline T horizontal_avx2(const typename VectorAVX2<T>::type v) {
+    using vector = VectorAVX2<T>;
+    std::array<T, vector::size> lanes;
+    vector::store(lanes.data(), v);
+    return reduce_scalar<op>(lanes.data(), lanes.size());
+}
+
+
+// four independent accumulators, so that each addition doesn't wait for the previous one
+template<reduction op, class T>
+VIPER_TARGET("avx2") inline T reduce_avx2(const T* p, std::size_t size) {
+    using vector = VectorAVX2<T>;
+    constexpr std::size_t width = vector::size;
+    if( size < 4*width ) return reduce_scalar<op>(p, size);
+
+    auto acc0 = vector::load(p), acc1 = vector::load(p + width), acc2 = vector::load(p + 2*width), acc3 = vector::load(p + 3*width);
+    std::size_t i = 4*width;
+    for( ; i + 4*width <= size; i += 4*width ) {
+        acc0 = combine_avx2<op, vector>(acc0, vector::load(p + i));
+        acc1 = combine_avx2<op, vector>(acc1, vector::load(p + i + width));
+        acc2 = combine_avx2<op, vector>(acc2, vector::load(p + i + 2*width));
+        acc3 = combine_avx2<op, vector>(acc3, vector::load(p + i + 3*width));
+    }
+    for( ; i + width <= size; i += width ) acc0 = combine_avx2<op, vector>(acc0, vector::load(p + i));
+    acc0 = combine_avx2<op, vector>(combine_avx2<op, vector>(acc0, acc1), combine_avx2<op, vector>(acc2, acc3));
+
+    T result = horizontal_avx2<op, T>(acc0);
+    for( ; i < size; ++i ) result = combine<op>(result, p[i]);
+    return result;
+}
+
+
+template<class T>
+VIPER_TARGET("avx2") inline T dot_avx2(const T* a, const T* b, std::size_t size) {
+    using vector = VectorAVX2<T>;
+    constexpr std::size_t width = vector::size;
+    auto acc0 = vector::zero(), acc1 = vector::zero(), acc2 = vector::zero(), acc3 = vector::zero();
+    std::size_t i = 0;
+    for( ; i + 4*width <= size; i += 4*width ) {
+        acc0 = vector::add(acc0, vector::mul(vector::load(a + i), vector::load(b + i)));
+        acc1 = vector::add(acc1, vector::mul(vector::load(a + i + width), vector::load(b + i + width)));
+        acc2 = vector::add(acc2, vector::mul(vector::load(a + i + 2*width), vector::load(b + i + 2*width)));
+        acc3 = vector::add(acc3, vector::mul(vector::load(a + i + 3*width), vector::load(b + i + 3*width)));
+    }
+    for( ; i + width <= size; i += width ) acc0 = vector::add(acc0, vector::mul(vector::load(a + i), vector::load(b + i)));
+    acc0 = vector::add(vector::add(acc0, acc1), vector::add(acc2, acc3));
+
+    T result = horizontal_avx2<reduction::sum, T>(acc0);
+    for( ; i < size; ++i ) result += a[i] * b[i];
+    return result;
+}
+
+
+/*
+ * Each strip of columns four registers wide (two cache lines) is reduced down all the rows
+ * before moving to the next strip: the accumulators never leave the registers, and every cache line
+ * of the block is loaded once.
+ */
+template<reduction op, class T>
+VIPER_TARGET("avx2") inline void reduce_columns_avx2(const T* p, std::size_t stride, std::size_t rows, std::size_t cols, T* out) {
+    using vector = VectorAVX2<T>;
+    constexpr std::size_t width = vector::size;
+    if( rows == 0 ) return reduce_columns_scalar<op>(p, stride, rows, cols, out);
+
+    std::size_t c = 0;
+    for( ; c + 4*width <= cols; c += 4*width ) {
+        const T* strip = p + c;
+        auto acc0 = vector::load(strip), acc1 = vector::load(strip + width), acc2 = vector::load(strip + 2*width), acc3 = vector::load(strip + 3*width);
+        for( std::size_t r = 1; r < rows; ++r ) {
+            strip += stride;
+            acc0 = combine_avx2<op, vector>(acc0, vector::load(strip));
+            acc1 = combine_avx2<op, vector>(acc1, vector::load(strip + width));
+            acc2 = combine_avx2<op, vector>(acc2, vector::load(strip + 2*width));
+            acc3 = combine_avx2<op, vector>(acc3, vector::load(strip + 3*width));
+        }
+        vector::store(out + c, acc0);
+        vector::store(out + c + width, acc1);
+        vector::store(out + c + 2*width, acc2);
+        vector::store(out + c + 3*width, acc3);
+    }
+    for( ; c + width <= cols; c += width ) {
+        auto acc = vector::load(p + c);
+        for( std::size_t r = 1; r < rows; ++r ) acc = combine_avx2<op, vector>(acc, vector::load(p + r*stride + c));
+        vector::store(out + c, acc);
+    }
+    reduce_columns_scalar<op>(p + c, stride, rows, cols - c, out + c);
+}
+
+#endif
+
+
+template<reduction op, class T>
+inline T reduce(const T* p, std::size_t size) {
+#ifdef VIPER_X86_SIMD
+    if constexpr( is_reducible_v<T> ) {
+        if( supported() >= level::avx2 ) return reduce_avx2<op>(p, size);
+    }
+#endif
+    return reduce_scalar<op>(p, size);
+}
+
+
+template<class T>
+inline T dot(const T* a, const T* b, std::size_t size) {
+#ifdef VIPER_X86_SIMD
+    if constexpr( is_reducible_v<T> ) {
+        if( supported() >= level::avx2 ) return dot_avx2(a, b, size);
+    }
+#endif
+    return dot_scalar(a, b, size);
+}
+
+
+template<reduction op, class T>
+inline void reduce_columns(const T* p, std::size_t stride, std::size_t rows, std::size_t cols, T* out) {
+#ifdef VIPER_X86_SIMD
+    if constexpr( is_reducible_v<T> ) {
+        if( supported() >= level::avx2 ) return reduce_columns_avx2<op>(p, stride, rows, cols, out);
+    }
+#endif
+    reduce_columns_scalar<op>(p, stride, rows, cols, out);
+}
+
+} // closing namespace simd
+
+#endif
+#ifndef __VIPER_PREDICATES__
+#define __VIPER_PREDICATES__
+
+
+
+
+/*
+ * Predicates comparing a value against constants.
+ * They can be called like any other predicate, but since the comparison is known,
+ * filter() and filter_inplace() run them through SIMD kernels over arrays of the same arithmetic type.
+ *
+ * For example:
+ * filter_inplace(gt(0.5f), weights);           // keeps the weights > 0.5f
+ * auto adults = filter(between(18, 65), ages);  // 18 <= age && age <= 65
+ */
+template<class T, simd::compare op>
+struct Comparison {
+
+    using value_type = T;
+    static constexpr simd::compare comparison = op;
+
+    T a, b;
+
+    template<class U>
+    constexpr bool operator()(const U& x) const {
+        return simd::test<op>(x, a, b);
+    }
+};
+
+
+template<class Predicate>
+struct is_comparison : std::false_type {};
+
+template<class T, simd::compare op>
+struct is_comparison<Comparison<T, op>> : std::true_type {};
+
+
+template<class T>
+constexpr auto eq(const T& value) { return Comparison<T, simd::compare::eq>{value, value}; }
+
+template<class T>
+constexpr auto ne(const T& value) { return Comparison<T, simd::compare::ne>{value, value}; }
+
+template<class T>
+constexpr auto lt(const T& value) { return Comparison<T, simd::compare::lt>{value, value}; }
+
+template<class T>
+constexpr auto le(const T& value) { return Comparison<T, simd::compare::le>{value, value}; }
+
+template<class T>
+constexpr auto gt(const T& value) { return Comparison<T, simd::compare::gt>{value, value}; }
+
+template<class T>
+constexpr auto ge(const T& value) { return Comparison<T, simd::compare::ge>{value, value}; }
+
+// both bounds included
+template<class T>
+constexpr auto between(const T& low, const T& high) { return Comparison<T, simd::compare::between>{low, high}; }
+
+#endif
+#ifndef __VIPER_FILTER__
+#define __VIPER_FILTER__
+
+
+
+
+/*
+ * How filter() sizes the container it returns.
+ *
+ * two_pass: counts the matches first, then allocates once and copies them.
+ *           The predicate runs twice per element, best for cheap predicates.
+ * one_pass: reserves room for the whole input and copies the matches in a single pass,
+ *           then gives the room back if more than half of it went unused: one or two allocations.
+ *
+ * Without a tag, filter() counts first for stateless predicates over arithmetic values, and goes one pass otherwise,
+ * unless it can compact the values with SIMD, see filter_compact().
+ * Containers without reserve() (std::set, std::list...) are always built straight from a pair of FilterIterators.
+ */
+struct two_pass_t {};
+
+inline constexpr two_pass_t two_pass{};
+
+struct one_pass_t {};
+
+inline constexpr one_pass_t one_pass{};
+
+
+template<class Container, class = void>
+struct has_reserve : std::false_type {};
+
+template<class Container>
+struct has_reserve<Container, std::void_t<decltype(std::declval<Container&>().reserve(std::size_t()))>> : std::true_type {};
+
+
+template<class Container, class = void>
+struct has_shrink_to_fit : std::false_type {};
+
+template<class Container>
+struct has_shrink_to_fit<Container, std::void_t<decltype(std::declval<Container&>().shrink_to_fit())>> : std::true_type {};
+
+
+// a comparison over a contiguous array of values of its own type can go through simd::compact
+template<class Container, class Predicate, class = void>
+struct is_simd_compactable : std::false_type {};
+
+template<class Container, class Predicate>
+struct is_simd_compactable<Container, Predicate, std::void_t<
+    decltype(std::data(std::declval<Container&>())),
+    typename Predicate::value_type
+    >> : std::bool_constant<
+        is_comparison<Predicate>::value
+        && simd::is_vectorizable_v<typename Container::value_type>
+        && std::is_same_v<typename Container::value_type, typename Predicate::value_type>
+        && std::is_same_v<decltype(std::data(std::declval<Container&>())), typename Container::value_type*>
+      > {};
+
+
+template<class ContainerOut, class Predicate, class ContainerIn>
+ContainerOut filter_range(Predicate& fn, const ContainerIn& in) {
+    using filter_type_t = FilterIterator<typename ContainerIn::const_iterator, std::decay_t<Predicate>>;
+    return ContainerOut(
+        filter_type_t(
+                in.cbegin(),
+                in.cend(),
+                fn
+                ),
+        filter_type_t(
+                in.cend(),
+                in.cend(),
+                fn
+                )
+    );
+}
+
+
+template<class ContainerOut, class Predicate, class ContainerIn>
+ContainerOut filter(two_pass_t, Predicate&& fn, const ContainerIn& in) {
+    if constexpr( has_reserve<ContainerOut>::value ) {
+        const auto count = static_cast<std::size_t>(std::count_if(in.cbegin(), in.cend(), std::ref(fn)));
+        ContainerOut out;
+        using value_t = typename ContainerOut::value_type;
+        if constexpr( std::is_trivially_copyable_v<value_t> && std::is_default_constructible_v<value_t> && has_resize<ContainerOut>::value ) {
+            // zero filling is cheaper than checking the capacity on every push_back
+            out.resize(count);
+            std::copy_if(in.cbegin(), in.cend(), out.begin(), std::ref(fn));
+        } else {
+            out.reserve(count);
+            std::copy_if(in.cbegin(), in.cend(), std::back_inserter(out), std::ref(fn));
+        }
+        return out;
+    } else {
+        return filter_range<ContainerOut>(fn, in);
+    }
+}
+
+
+template<class ContainerOut, class Predicate, class ContainerIn>
+ContainerOut filter(one_pass_t, Predicate&& fn, const ContainerIn& in) {
+    if constexpr( has_reserve<ContainerOut>::value ) {
+        ContainerOut out;
+        out.reserve(input_size(in));
+        std::copy_if(in.cbegin(), in.cend(), std::back_inserter(out), std::ref(fn));
+        if( out.capacity() / 2 > out.size() ) out.shrink_to_fit();
+        return out;
+    } else {
+        return filter_range<ContainerOut>(fn, in);
+    }
+}
+
+
+template<class Predicate, class ContainerIn>
+ContainerIn filter(two_pass_t tag, Predicate&& fn, const ContainerIn& in) {
+    return filter<ContainerIn>(tag, std::forward<Predicate>(fn), in);
+}
+
+
+template<class Predicate, class ContainerIn>
+ContainerIn filter(one_pass_t tag, Predicate&& fn, const ContainerIn& in) {
+    return filter<ContainerIn>(tag, std::forward<Predicate>(fn), in);
+}
+
+
+/*
+ * Filters an array of arithmetic values with a comparison (gt(0.5f), between(1, 9)...) without calling
+ * a predicate per element: the output is sized to the input and simd::compact writes the kept values
+ * straight into it, a whole register at a time, then the unused tail is dropped (and given back if
+ * more than half of it went unused, as for one_pass).
+ */
+template<class ContainerOut, class Comparison, class ContainerIn>
+ContainerOut filter_compact(const Comparison& fn, const ContainerIn& in) {
+    const auto size = std::size(in);
+    ContainerOut out;
+    out.resize(size);
+    const auto first = std::data(in);
+    const auto last = simd::compact<Comparison::comparison>(first, first + size, std::data(out), fn.a, fn.b);
+    out.resize(static_cast<std::size_t>(last - std::data(out)));
+    if constexpr( has_shrink_to_fit<ContainerOut>::value ) {
+        if( out.capacity() / 2 > out.size() ) out.shrink_to_fit();
+    }
+    return out;
+}
+
+
+/*
+ * Returns a new container holding the elements of 'in' for which 'fn' returns true.
+ *
+ * The type of 'fn' is kept all the way down to the copy loop, so a lambda is inlined.
+ *
+ * For example:
+ * auto odd = [](int i) { return i % 2 == 1; };
+ * auto odd_numbers = filter(odd, vi);                   // same container type as vi
+ * auto odd_set = filter<std::set<int>>(odd, vi);        // any container constructible from an iterator pair
+ * auto odd_numbers = filter(one_pass, odd, vi);         // pick how the output is sized, see two_pass_t
+ */
+template<class ContainerOut, class Predicate, class ContainerIn>
+ContainerOut filter(Predicate&& fn, const ContainerIn& in) {
+    using value_t = typename ContainerIn::value_type;
+    using predicate_t = std::decay_t<Predicate>;
+    if constexpr( is_simd_compactable<ContainerIn, predicate_t>::value
+                  && is_simd_compactable<ContainerOut, predicate_t>::value
+                  && has_resize<ContainerOut>::value ) {
+        return filter_compact<ContainerOut>(fn, in);
+    } else if constexpr( std::is_empty_v<predicate_t> && std::is_arithmetic_v<value_t> ) {
+        return filter<ContainerOut>(two_pass, std::forward<Predicate>(fn), in);
+    } else {
+        return filter<ContainerOut>(one_pass, std::forward<Predicate>(fn), in);
+    }
+}
+
+
+template<class Predicate, class ContainerIn>
+ContainerIn filter(Predicate&& fn, const ContainerIn& in) {
+    return filter<ContainerIn>(std::forward<Predicate>(fn), in);
+}
+
+
+template<class Container, class Predicate, class = void>
+struct has_member_remove_if : std::false_type {};
+
+template<class Container, class Predicate>
+struct has_member_remove_if<Container, Predicate, std::void_t<
+    decltype(std::declval<Container&>().remove_if(std::declval<Predicate>()))
+    >> : std::true_type {};
+
+
+template<class Container, class = void>
+struct is_associative : std::false_type {};
+
+template<class Container>
+struct is_associative<Container, std::void_t<typename Container::key_type>> : std::true_type {};
+
+
+/*
+ * Erases the elements of 'c' for which 'fn' returns false, keeping the order of the others,
+ * without allocating: std::list & co. relink their nodes, associative containers erase in place,
+ * sequence containers shift the kept elements down (moving them) and drop the tail,
+ * with a SIMD stream compaction for comparisons over arithmetic values (see predicates.h).
+ */
+template<class Container, class Predicate>
+void compact(Container& c, Predicate& fn) {
+    using predicate_t = std::decay_t<Predicate>;
+    auto reject = [&fn](auto& value) { return !fn(value); };
+    if constexpr( is_simd_compactable<Container, predicate_t>::value ) {
+        auto first = std::data(c);
+        auto last = simd::compact<predicate_t::comparison>(first, first + std::size(c), first, fn.a, fn.b);
+        c.erase(c.begin() + (last - first), c.end());
+    } else if constexpr( has_member_remove_if<Container, decltype(reject)>::value ) {
+        c.remove_if(reject);
+    } else if constexpr( is_associative<Container>::value ) {
+        for( auto it = c.begin(); it != c.end(); ) {
+            if( reject(*it) ) it = c.erase(it); else ++it;
+        }
+    } else {
+        c.erase(std::remove_if(c.begin(), c.end(), reject), c.end());
+    }
+}
+
+
+/*
+ * In place filter: erases the elements of 'c' for which 'fn' returns false, keeping the order of the others,
+ * and returns the new size of 'c'. Nothing is allocated, unless the 'shrink' tag asks to give back the unused capacity.
+ *
+ * For example:
+ * filter_inplace(even, vi);           // instead of vi = filter(even, vi);
+ * filter_inplace(shrink, even, vi);   // same, then vi.shrink_to_fit()
+ * filter_inplace(gt(0), vi);          // SIMD stream compaction
+ */
+struct shrink_t {};
+
+inline constexpr shrink_t shrink{};
+
+
+template<class Predicate, class Container>
+std::size_t filter_inplace(Predicate&& fn, Container& c) {
+    compact(c, fn);
+    return input_size(c);
+}
+
+
+template<class Predicate, class Container>
+std::size_t filter_inplace(shrink_t, Predicate&& fn, Container& c) {
+    compact(c, fn);
+    if constexpr( has_shrink_to_fit<Container>::value ) c.shrink_to_fit();
+    return input_size(c);
+}
+
+
+/*
+ * Filtering a temporary moves the elements instead of copying them.
+ * When the output is the same type as the input, it is the input compacted in place:
+ * no allocation at all, and the same buffer is returned.
+ *
+ * For example:
+ * auto long_names = filter(is_long, load_names());   // load_names()'s buffer, with the short names erased
+ */
+template<class ContainerOut, class Predicate, class ContainerIn, std::enable_if_t<!std::is_lvalue_reference_v<ContainerIn> && !std::is_const_v<ContainerIn>, int> = 0>
+ContainerOut filter(Predicate&& fn, ContainerIn&& in) {
+    if constexpr( std::is_same_v<ContainerOut, ContainerIn> ) {
+        compact(in, fn);
+        return std::move(in);
+    } else {
+        ContainerOut out;
+        if constexpr( has_reserve<ContainerOut>::value ) out.reserve(input_size(in));
+        for( auto& value : in ) {
+            if( fn(value) ) out.insert(out.end(), std::move(value));
+        }
+        if constexpr( has_reserve<ContainerOut>::value ) {
+            if( out.capacity() / 2 > out.size() ) out.shrink_to_fit();
+        }
+        return out;
+    }
+}
+
+
+template<class Predicate, class ContainerIn, std::enable_if_t<!std::is_lvalue_reference_v<ContainerIn> && !std::is_const_v<ContainerIn>, int> = 0>
+ContainerIn filter(Predicate&& fn, ContainerIn&& in) {
+    return filter<ContainerIn>(std::forward<Predicate>(fn), std::move(in));
+}
+
+
+/*
+ * Parallel filter over a random access container.
+ *
+ * Each chunk of the input evaluates the predicate once per element and remembers the outcome,
+ * the chunk counts give every chunk its offset in the output, which is allocated once and filled in parallel.
+ * The output keeps the order of the input.
+ *
+ * For example:
+ * auto evens = filter(par, even, records);
+ */
+template<class ContainerOut, class Predicate, class ContainerIn>
+ContainerOut filter(const parallel_policy& policy, Predicate&& fn, const ContainerIn& in) {
+    using category = typename std::iterator_traits<typename ContainerIn::const_iterator>::iterator_category;
+    static_assert(std::is_base_of_v<std::random_access_iterator_tag, category>, "parallel filter needs a random access container");
+
+    const std::size_t size = std::size(in);
+    const std::size_t chunks = chunk_count(policy, size);
+    if( chunks == 1 ) return filter<ContainerOut>(std::forward<Predicate>(fn), in);
+
+    const auto first = in.cbegin();
+    std::vector<unsigned char> keep(size);
+    std::vector<std::size_t> offsets(chunks + 1, 0);
+
+    parallel_chunks(chunks, size, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+        std::size_t count = 0;
+        for( std::size_t i = begin; i < end; ++i ) {
+            keep[i] = fn(first[i]) ? 1 : 0;
+            count += keep[i];
+        }
+        offsets[chunk+1] = count;
+    });
+
+    for( std::size_t chunk = 0; chunk < chunks; ++chunk ) offsets[chunk+1] += offsets[chunk];
+
+    using out_value_t = typename ContainerOut::value_type;
+    using out_category = typename std::iterator_traits<typename ContainerOut::iterator>::iterator_category;
+    if constexpr( std::is_base_of_v<std::random_access_iterator_tag, out_category> && std::is_default_constructible_v<out_value_t>
+               && has_resize<ContainerOut>::value && !is_bit_packed<ContainerOut>::value ) {
+        ContainerOut out;
+        out.resize(offsets[chunks]);
+        auto out_first = out.begin();
+        parallel_chunks(chunks, size, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+            auto out_it = out_first + offsets[chunk];
+            for( std::size_t i = begin; i < end; ++i ) {
+                if( keep[i] ) *out_it++ = first[i];
+            }
+        });
+        return out;
+    } else {
+        // std::set & co., std::vector<bool> and containers that can't be sized upfront can't be written to in parallel,
+        // at least the predicate ran in parallel
+        ContainerOut out;
+        auto inserter = std::inserter(out, out.end());
+        for( std::size_t i = 0; i < size; ++i ) {
+            if( keep[i] ) *inserter++ = first[i];
+        }
+        return out;
+    }
+}
+
+
+template<class Predicate, class ContainerIn>
+ContainerIn filter(const parallel_policy& policy, Predicate&& fn, const ContainerIn& in) {
+    return filter<ContainerIn>(policy, std::forward<Predicate>(fn), in);
+}
+
+#endif
+#ifndef __VIPER_GRID__
+#define __VIPER_GRID__
+
+
+
+#if defined(__unix__) || defined(__APPLE__)
+#endif
+
+
+//
+// LAYOUTS
+//
+// Where the element at row r, column c of a 'rows' x 'cols' grid is in its container: offset(r, c, rows, cols).
+// size(rows, cols) is how many elements the container has to hold.
+// A layout whose rows (columns) are contiguous says so with contiguous_rows (contiguous_cols).
+//
+
+
+// one row after the other, C style
+struct row_major {
+    static constexpr bool contiguous_rows = true;
+    static constexpr bool contiguous_cols = false;
+
+    static constexpr std::size_t offset(std::size_t r, std::size_t c, std::size_t, std::size_t cols) noexcept { return r*cols + c; }
+
+    static constexpr std::size_t size(std::size_t rows, std::size_t cols) noexcept { return rows*cols; }
+};
+
+
+// one column after the other, Fortran and BLAS style
+struct column_major {
+    static constexpr bool contiguous_rows = false;
+    static constexpr bool contiguous_cols = true;
+
+    static constexpr std::size_t offset(std::size_t r, std::size_t c, std::size_t rows, std::size_t) noexcept { return c*rows + r; }
+
+    static constexpr std::size_t size(std::size_t rows, std::size_t cols) noexcept { return rows*cols; }
+};
+
+
+// row-major, each row starting 'leading_dimension' elements after the previous one (at least 'cols')
+template<std::size_t leading_dimension>
+struct padded_row_major {
+    static constexpr bool contiguous_rows = true;
+    static constexpr bool contiguous_cols = false;
+
+    static constexpr std::size_t offset(std::size_t r, std::size_t c, std::size_t, std::size_t) noexcept { return r*leading_dimension + c; }
+
+    static constexpr std::size_t size(std::size_t rows, std::size_t) noexcept { return rows*leading_dimension; }
+};
+
+
+// column-major, each column starting 'leading_dimension' elements after the previous one (at least 'rows'), BLAS's lda
+template<std::size_t leading_dimension>
+struct padded_column_major {
+    static constexpr bool contiguous_rows = false;
+    static constexpr bool contiguous_cols = true;
+
+    static constexpr std::size_t offset(std::size_t r, std::size_t c, std::size_t, std::size_t) noexcept { return c*leading_dimension + r; }
+
+    static constexpr std::size_t size(std::size_t, std::size_t cols) noexcept { return cols*leading_dimension; }
+};
+
+
+/*
+ * 'tile_rows' x 'tile_cols' tiles one after the other, left to right then top to bottom,
+ * each tile row-major. Tiles on the bottom and right edges are stored whole, padding included.
+ */
+template<std::size_t tile_rows, std::size_t tile_cols>
+struct tiled {
+    static_assert(tile_rows > 0 && tile_cols > 0, "tiles have at least one element");
+
+    static constexpr bool contiguous_rows = false;
+    static constexpr bool contiguous_cols = false;
+
+    static constexpr std::size_t offset(std::size_t r, std::size_t c, std::size_t, std::size_t cols) noexcept {
+        const std::size_t across = (cols + tile_cols - 1) / tile_cols;
+        return ((r / tile_rows) * across + c / tile_cols) * (tile_rows * tile_cols) + (r % tile_rows) * tile_cols + c % tile_cols;
+    }
+
+    static constexpr std::size_t size(std::size_t rows, std::size_t cols) noexcept {
+        return (rows + tile_rows - 1) / tile_rows * tile_rows * ((cols + tile_cols - 1) / tile_cols * tile_cols);
+    }
+};
+
+
+/*
+ * A column of a 'rows' x 'cols' grid stored in 'SequenceContainer' as 'Layout' says, see LAYOUTS.
+ * Its iterators step from one element of the column to the next by the distance between them in the layout:
+ * 'cols' elements for row-major grids, one for column-major ones.
+ */
+template<std::size_t column_number, std::size_t rows, std::size_t cols, class SequenceContainer, class Layout = row_major>
+class ColumnDimension {
+
+    protected:
+
+    const SequenceContainer& data;
+
+    static constexpr std::size_t offset(std::size_t pos) noexcept {
+        return Layout::offset(pos, column_number, rows, cols);
+    }
+
+    public:
+
+    template<typename iterator>
+    class ColumnIterator {
+
+        public:
+
+            using difference_type = typename std::iterator_traits<iterator>::difference_type;
+            using value_type = typename std::iterator_traits<iterator>::value_type;
+            using pointer = typename std::iterator_traits<iterator>::pointer;
+            using reference = typename std::iterator_traits<iterator>::reference;
+            using const_reference = typename std::iterator_traits<iterator>::reference;
+            using iterator_category = typename std::iterator_traits<iterator>::iterator_category;
+
+        protected:
+
+            iterator _iter;
+            std::size_t _pos;
+
+        public:
+
+            ColumnIterator(const iterator& iter, std::size_t pos = 0): _iter(iter), _pos(pos) {}
+
+            inline typename std::conditional<std::is_const<iterator>::value, const_reference, reference>::type operator*() const {
+                return *_iter;
+            }
+
+            inline auto operator!=(const ColumnIterator<iterator>& rhs) const {
+                return _pos != rhs._pos;
+            }
+
+            // the last element doesn't step any further, past the end of the container
+            inline auto operator++() {
+                if( ++_pos < rows ) std::advance(_iter, static_cast<difference_type>(offset(_pos)) - static_cast<difference_type>(offset(_pos - 1)));
+                return *this;
+            }
+
+    };
+
+    using container_t = std::remove_reference_t<SequenceContainer>;
+    using layout_t = Layout;
+    using value_type = typename container_t::value_type;
+    using size_type = typename container_t::size_type;
+    using difference_type = typename container_t::difference_type;
+    using reference = typename container_t::reference;
+    using const_reference = typename container_t::const_reference;
+    using pointer = typename container_t::pointer;
+    using const_pointer = typename container_t::const_pointer;
+    using iterator = ColumnIterator<typename container_t::iterator>;
+    using const_iterator = ColumnIterator<typename container_t::const_iterator>;
+
+    constexpr ColumnDimension(const SequenceContainer& container)
+        :data(container) {}
+
+    //
+    // READ OPS
+    //
+
+    constexpr size_type size() const noexcept {
+        return rows;
+    }
+
+    constexpr const_reference operator[]( size_type pos ) const {
+        return data[ offset(pos) ];
+    }
+
+    //
+    // WRITE OPS
+    //
+
+    constexpr reference operator[]( size_type pos ) {
+        return data[ offset(pos) ];
+    }
+
+    constexpr iterator begin() { return iterator(std::next(data.begin(), offset(0))); }
+
+    constexpr iterator end() { return iterator(std::next(data.begin(), offset(0)), rows); }
+
+    constexpr const_iterator cbegin() const { return const_iterator(std::next(data.cbegin(), offset(0))); }
+
+    constexpr const_iterator cend() const { return const_iterator(std::next(data.cbegin(), offset(0)), rows); }
+
+};
+
+
+// a row of a 'rows' x 'cols' grid stored in 'SequenceContainer' as 'Layout' says, see ColumnDimension
+template<std::size_t row_number, std::size_t rows, std::size_t cols, class SequenceContainer, class Layout = row_major>
+class RowDimension {
+
+    protected:
+
+        const SequenceContainer& data;
+
+        static constexpr std::size_t offset(std::size_t pos) noexcept {
+            return Layout::offset(row_number, pos, rows, cols);
+        }
+
+    public:
+
+        template<typename iterator>
+            class RowIterator {
+
+                public:
+
+                    using difference_type = typename std::iterator_traits<iterator>::difference_type;
+                    using value_type = typename std::iterator_traits<iterator>::value_type;
+                    using pointer = typename std::iterator_traits<iterator>::pointer;
+                    using reference = typename std::iterator_traits<iterator>::reference;
+                    using const_reference = typename std::iterator_traits<iterator>::reference;
+                    using iterator_category = typename std::iterator_traits<iterator>::iterator_category;
+
+                protected:
+
+                    iterator _iter;
+                    std::size_t _pos;
+
+                public:
+
+                    RowIterator(const iterator& iter, std::size_t pos = 0): _iter(iter), _pos(pos) {}
+
+                    inline typename std::conditional<std::is_const<iterator>::value, const_reference, reference>::type operator*() const {
+                        return *_iter;
+                    }
+
+                    inline auto operator!=(const RowIterator<iterator>& rhs) const {
+                        return _pos != rhs._pos;
+                    }
+
+                    inline auto operator++() {
+                        if( ++_pos < cols ) std::advance(_iter, static_cast<difference_type>(offset(_pos)) - static_cast<difference_type>(offset(_pos - 1)));
+                        return *this;
+                    }
+
+            };
+
+        using container_t = std::remove_reference_t<SequenceContainer>;
+        using layout_t = Layout;
+        using value_type = typename container_t::value_type;
+        using size_type = typename container_t::size_type;
+        using difference_type = typename container_t::difference_type;
+        using reference = typename container_t::reference;
+        using const_reference = typename container_t::const_reference;
+        using pointer = typename container_t::pointer;
+        using const_pointer = typename container_t::const_pointer;
+        using iterator = RowIterator<typename container_t::iterator>;
+        using const_iterator = RowIterator<typename container_t::const_iterator>;
+
+        constexpr RowDimension(const SequenceContainer& container)
+            :data(container) {}
+
+        //
+        // READ OPS
+        //
+
+        constexpr size_type size() const noexcept {
+            return cols;
+        }
+
+        constexpr const_reference operator[]( size_type pos ) const {
+            return data[ offset(pos) ];
+        }
+
+        constexpr const_iterator cbegin() const { return const_iterator(std::next(data.cbegin(), offset(0))); }
+
+        constexpr const_iterator cend() const { return const_iterator(std::next(data.cbegin(), offset(0)), cols); }
+
+        //
+        // WRITE OPS
+        //
+
+        constexpr reference operator[]( size_type pos ) {
+            return data[ offset(pos) ];
+        }
+
+        constexpr iterator begin() { return iterator(std::next(data.begin(), offset(0))); }
+
+        constexpr iterator end() { return iterator(std::next(data.begin(), offset(0)), cols); }
+};
+
+
+/*
+ * The layout comes after the dimensions, row-major unless told otherwise:
+ *
+ * std::array<double, 6> fortran = ...;                    // 2 x 3, column-major
+ * for( auto x : col<1, 2, 3, column_major>(fortran) ) { ... }
+ * auto r = row<0, 2, 3, column_major>(fortran);            // r[2] == fortran[4]
+ */
+template<std::size_t column_number, std::size_t rows, std::size_t cols, class Layout = row_major, class SequenceContainer>
+inline auto col(SequenceContainer&& container) {
+    return ColumnDimension<
+        column_number,
+        rows,
+        cols,
+        SequenceContainer,
+        Layout
+            > (std::forward<SequenceContainer>(container));
+}
+
+
+template<std::size_t row_number, std::size_t rows, std::size_t cols, class Layout = row_major, class SequenceContainer>
+inline auto row(SequenceContainer&& container) {
+    return RowDimension<
+        row_number,
+        rows,
+        cols,
+        SequenceContainer,
+        Layout
+            > (std::forward<SequenceContainer>(container));
+}
+
+
+//
+// RUNTIME DIMENSIONS
+//
+// The views below take their dimensions as arguments, for grids whose size is only known at runtime.
+// Like the compile-time ones, they don't own anything: they alias the container they were made from.
+//
+
+
+/*
+ * Random access iterator over every 'stride'-th element, walking a column of a row-major grid.
+ * It keeps its position as an offset from the first element, so the end of the last column
+ * never points past the end of the container.
+ */
+template<class Iterator>
+class StridedIterator {
+
+    using traits_t = std::iterator_traits<Iterator>;
+
+    public:
+
+        using difference_type = typename traits_t::difference_type;
+        using value_type = typename traits_t::value_type;
+        using pointer = typename traits_t::pointer;
+        using reference = typename traits_t::reference;
+        using iterator_category = std::random_access_iterator_tag;
+
+    private:
+
+        Iterator _first;
+        difference_type _pos;
+        difference_type _stride;
+
+    public:
+
+        StridedIterator(Iterator first, difference_type pos, difference_type stride)
+            : _first(std::move(first)), _pos(pos), _stride(stride) {}
+
+        inline difference_type stride() const noexcept { return _stride; }
+
+        inline reference operator*() const {
+            return _first[_pos * _stride];
+        }
+
+        inline reference operator[](difference_type n) const {
+            return _first[(_pos + n) * _stride];
+        }
+
+        inline bool operator==(const StridedIterator& rhs) const {
+            return _pos == rhs._pos;
+        }
+
+        inline bool operator!=(const StridedIterator& rhs) const {
+            return _pos != rhs._pos;
+        }
+
+        inline bool operator<(const StridedIterator& rhs) const {
+            return _pos < rhs._pos;
+        }
+
+        inline bool operator>(const StridedIterator& rhs) const {
+            return _pos > rhs._pos;
+        }
+
+        inline bool operator<=(const StridedIterator& rhs) const {
+            return _pos <= rhs._pos;
+        }
+
+        inline bool operator>=(const StridedIterator& rhs) const {
+            return _pos >= rhs._pos;
+        }
+
+        inline difference_type operator-(const StridedIterator& rhs) const {
+            return _pos - rhs._pos;
+        }
+
+        inline StridedIterator& operator++() {
+            ++_pos;
+            return *this;
+        }
+
+        inline auto operator++(int) {
+            auto iterator{*this};
+            operator++();
+            return iterator;
+        }
+
+        inline StridedIterator& operator--() {
+            --_pos;
+            return *this;
+        }
+
+        inline auto operator--(int) {
+            auto iterator{*this};
+            operator--();
+            return iterator;
+        }
+
+        inline StridedIterator& operator+=(difference_type n) {
+            _pos += n;
+            return *this;
+        }
+
+        inline StridedIterator& operator-=(difference_type n) {
+            _pos -= n;
+            return *this;
+        }
+
+        inline StridedIterator operator+(difference_type n) const {
+            auto iterator{*this};
+            return iterator += n;
+        }
+
+        inline StridedIterator operator-(difference_type n) const {
+            auto iterator{*this};
+            return iterator -= n;
+        }
+};
+
+
+/*
+ * A row of a grid: 'size' consecutive elements.
+ * Its iterators are the container's own (a plain pointer for contiguous containers, see grid()),
+ * so a loop over a row compiles as a loop over an array.
+ */
+template<class Iterator>
+class RowView {
+
+    using traits_t = std::iterator_traits<Iterator>;
+
+    Iterator _first;
+    std::size_t _size;
+
+    public:
+
+        using value_type = typename traits_t::value_type;
+        using size_type = std::size_t;
+        using difference_type = typename traits_t::difference_type;
+        using reference = typename traits_t::reference;
+        using pointer = typename traits_t::pointer;
+        using iterator = Iterator;
+        using const_iterator = Iterator;
+
+        RowView(Iterator first, size_type size) : _first(std::move(first)), _size(size) {}
+
+        inline size_type size() const noexcept { return _size; }
+
+        inline reference operator[](size_type pos) const {
+            return _first[static_cast<difference_type>(pos)];
+        }
+
+        inline iterator begin() const { return _first; }
+
+        inline iterator end() const { return _first + static_cast<difference_type>(_size); }
+
+        inline const_iterator cbegin() const { return begin(); }
+
+        inline const_iterator cend() const { return end(); }
+};
+
+
+// a column of a grid: 'size' elements, 'stride' apart
+template<class Iterator>
+class ColumnView {
+
+    using traits_t = std::iterator_traits<Iterator>;
+
+    Iterator _first;
+    std::size_t _size;
+    typename traits_t::difference_type _stride;
+
+    public:
+
+        using value_type = typename traits_t::value_type;
+        using size_type = std::size_t;
+        using difference_type = typename traits_t::difference_type;
+        using reference = typename traits_t::reference;
+        using pointer = typename traits_t::pointer;
+        using iterator = StridedIterator<Iterator>;
+        using const_iterator = iterator;
+
+        ColumnView(Iterator first, size_type size, difference_type stride)
+            : _first(std::move(first)), _size(size), _stride(stride) {}
+
+        inline size_type size() const noexcept { return _size; }
+
+        inline difference_type stride() const noexcept { return _stride; }
+
+        inline reference operator[](size_type pos) const {
+            return _first[static_cast<difference_type>(pos) * _stride];
+        }
+
+        inline iterator begin() const { return iterator(_first, 0, _stride); }
+
+        inline iterator end() const { return iterator(_first, static_cast<difference_type>(_size), _stride); }
+
+        inline const_iterator cbegin() const { return begin(); }
+
+        inline const_iterator cend() const { return end(); }
+};
+
+
+/*
+ * Random access iterator over a range of views made on the fly (rows, columns, tiles of a grid):
+ * it keeps a copy of the range, which is just a few words, and a position in it.
+ */
+template<class Range>
+class IndexIterator {
+
+    Range _range;
+    std::ptrdiff_t _pos;
+
+    public:
+
+        using difference_type = std::ptrdiff_t;
+        using value_type = typename Range::value_type;
+        using pointer = void;
+        using reference = value_type;
+        using iterator_category = std::random_access_iterator_tag;
+
+        IndexIterator(Range range, difference_type pos) : _range(std::move(range)), _pos(pos) {}
+
+        inline reference operator*() const {
+            return _range[static_cast<std::size_t>(_pos)];
+        }
+
+        inline reference operator[](difference_type n) const {
+            return _range[static_cast<std::size_t>(_pos + n)];
+        }
+
+        inline bool operator==(const IndexIterator& rhs) const {
+            return _pos == rhs._pos;
+        }
+
+        inline bool operator!=(const IndexIterator& rhs) const {
+            return _pos != rhs._pos;
+        }
+
+        inline bool operator<(const IndexIterator& rhs) const {
+            return _pos < rhs._pos;
+        }
+
+        inline bool operator>(const IndexIterator& rhs) const {
+            return _pos > rhs._pos;
+        }
+
+        inline bool operator<=(const IndexIterator& rhs) const {
+            return _pos <= rhs._pos;
+        }
+
+        inline bool operator>=(const IndexIterator& rhs) const {
+            return _pos >= rhs._pos;
+        }
+
+        inline difference_type operator-(const IndexIterator& rhs) const {
+            return _pos - rhs._pos;
+        }
+
+        inline IndexIterator& operator++() {
+            ++_pos;
+            return *this;
+        }
+
+        inline auto operator++(int) {
+            auto iterator{*this};
+            operator++();
+            return iterator;
+        }
+
+        inline IndexIterator& operator--() {
+            --_pos;
+            return *this;
+        }
+
+        inline auto operator--(int) {
+            auto iterator{*this};
+            operator--();
+            return iterator;
+        }
+
+        inline IndexIterator& operator+=(difference_type n) {
+            _pos += n;
+            return *this;
+        }
+
+        inline IndexIterator& operator-=(difference_type n) {
+            _pos -= n;
+            return *this;
+        }
+
+        inline IndexIterator operator+(difference_type n) const {
+            auto iterator{*this};
+            return iterator += n;
+        }
+
+        inline IndexIterator operator-(difference_type n) const {
+            auto iterator{*this};
+            return iterator -= n;
+        }
+};
+
+
+// the range of all the rows, or all the columns, of a grid
+template<class Grid, bool columns>
+class Lines {
+
+    Grid _grid;
+    std::size_t _size;
+
+    public:
+
+        using value_type = std::conditional_t<columns, typename Grid::column_type, typename Grid::row_type>;
+        using reference = value_type;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using iterator = IndexIterator<Lines>;
+        using const_iterator = iterator;
+
+        Lines(Grid grid, size_type size) : _grid(std::move(grid)), _size(size) {}
+
+        inline size_type size() const noexcept { return _size; }
+
+        inline const Grid& grid() const noexcept { return _grid; }
+
+        inline reference operator[](size_type pos) const {
+            if constexpr( columns ) return _grid.col(pos);
+            else return _grid.row(pos);
+        }
+
+        inline iterator begin() const { return iterator(*this, 0); }
+
+        inline iterator end() const { return iterator(*this, static_cast<difference_type>(_size)); }
+
+        inline const_iterator cbegin() const { return begin(); }
+
+        inline const_iterator cend() const { return end(); }
+};
+
+
+template<class Grid>
+class Tiles;
+
+
+/*
+ * A flat sequence container seen as a row-major grid of 'height' rows of 'width' elements,
+ * each row starting 'stride' elements after the previous one (the width unless the grid is part of a larger one).
+ *
+ * For example:
+ * std::vector<float> pixels = load(path, height, width);
+ * auto image = grid(pixels, height, width);
+ *
+ * image(r, c) = 0.f;
+ * for( auto& pixel : image.row(r) ) { ... }
+ * for( auto& pixel : image.col(c) ) { ... }
+ *
+ * rows() and cols() are random access ranges of all the rows and columns,
+ * for nested loops, algorithms, or parallel_for:
+ *
+ * for( auto row : image.rows() ) {
+ *     for( auto& pixel : row ) { ... }
+ * }
+ * parallel_for(enumerate(image.rows()), [](auto&& indexed) { ... });
+ *
+ * tiles() cuts it in blocks small enough to stay in cache, see Tiles.
+ */
+template<class Iterator>
+class Grid {
+
+    Iterator _first;
+    std::size_t _height, _width, _stride;
+
+    public:
+
+        using value_type = typename std::iterator_traits<Iterator>::value_type;
+        using size_type = std::size_t;
+        using difference_type = typename std::iterator_traits<Iterator>::difference_type;
+        using reference = typename std::iterator_traits<Iterator>::reference;
+        using row_type = RowView<Iterator>;
+        using column_type = ColumnView<Iterator>;
+
+        Grid(Iterator first, size_type height, size_type width)
+            : Grid(std::move(first), height, width, width) {}
+
+        Grid(Iterator first, size_type height, size_type width, size_type stride)
+            : _first(std::move(first)), _height(height), _width(width), _stride(stride) {}
+
+        inline size_type height() const noexcept { return _height; }
+
+        inline size_type width() const noexcept { return _width; }
+
+        inline size_type stride() const noexcept { return _stride; }
+
+        inline size_type size() const noexcept { return _height * _width; }
+
+        // the top left element
+        inline const Iterator& base() const noexcept { return _first; }
+
+        inline reference operator()(size_type r, size_type c) const {
+            return _first[static_cast<difference_type>(r * _stride + c)];
+        }
+
+        inline row_type row(size_type r) const {
+            return row_type(_first + static_cast<difference_type>(r * _stride), _width);
+        }
+
+        inline column_type col(size_type c) const {
+            return column_type(_first + static_cast<difference_type>(c), _height, static_cast<difference_type>(_stride));
+        }
+
+        inline Lines<Grid, false> rows() const {
+            return Lines<Grid, false>(*this, _height);
+        }
+
+        inline Lines<Grid, true> cols() const {
+            return Lines<Grid, true>(*this, _width);
+        }
+
+        // the 'height' x 'width' block whose top left element is (r, c), sharing this grid's elements
+        inline Grid block(size_type r, size_type c, size_type height, size_type width) const {
+            return Grid(_first + static_cast<difference_type>(r * _stride + c), height, width, _stride);
+        }
+
+        /*
+         * The rows [0, at) and [at, height()) as two grids, or the columns with split_cols,
+         * split() cuts the larger dimension in halves: blocks of a grid can be split again and again,
+         * for divide-and-conquer, at the cost of a few additions.
+         */
+        inline std::pair<Grid, Grid> split_rows(size_type at) const {
+            return {block(0, 0, at, _width), block(at, 0, _height - at, _width)};
+        }
+
+        inline std::pair<Grid, Grid> split_cols(size_type at) const {
+            return {block(0, 0, _height, at), block(0, at, _height, _width - at)};
+        }
+
+        inline std::pair<Grid, Grid> split() const {
+            return _height >= _width ? split_rows(_height / 2) : split_cols(_width / 2);
+        }
+
+        inline Tiles<Grid> tiles() const;
+
+        inline Tiles<Grid> tiles(size_type tile_height, size_type tile_width) const;
+};
+
+
+//
+// CACHE BLOCKING
+//
+
+
+/*
+ * A cache parameter as sysconf reports it, or 'fallback' when it can't tell: sysconf returns 0 or -1
+ * in some containers, on CPUs the C library doesn't know and on systems other than glibc's.
+ * Values outside [low, high] are taken for garbage as well, rather than sizing tiles after them.
+ */
+inline std::size_t cache_parameter(long reported, std::size_t fallback, std::size_t low, std::size_t high) noexcept {
+    if( reported <= 0 ) return fallback;
+    const auto value = static_cast<std::size_t>(reported);
+    return value >= low && value <= high ? value : fallback;
+}
+
+
+// size in bytes of the L1 data cache, 32KiB when the system can't tell
+inline std::size_t l1_cache_size() noexcept {
+#if defined(_SC_LEVEL1_DCACHE_SIZE)
+    static const std::size_t size = cache_parameter(sysconf(_SC_LEVEL1_DCACHE_SIZE), 32 * 1024, 4 * 1024, 1024 * 1024);
+    return size;
+#else
+    return 32 * 1024;
+#endif
+}
+
+
+// number of ways of the L1 data cache, 8 when the system can't tell
+inline std::size_t l1_cache_ways() noexcept {
+#if defined(_SC_LEVEL1_DCACHE_ASSOC)
+    static const std::size_t ways = cache_parameter(sysconf(_SC_LEVEL1_DCACHE_ASSOC), 8, 1, 64);
+    return ways;
+#else
+    return 8;
+#endif
+}
+
+
+/*
+ * Tile dimensions (height, width) for a grid of T, sized after the L1 data cache only:
+ * a tile fills half of it, and spans no more rows than it has ways. When the stride is a multiple of 4KiB
+ * all the rows of a column land in the same cache set, they still fit in it.
+ * Its width is a whole number of cache lines. L2 and L3 aren't taken into account, for tiles
+ * of work that reuses them pass the dimensions to tiles(height, width).
+ */
+template<class T>
+inline std::pair<std::size_t, std::size_t> default_tile_size(std::size_t cache_size, std::size_t cache_ways) noexcept {
+    constexpr std::size_t line = 64 / sizeof(T) ? 64 / sizeof(T) : 1;
+    const std::size_t budget = cache_size / 2 / sizeof(T);
+    const std::size_t height = std::max<std::size_t>(1, std::min(cache_ways, budget / line));
+    const std::size_t width = std::max(line, budget / height / line * line);
+    return {height, width};
+}
+
+template<class T>
+inline std::pair<std::size_t, std::size_t> default_tile_size() noexcept {
+    return default_tile_size<T>(l1_cache_size(), l1_cache_ways());
+}
+
+
+/*
+ * A grid cut in tiles, visited one after the other (left to right, then top to bottom), each tile a Grid itself.
+ * Work that sweeps columns, like reducing them, runs tile by tile at about the speed of a row-major sweep:
+ * the cache lines of a tile are all loaded by its first column and reused by the next ones.
+ *
+ * For example:
+ * std::vector<double> sums(image.width());
+ * for( auto tile : image.tiles() ) {
+ *     for( std::size_t c = 0; c < tile.width(); ++c ) {
+ *         for( auto pixel : tile.col(c) ) sums[tile.left() + c] += pixel;
+ *     }
+ * }
+ *
+ * Tiles on the bottom and right edges are cut down to what is left of the grid.
+ */
+template<class Grid>
+class Tile : public Grid {
+
+    std::size_t _top, _left;
+
+    public:
+
+        Tile(Grid grid, std::size_t top, std::size_t left) : Grid(std::move(grid)), _top(top), _left(left) {}
+
+        // row and column of the parent grid where this tile starts
+        inline std::size_t top() const noexcept { return _top; }
+
+        inline std::size_t left() const noexcept { return _left; }
+};
+
+
+template<class Grid>
+class Tiles {
+
+    Grid _grid;
+    std::size_t _tile_height, _tile_width;
+    std::size_t _across;
+
+    public:
+
+        using value_type = Tile<Grid>;
+        using reference = value_type;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using iterator = IndexIterator<Tiles>;
+        using const_iterator = iterator;
+
+        Tiles(Grid grid, size_type tile_height, size_type tile_width)
+            : _grid(std::move(grid)),
+              _tile_height(std::max<size_type>(1, tile_height)),
+              _tile_width(std::max<size_type>(1, tile_width)),
+              _across((_grid.width() + _tile_width - 1) / _tile_width) {}
+
+        // number of tiles down and across the grid
+        inline size_type height() const noexcept { return (_grid.height() + _tile_height - 1) / _tile_height; }
+
+        inline size_type width() const noexcept { return _across; }
+
+        inline size_type size() const noexcept { return height() * width(); }
+
+        inline reference operator[](size_type pos) const {
+            const size_type top = pos / _across * _tile_height;
+            const size_type left = pos % _across * _tile_width;
+            const size_type height = std::min(_tile_height, _grid.height() - top);
+            const size_type width = std::min(_tile_width, _grid.width() - left);
+            return value_type(_grid.block(top, left, height, width), top, left);
+        }
+
+        inline iterator begin() const { return iterator(*this, 0); }
+
+        inline iterator end() const { return iterator(*this, static_cast<difference_type>(size())); }
+
+        inline const_iterator cbegin() const { return begin(); }
+
+        inline const_iterator cend() const { return end(); }
+};
+
+
+template<class Iterator>
+inline Tiles<Grid<Iterator>> Grid<Iterator>::tiles() const {
+    const auto [tile_height, tile_width] = default_tile_size<value_type>();
+    return tiles(tile_height, tile_width);
+}
+
+
+template<class Iterator>
+inline Tiles<Grid<Iterator>> Grid<Iterator>::tiles(size_type tile_height, size_type tile_width) const {
+    return Tiles<Grid>(*this, tile_height, tile_width);
+}
+
+
+/*
+ * Where a view of 'container' starts: a pointer when its elements are contiguous (std::vector, std::array...),
+ * so views over it work on plain pointers, its begin() otherwise (std::deque...).
+ */
+template<class SequenceContainer, class = void>
+struct has_data : std::false_type {};
+
+template<class SequenceContainer>
+struct has_data<SequenceContainer, std::void_t<decltype(std::data(std::declval<SequenceContainer&>()))>> : std::true_type {};
+
+template<class SequenceContainer>
+inline auto first_element(SequenceContainer& container) {
+    if constexpr( has_data<SequenceContainer>::value ) return std::data(container);
+    else return std::begin(container);
+}
+
+
+// views don't own the container, so a temporary one is rejected rather than left dangling
+template<class SequenceContainer>
+inline auto grid(SequenceContainer&& container, std::size_t rows, std::size_t cols) {
+    static_assert(std::is_lvalue_reference_v<SequenceContainer>, "grid() views a container without owning it, a temporary would be destroyed under the view");
+    return Grid<decltype(first_element(container))>(first_element(container), rows, cols);
+}
+
+
+/*
+ * The 'height' x 'width' window of 'grid' whose top left element is (top, left), to hand part of a grid to a worker.
+ * It aliases the parent's elements, its rows are as far apart as the parent's (its stride(), BLAS's leading dimension),
+ * and it has rows, columns, tiles and sub-grids of its own. The window has to fit in the grid.
+ *
+ * For example, rows 100 to 199 and columns 50 to 79:
+ * auto window = subgrid(image, 100, 50, 100, 30);
+ * for( auto& pixel : window.col(0) ) { ... }        // column 50 of image, from row 100 to row 199
+ *
+ * void scale(Grid<float*> g, float factor) {
+ *     if( g.size() <= 4096 ) {
+ *         for( auto row : g.rows() ) { for( auto& x : row ) x *= factor; }
+ *         return;
+ *     }
+ *     auto [first, second] = g.split();      // each half to a worker
+ *     scale(first, factor); scale(second, factor);
+ * }
+ */
+template<class Iterator>
+inline Grid<Iterator> subgrid(const Grid<Iterator>& grid, std::size_t top, std::size_t left, std::size_t height, std::size_t width) {
+    return grid.block(top, left, height, width);
+}
+
+
+template<class SequenceContainer>
+inline auto row(SequenceContainer&& container, std::size_t row_number, std::size_t rows, std::size_t cols) {
+    static_assert(std::is_lvalue_reference_v<SequenceContainer>, "row() views a container without owning it, a temporary would be destroyed under the view");
+    return grid(container, rows, cols).row(row_number);
+}
+
+
+template<class SequenceContainer>
+inline auto col(SequenceContainer&& container, std::size_t column_number, std::size_t rows, std::size_t cols) {
+    static_assert(std::is_lvalue_reference_v<SequenceContainer>, "col() views a container without owning it, a temporary would be destroyed under the view");
+    return grid(container, rows, cols).col(column_number);
+}
+
+
+#endif
+#ifndef __VIPER_GRID_STORAGE__
+#define __VIPER_GRID_STORAGE__
+
+
+
+
+/*
+ * A grid that owns its elements, laid out for SIMD kernels:
+ * the buffer is 64-byte aligned (a cache line, an AVX-512 register) and each row is padded up to a multiple of 64 bytes
+ * (when the size of T divides 64), so every row starts aligned, whatever the width. A 1001 floats wide grid has rows of 1008 floats.
+ * Rows that would end up a multiple of 1KiB apart get one more cache line: the elements of a column
+ * would otherwise all fall in a few sets of the L1 cache, and rows exactly 4KiB apart make the CPU mistake
+ * loads from a row for stores to another (4K aliasing).
+ *
+ * For example:
+ * GridStorage<float> image(height, width);
+ * image(r, c) = 1.f;
+ * for( auto& pixel : image.row(r) ) { ... }     // the same views as grid()'s, over the first width() elements of each row
+ * transpose(image.view(), other.view());         // the Grid of all the elements, for everything that takes one
+ *
+ * padded_row(r) is the whole row, padding included (stride() elements, initialized like the others),
+ * for kernels that would rather run over a multiple of their register width than handle a tail.
+ */
+template<class T>
+class GridStorage {
+
+    public:
+
+        static constexpr std::size_t alignment = 64;
+
+        using value_type = T;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using reference = T&;
+        using const_reference = const T&;
+        using pointer = T*;
+        using const_pointer = const T*;
+        using view_type = Grid<T*>;
+        using const_view_type = Grid<const T*>;
+
+    private:
+
+        // frees the memory only, before the elements are constructed
+        struct Release {
+            inline void operator()(T* p) const noexcept { ::operator delete(p, std::align_val_t(alignment)); }
+        };
+
+        // destroys the elements, then frees the memory
+        struct Destroy {
+            std::size_t count;
+
+            inline void operator()(T* p) const noexcept {
+                std::destroy_n(p, count);
+                Release()(p);
+            }
+        };
+
+        std::unique_ptr<T, Destroy> _data;
+        size_type _height, _width, _stride;
+
+        static inline std::unique_ptr<T, Release> allocate(size_type count) {
+            return std::unique_ptr<T, Release>(static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(alignment))));
+        }
+
+        static inline std::unique_ptr<T, Destroy> filled(size_type count, const T& value) {
+            auto memory = allocate(count);
+            std::uninitialized_fill_n(memory.get(), count, value);
+            return std::unique_ptr<T, Destroy>(memory.release(), Destroy{count});
+        }
+
+        static inline std::unique_ptr<T, Destroy> copied(size_type count, const T* elements) {
+            if( elements == nullptr ) return std::unique_ptr<T, Destroy>(nullptr, Destroy{0});   // a moved-from storage
+            auto memory = allocate(count);
+            std::uninitialized_copy_n(elements, count, memory.get());
+            return std::unique_ptr<T, Destroy>(memory.release(), Destroy{count});
+        }
+
+    public:
+
+        // elements from one row to the next for rows of 'width' elements, see above
+        static constexpr size_type padded_stride(size_type width) noexcept {
+            constexpr size_type line = alignment % sizeof(T) == 0 ? alignment / sizeof(T) : 1;
+            size_type stride = (width + line - 1) / line * line;
+            if( stride > 0 && stride * sizeof(T) % 1024 == 0 ) stride += line;
+            return stride;
+        }
+
+        GridStorage(size_type height, size_type width, const T& value = T())
+            : _data(filled(height * padded_stride(width), value)), _height(height), _width(width), _stride(padded_stride(width)) {}
+
+        GridStorage(const GridStorage& other)
+            : _data(copied(other._height * other._stride, other.data())), _height(other._height), _width(other._width), _stride(other._stride) {}
+
+        // the moved-from storage is left empty, 0 x 0 without elements
+        GridStorage(GridStorage&& other) noexcept
+            : _data(std::move(other._data)), _height(std::exchange(other._height, 0)), _width(std::exchange(other._width, 0)),
+              _stride(std::exchange(other._stride, 0)) {}
+
+        GridStorage& operator=(const GridStorage& other) {
+            if( this != &other ) *this = GridStorage(other);
+            return *this;
+        }
+
+        GridStorage& operator=(GridStorage&& other) noexcept {
+            if( this != &other ) {
+                _data = std::move(other._data);
+                _height = std::exchange(other._height, 0);
+                _width = std::exchange(other._width, 0);
+                _stride = std::exchange(other._stride, 0);
+            }
+            return *this;
+        }
+
+        inline void swap(GridStorage& other) noexcept {
+            std::swap(_data, other._data);
+            std::swap(_height, other._height);
+            std::swap(_width, other._width);
+            std::swap(_stride, other._stride);
+        }
+
+        inline size_type height() const noexcept { return _height; }
+
+        inline size_type width() const noexcept { return _width; }
+
+        // elements from the start of one row to the start of the next, padded_stride(width())
+        inline size_type stride() const noexcept { return _stride; }
+
+        inline size_type size() const noexcept { return _height * _width; }
+
+        // the first element of the first row, 64-byte aligned
+        inline T* data() noexcept { return _data.get(); }
+
+        inline const T* data() const noexcept { return _data.get(); }
+
+        inline reference operator()(size_type r, size_type c) { return data()[r * _stride + c]; }
+
+        inline const_reference operator()(size_type r, size_type c) const { return data()[r * _stride + c]; }
+
+        inline view_type view() noexcept { return view_type(data(), _height, _width, _stride); }
+
+        inline const_view_type view() const noexcept { return const_view_type(data(), _height, _width, _stride); }
+
+        //
+        // THE VIEWS OF A GRID
+        //
+
+        inline auto row(size_type r) { return view().row(r); }
+
+        inline auto row(size_type r) const { return view().row(r); }
+
+        inline auto padded_row(size_type r) { return RowView<T*>(data() + r * _stride, _stride); }
+
+        inline auto padded_row(size_type r) const { return RowView<const T*>(data() + r * _stride, _stride); }
+
+        inline auto col(size_type c) { return view().col(c); }
+
+        inline auto col(size_type c) const { return view().col(c); }
+
+        inline auto rows() { return view().rows(); }
+
+        inline auto rows() const { return view().rows(); }
+
+        inline auto cols() { return view().cols(); }
+
+        inline auto cols() const { return view().cols(); }
+
+        inline auto block(size_type r, size_type c, size_type height, size_type width) { return view().block(r, c, height, width); }
+
+        inline auto block(size_type r, size_type c, size_type height, size_type width) const { return view().block(r, c, height, width); }
+
+        inline auto tiles() { return view().tiles(); }
+
+        inline auto tiles() const { return view().tiles(); }
+};
+
+#endif
+#ifndef __VIPER_IN__
+#define __VIPER_IN__
+
+
+
+
+/*
+ * True when Container stores its values in one contiguous block of arithmetic values
+ * (std::vector<int>, std::array<uint16_t, N>, std::string...), which the SIMD kernels can scan directly.
+ */
+template<class Container, class = void>
+struct is_contiguous_arithmetic : std::false_type {};
+
+template<class Container>
+struct is_contiguous_arithmetic<Container, std::void_t<decltype(std::data(std::declval<const Container&>()))>>
+    : std::bool_constant<
+        simd::is_vectorizable_v<typename Container::value_type>
+        && std::is_same_v<decltype(std::data(std::declval<const Container&>())), const typename Container::value_type*>
+      > {};
+
+template<class Container>
+constexpr bool is_contiguous_arithmetic_v = is_contiguous_arithmetic<Container>::value;
+
+
+// std::set, std::unordered_set... and anything else offering a member contains() (C++20)
+template<class Container, class T, class = void>
+struct has_member_contains : std::false_type {};
+
+template<class Container, class T>
+struct has_member_contains<Container, T, std::void_t<
+    decltype(std::declval<const Container&>().contains(std::declval<const T&>()))
+    >> : std::true_type {};
+
+
+// associative containers, but not std::string whose find() returns a position
+template<class Container, class T, class = void>
+struct has_member_find : std::false_type {};
+
+template<class Container, class T>
+struct has_member_find<Container, T, std::void_t<
+    decltype(std::declval<const Container&>().find(std::declval<const T&>()) != std::declval<const Container&>().end())
+    >> : std::true_type {};
+
+
+// std::map, std::unordered_map... where we look up a key rather than a (key, value) pair
+template<class Container, class = void>
+struct is_map_like : std::false_type {};
+
+template<class Container>
+struct is_map_like<Container, std::void_t<typename Container::key_type, typename Container::mapped_type>> : std::true_type {};
+
+template<class Container>
+constexpr bool is_map_like_v = is_map_like<Container>::value;
+
+
+/*
+ * Wraps a container the caller promises is already sorted according to Compare,
+ * so 'in' can binary search it instead of scanning it.
+ * The element the search lands on is compared with ==, like an unsorted scan would:
+ * NaN is neither less nor greater than anything, yet equals nothing.
+ * Unlike Python's 'sorted' it doesn't sort anything, nor copy the container.
+ *
+ * For example:
+ * std::vector<int> whitelist = {2, 3, 5, 7, 11};
+ *
+ * if( in(sorted(whitelist), 7) ) { ... }
+ */
+template<class Container, class Compare = std::less<>>
+class Sorted {
+
+    const Container& data;
+    Compare compare;
+
+    public:
+
+        using container_t = std::remove_reference_t<Container>;
+        using value_type = typename container_t::value_type;
+        using size_type = typename container_t::size_type;
+        using reference = typename container_t::reference;
+        using const_reference = typename container_t::const_reference;
+        using const_iterator = typename container_t::const_iterator;
+        using iterator = const_iterator;
+
+        constexpr Sorted(const Container& container, Compare compare = Compare()) noexcept
+            : data(container), compare(compare) {}
+
+        inline auto begin() const { return data.cbegin(); }
+
+        inline auto end() const { return data.cend(); }
+
+        inline auto cbegin() const { return data.cbegin(); }
+
+        inline auto cend() const { return data.cend(); }
+
+        inline auto size() const { return data.size(); }
+
+        template<class T>
+        bool contains(const T& value) const {
+            using category = typename std::iterator_traits<const_iterator>::iterator_category;
+            if constexpr( std::is_base_of_v<std::random_access_iterator_tag, category> ) {
+                // branchless lower bound: the loop only depends on the size, the compiler turns the ternary into a cmov
+                auto base = data.cbegin();
+                auto n = std::distance(data.cbegin(), data.cend());
+                if( n == 0 ) return false;
+                while( n > 1 ) {
+                    const auto half = n / 2;
+                    base = compare(base[half], value) ? base + half : base;
+                    n -= half;
+                }
+                base += compare(*base, value);
+                return base != data.cend() && *base == value;
+            } else {
+                const auto found = std::lower_bound(data.cbegin(), data.cend(), value, compare);
+                return found != data.cend() && *found == value;
+            }
+        }
+};
+
+
+template<class Container, class Compare = std::less<>>
+constexpr auto sorted(const Container& container, Compare compare = Compare()) noexcept {
+    return Sorted<Container, Compare>(container, compare);
+}
+
+
+/*
+ * True when 'value' converted to T is still 'value': it converts to T and back unchanged, or it is an integer
+ * and T a floating point type, which == would convert it to anyway.
+ * 300 isn't a uint8_t, nor 2.5 an int: converted they would find 44 or 2 where == finds neither,
+ * so neither the SIMD kernels, which compare values of a single type, nor std::set<T>::find can be given them.
+ */
+template<class T, class Needle>
+constexpr bool converts_exactly(const Needle& value) {
+    if constexpr( std::is_same_v<T, Needle> ) {
+        return true;
+    } else if constexpr( std::is_integral_v<Needle> ) {
+        // == converts an integer to the floating point type, and between integers it matches the round trip
+        if constexpr( std::is_floating_point_v<T> ) return true;
+        else return static_cast<Needle>(static_cast<T>(value)) == value;
+    } else if constexpr( std::is_floating_point_v<T> ) {
+        if constexpr( std::numeric_limits<Needle>::digits <= std::numeric_limits<T>::digits
+                   && std::numeric_limits<Needle>::max_exponent <= std::numeric_limits<T>::max_exponent ) {
+            return true;
+        } else {
+            // converting a value out of T's range is undefined, check it first
+            return value >= -static_cast<Needle>(std::numeric_limits<T>::max()) && value <= static_cast<Needle>(std::numeric_limits<T>::max())
+                && static_cast<Needle>(static_cast<T>(value)) == value;
+        }
+    } else {
+        // a floating point needle and integers: T's range is [lowest, 2^digits), both ends exact in floating point
+        constexpr Needle upper = static_cast<Needle>(std::numeric_limits<T>::max() / 2 + 1) * 2;
+        return value >= static_cast<Needle>(std::numeric_limits<T>::lowest()) && value < upper
+            && static_cast<Needle>(static_cast<T>(value)) == value;
+    }
+}
+
+
+// integers wider than a floating point needle's mantissa round when == compares them with it: 2^53 + 1 == 2^53.
+// A SIMD scan for the converted needle would miss the rounded ones.
+template<class T, class Needle>
+constexpr bool rounds_when_compared_v = std::is_integral_v<T> && std::is_floating_point_v<Needle>
+                                     && (std::numeric_limits<T>::digits > std::numeric_limits<Needle>::digits);
+
+
+template<class Container, class = void>
+struct has_key_type : std::false_type {};
+
+template<class Container>
+struct has_key_type<Container, std::void_t<typename Container::key_type>> : std::true_type {};
+
+
+// false when the container's own lookup, converting the needle to its key type, would look for another number
+template<class Container, class T>
+inline bool is_possible_key(const T& value) {
+    if constexpr( has_key_type<Container>::value ) {
+        using key_t = typename Container::key_type;
+        if constexpr( std::is_arithmetic_v<key_t> && std::is_arithmetic_v<T> ) return converts_exactly<key_t>(value);
+    }
+    return true;
+}
+
+
+/*
+ * Picks the fastest way to look 'value' up, from the container's own traits:
+ * member contains() or find() for associative containers and Sorted,
+ * SIMD scan for contiguous arithmetic values, linear scan otherwise.
+ */
+template<class Container, class T>
+inline bool find_in(const Container& c, const T& value) {
+    if constexpr( has_member_contains<Container, T>::value ) {
+        return is_possible_key<Container>(value) && c.contains(value);
+    } else if constexpr( has_member_find<Container, T>::value ) {
+        return is_possible_key<Container>(value) && c.find(value) != c.end();
+    } else if constexpr( is_contiguous_arithmetic_v<Container> ) {
+        using value_t = typename Container::value_type;
+        const auto first = std::data(c);
+        const auto last = first + std::size(c);
+        if constexpr( std::is_arithmetic_v<T> && !rounds_when_compared_v<value_t, T> ) {
+            if( converts_exactly<value_t>(value) ) return simd::find(first, last, static_cast<value_t>(value)) != last;
+        }
+        return std::find(first, last, value) != last;
+    } else {
+        return std::find(c.cbegin(), c.cend(), value) != c.cend();
+    }
+}
+
+
+// the type of a braced needle, in(container, {...}): like Python, 'in' on a map looks up a key
+template<class Container, class = void>
+struct needle_type {
+    using type = typename Container::value_type;
+};
+
+template<class Container>
+struct needle_type<Container, std::enable_if_t<is_map_like_v<Container>>> {
+    using type = typename Container::key_type;
+};
+
+
+// the needle is compared as it is, not converted to the container's values first: in(bytes, 300) is false
+template<class Container, class T = typename needle_type<std::remove_reference_t<Container>>::type>
+constexpr bool in(const Container& c, const T& value) {
+    return find_in(c, value);
+}
+
+
+/*
+ * Batch membership: check many needles against the same haystack.
+ *
+ * Past 'in_batch_threshold' needles, a haystack without a fast lookup of its own is indexed once
+ * (sorted copy for numbers, hash set for other hashable values) so the whole batch costs
+ * roughly O(N+M) instead of O(N*M). Needles are compared with == like in() does, whatever their number:
+ * a hash set of floats would convert a double needle to float before looking it up, a sorted copy compares it as it is.
+ *
+ * For example:
+ * std::vector<int> whitelist = {80, 443, 8080};
+ * std::vector<int> ports = {22, 80, 443};
+ *
+ * in_mask(whitelist, ports); // std::vector<bool>{false, true, true}
+ * in_any(whitelist, ports);  // true
+ * in_all(whitelist, ports);  // false
+ */
+constexpr std::size_t in_batch_threshold = 16;
+
+
+template<class T, class = void>
+struct is_hashable : std::false_type {};
+
+template<class T>
+struct is_hashable<T, std::void_t<decltype(std::hash<T>()(std::declval<const T&>()))>>
+    : std::is_default_constructible<std::hash<T>> {};
+
+
+template<class T, class = void>
+struct is_less_comparable : std::false_type {};
+
+template<class T>
+struct is_less_comparable<T, std::void_t<decltype(std::declval<const T&>() < std::declval<const T&>())>> : std::true_type {};
+
+
+// number of needles, or the threshold when a single pass range can't tell us
+template<class Needles>
+inline std::size_t batch_size(const Needles& needles) {
+    using category = typename std::iterator_traits<decltype(std::begin(needles))>::iterator_category;
+    if constexpr( std::is_base_of_v<std::forward_iterator_tag, category> ) {
+        return static_cast<std::size_t>(std::distance(std::begin(needles), std::end(needles)));
+    } else {
+        return in_batch_threshold;
+    }
+}
+
+
+// calls visit(found) for each needle in order, until visit returns false
+template<class Container, class Needles, class Visitor>
+void visit_membership(const Container& c, const Needles& needles, Visitor&& visit) {
+    using value_t = typename Container::value_type;
+    using needle_t = std::decay_t<decltype(*std::begin(needles))>;
+
+    auto lookup_each = [&needles, &visit](const auto& haystack) {
+        for( const auto& needle : needles ) {
+            if( !visit(find_in(haystack, needle)) ) return;
+        }
+    };
+
+    if constexpr( has_member_contains<Container, needle_t>::value || has_member_find<Container, needle_t>::value ) {
+        lookup_each(c);
+    } else if( batch_size(needles) < in_batch_threshold ) {
+        lookup_each(c);
+    } else if constexpr( std::is_arithmetic_v<value_t> || (!is_hashable<value_t>::value && is_less_comparable<value_t>::value) ) {
+        std::vector<value_t> index(c.cbegin(), c.cend());
+        if constexpr( std::is_floating_point_v<value_t> ) {
+            // NaNs don't sort, and equal nothing anyway
+            index.erase(std::remove_if(index.begin(), index.end(), [](value_t x) { return x != x; }), index.end());
+        }
+        std::sort(index.begin(), index.end());
+        lookup_each(sorted(index));
+    } else if constexpr( is_hashable<value_t>::value ) {
+        const std::unordered_set<value_t> index(c.cbegin(), c.cend());
+        lookup_each(index);
+    } else {
+        lookup_each(c);
+    }
+}
+
+
+// one bool per needle, true when the needle is in the container
+template<class Container, class Needles>
+std::vector<bool> in_mask(const Container& c, const Needles& needles) {
+    std::vector<bool> mask;
+    mask.reserve(batch_size(needles));
+    visit_membership(c, needles, [&mask](bool found) { mask.push_back(found); return true; });
+    return mask;
+}
+
+
+// true when at least one needle is in the container
+template<class Container, class Needles>
+bool in_any(const Container& c, const Needles& needles) {
+    bool any = false;
+    visit_membership(c, needles, [&any](bool found) { any = found; return !found; });
+    return any;
+}
+
+
+// true when every needle is in the container, also true for no needles
+template<class Container, class Needles>
+bool in_all(const Container& c, const Needles& needles) {
+    bool all = true;
+    visit_membership(c, needles, [&all](bool found) { all = found; return found; });
+    return all;
+}
+
+#endif
+#ifndef __VIPER_ITERATOR_CAST__
+#define __VIPER_ITERATOR_CAST__
+
+
+
+
+/*
+ * Iterator adaptor dereferencing to convert(*iter), in the spirit of Python's 'map'.
+ * The conversion is stored by value (see FunctionBox) and called directly, so it can be inlined.
+ *
+ * For example:
+ * auto to_char = [](const int& i) { return (char)(i+48); };
+ * std::string str(iterator_cast(vi.cbegin(), to_char), iterator_cast(vi.cend(), to_char));
+ */
+template<class Iterator, class UnaryFunction>
+
+class Iter : private FunctionBox<UnaryFunction> {
+
+    using box_t = FunctionBox<UnaryFunction>;
+    using traits_t = std::iterator_traits<Iterator>;
+
+    Iterator _iter;
+
+    public:
+
+        using iterator_type = Iterator;
+        using difference_type = typename traits_t::difference_type;
+        using reference = std::invoke_result_t<const UnaryFunction&, typename traits_t::reference>;
+        using value_type = std::remove_cv_t<std::remove_reference_t<reference>>;
+        using pointer = void;
+        using iterator_category = typename traits_t::iterator_category;
+
+        Iter(Iterator iter, UnaryFunction convert)
+            : box_t(std::move(convert)), _iter(std::move(iter)) {}
+
+        inline const Iterator& base() const noexcept { return _iter; }
+
+        inline reference operator*() const {
+            return box_t::function()(*_iter);
+        }
+
+        inline reference operator[](difference_type n) const {
+            return box_t::function()(_iter[n]);
+        }
+
+        inline bool operator==(const Iter& rhs) const {
+            return _iter == rhs._iter;
+        }
+
+        inline bool operator!=(const Iter& rhs) const {
+            return _iter != rhs._iter;
+        }
+
+        inline bool operator<(const Iter& rhs) const {
+            return _iter < rhs._iter;
+        }
+
+        inline bool operator>(const Iter& rhs) const {
+            return _iter > rhs._iter;
+        }
+
+        inline bool operator<=(const Iter& rhs) const {
+            return _iter <= rhs._iter;
+        }
+
+        inline bool operator>=(const Iter& rhs) const {
+            return _iter >= rhs._iter;
+        }
+
+        inline difference_type operator-(const Iter& rhs) const {
+            return _iter - rhs._iter;
+        }
+
+        inline Iter& operator++() {
+            ++_iter;
+            return *this;
+        }
+
+        inline auto operator++(int) {
+            auto iterator{*this};
+            operator++();
+            return iterator;
+        }
+
+        inline Iter& operator--() {
+            --_iter;
+            return *this;
+        }
+
+        inline auto operator--(int) {
+            auto iterator{*this};
+            operator--();
+            return iterator;
+        }
+
+        inline Iter& operator+=(difference_type n) {
+            _iter += n;
+            return *this;
+        }
+
+        inline Iter& operator-=(difference_type n) {
+            _iter -= n;
+            return *this;
+        }
+
+        inline Iter operator+(difference_type n) const {
+            auto iterator{*this};
+            return iterator += n;
+        }
+
+        inline Iter operator-(difference_type n) const {
+            auto iterator{*this};
+            return iterator -= n;
+        }
+};
+
+
+template<class Iterator, class UnaryFunction>
+inline auto iterator_cast(Iterator&& iter, UnaryFunction&& convert) {
+    return Iter<std::decay_t<Iterator>, std::decay_t<UnaryFunction>>(std::forward<Iterator>(iter), std::forward<UnaryFunction>(convert));
+}
+
+
+template<class T, class Container>
+T into(const Container& c) {
+    return T(c.begin(), c.end());
+}
+
+
+template<class T, class UnaryFunction, class Container>
+T into(const UnaryFunction& fn, Container&& c) {
+    return T(iterator_cast(c.cbegin(), fn), iterator_cast(c.cend(), fn));
+}
+
+
+/*
+ * Parallel transform of a random access container into a random access container of the same size,
+ * allocated once (default constructed, then resized) then filled chunk by chunk in parallel.
+ * Outputs without resize(), and std::vector<bool> (see is_bit_packed), are filled sequentially.
+ *
+ * For example:
+ * auto names = into<std::vector<std::string>>(par, name_of, records);
+ */
+template<class T, class UnaryFunction, class Container>
+T into(const parallel_policy& policy, const UnaryFunction& fn, const Container& c) {
+    using category = typename std::iterator_traits<typename std::remove_reference_t<Container>::const_iterator>::iterator_category;
+    using out_category = typename std::iterator_traits<typename T::iterator>::iterator_category;
+    static_assert(std::is_base_of_v<std::random_access_iterator_tag, category>, "parallel into needs a random access container");
+    static_assert(std::is_base_of_v<std::random_access_iterator_tag, out_category>, "parallel into needs a random access output");
+
+    if constexpr( is_bit_packed<T>::value || !has_resize<T>::value ) {
+        return into<T>(fn, c);
+    } else {
+        const std::size_t size = std::size(c);
+        const auto first = c.cbegin();
+        T out;
+        out.resize(size);
+        auto out_first = out.begin();
+        parallel_chunks(chunk_count(policy, size), size, [&](std::size_t, std::size_t begin, std::size_t end) {
+            for( std::size_t i = begin; i < end; ++i ) out_first[i] = fn(first[i]);
+        });
+        return out;
+    }
+}
+
+#endif
+#ifndef __VIPER_PIPELINE__
+#define __VIPER_PIPELINE__
+
+
+
+
+/*
+ * Lazy pipelines: chain stages with operator| and nothing is computed until the pipeline is iterated,
+ * every stage just wraps the iterators of the previous one, so the whole chain runs in a single pass.
+ *
+ * For example:
+ * auto even = [](int i) { return i % 2 == 0; };
+ * auto square = [](int i) { return i * i; };
+ *
+ * for( auto&& [index, value] : vi | filter(even) | transform(square) | enumerate() | take(3) ) { ... }
+ *
+ * auto squares = vi | filter(even) | transform(square) | into<std::vector<int>>();   // only materialized here
+ *
+ * A pipeline references an l-value source and takes ownership of an r-value one (moved in),
+ * so pipelines over temporaries don't dangle.
+ */
+
+
+// iterator type of a source, be it a container or a previous stage
+template<class Range>
+using range_iterator_t = decltype(std::begin(std::declval<std::remove_reference_t<Range>&>()));
+
+
+/*
+ * Common part of the stages: the source (a reference or an owned value, see above)
+ * and the typedefs Enumerate's iterator needs from what it walks over.
+ */
+template<class Range, class StageIterator>
+class View {
+
+    protected:
+
+        Range range;
+
+        inline auto source_begin() { return std::begin(range); }
+
+        inline auto source_end() { return std::end(range); }
+
+    public:
+
+        using iterator = StageIterator;
+        using reference = typename std::iterator_traits<StageIterator>::reference;
+        using value_type = typename std::iterator_traits<StageIterator>::value_type;
+        using difference_type = typename std::iterator_traits<StageIterator>::difference_type;
+        using size_type = std::size_t;
+
+        explicit View(Range&& source) : range(std::forward<Range>(source)) {}
+};
+
+
+template<class Range, class Predicate>
+class FilterView : public View<Range, FilterIterator<range_iterator_t<Range>, Predicate>> {
+
+    using base_t = View<Range, FilterIterator<range_iterator_t<Range>, Predicate>>;
+
+    Predicate predicate;
+
+    public:
+
+        using iterator = typename base_t::iterator;
+
+        FilterView(Range&& source, Predicate predicate)
+            : base_t(std::forward<Range>(source)), predicate(std::move(predicate)) {}
+
+        inline iterator begin() { return iterator(this->source_begin(), this->source_end(), predicate); }
+
+        inline iterator end() { return iterator(this->source_end(), this->source_end(), predicate); }
+};
+
+
+template<class Range, class UnaryFunction>
+class TransformView : public View<Range, Iter<range_iterator_t<Range>, UnaryFunction>> {
+
+    using base_t = View<Range, Iter<range_iterator_t<Range>, UnaryFunction>>;
+
+    UnaryFunction convert;
+
+    public:
+
+        using iterator = typename base_t::iterator;
+
+        TransformView(Range&& source, UnaryFunction convert)
+            : base_t(std::forward<Range>(source)), convert(std::move(convert)) {}
+
+        inline iterator begin() { return iterator(this->source_begin(), convert); }
+
+        inline iterator end() { return iterator(this->source_end(), convert); }
+};
+
+
+template<class Range>
+class EnumerateView : public View<Range, typename Enumerate<Range>::template Iterator<range_iterator_t<Range>>> {
+
+    using base_t = View<Range, typename Enumerate<Range>::template Iterator<range_iterator_t<Range>>>;
+
+    public:
+
+        using iterator = typename base_t::iterator;
+
+        explicit EnumerateView(Range&& source) : base_t(std::forward<Range>(source)) {}
+
+        inline iterator begin() { return iterator(0, this->source_begin()); }
+
+        // only the underlying iterators are compared, the index of the end doesn't matter
+        inline iterator end() { return iterator(0, this->source_end()); }
+};
+
+
+/*
+ * Stops after 'count' elements or at the end of the underlying range, whichever comes first.
+ * It doesn't move the underlying iterator past the last element taken,
+ * so a filter upstream won't scan the rest of its input for nothing.
+ */
+template<class Iterator>
+class TakeIterator {
+
+    using traits_t = std::iterator_traits<Iterator>;
+
+    Iterator _iter;
+    std::size_t _count;
+
+    public:
+
+        using difference_type = typename traits_t::difference_type;
+        using value_type = typename traits_t::value_type;
+        using pointer = typename traits_t::pointer;
+        using reference = typename traits_t::reference;
+        using iterator_category = std::conditional_t<
+            std::is_base_of_v<std::forward_iterator_tag, typename traits_t::iterator_category>,
+            std::forward_iterator_tag,
+            typename traits_t::iterator_category
+                >;
+
+        TakeIterator(Iterator iter, std::size_t count) : _iter(std::move(iter)), _count(count) {}
+
+        inline reference operator*() const {
+            return *_iter;
+        }
+
+        inline bool operator==(const TakeIterator& rhs) const {
+            return _count == rhs._count || _iter == rhs._iter;
+        }
+
+        inline bool operator!=(const TakeIterator& rhs) const {
+            return !(*this == rhs);
+        }
+
+        inline TakeIterator& operator++() {
+            if( --_count ) ++_iter;
+            return *this;
+        }
+
+        inline auto operator++(int) {
+            auto iterator{*this};
+            operator++();
+            return iterator;
+        }
+};
+
+
+template<class Range>
+class TakeView : public View<Range, TakeIterator<range_iterator_t<Range>>> {
+
+    using base_t = View<Range, TakeIterator<range_iterator_t<Range>>>;
+
+    std::size_t count;
+
+    public:
+
+        using iterator = typename base_t::iterator;
+
+        TakeView(Range&& source, std::size_t count) : base_t(std::forward<Range>(source)), count(count) {}
+
+        inline iterator begin() { return iterator(this->source_begin(), count); }
+
+        inline iterator end() { return iterator(this->source_end(), 0); }
+};
+
+
+//
+// STAGES: what the right hand side of operator| is made of
+//
+
+template<class Predicate>
+struct FilterStage { Predicate predicate; };
+
+template<class UnaryFunction>
+struct TransformStage { UnaryFunction convert; };
+
+struct EnumerateStage {};
+
+struct TakeStage { std::size_t count; };
+
+template<class Container>
+struct IntoStage {};
+
+
+template<class Predicate>
+inline auto filter(Predicate&& fn) {
+    return FilterStage<std::decay_t<Predicate>>{std::forward<Predicate>(fn)};
+}
+
+template<class UnaryFunction>
+inline auto transform(UnaryFunction&& convert) {
+    return TransformStage<std::decay_t<UnaryFunction>>{std::forward<UnaryFunction>(convert)};
+}
+
+inline auto enumerate() {
+    return EnumerateStage{};
+}
+
+inline auto take(std::size_t count) {
+    return TakeStage{count};
+}
+
+// the only stage that allocates: walks the whole pipeline into a Container
+template<class Container>
+inline auto into() {
+    return IntoStage<Container>{};
+}
+
+
+template<class Range, class Predicate>
+inline auto operator|(Range&& range, FilterStage<Predicate> stage) {
+    return FilterView<Range, Predicate>(std::forward<Range>(range), std::move(stage.predicate));
+}
+
+template<class Range, class UnaryFunction>
+inline auto operator|(Range&& range, TransformStage<UnaryFunction> stage) {
+    return TransformView<Range, UnaryFunction>(std::forward<Range>(range), std::move(stage.convert));
+}
+
+template<class Range>
+inline auto operator|(Range&& range, EnumerateStage) {
+    return EnumerateView<Range>(std::forward<Range>(range));
+}
+
+template<class Range>
+inline auto operator|(Range&& range, TakeStage stage) {
+    return TakeView<Range>(std::forward<Range>(range), stage.count);
+}
+
+template<class Range, class Container>
+inline Container operator|(Range&& range, IntoStage<Container>) {
+    Container out;
+    for( auto&& value : range ) {
+        out.insert(out.end(), std::forward<decltype(value)>(value));
+    }
+    return out;
+}
+
+#endif
+#ifndef __VIPER_RANGE__
+#define __VIPER_RANGE__
+
+
+
+template <class T>
+
+class RangeIterator {
+
+    T _value;
+
+    public:
+        constexpr RangeIterator(const T value):_value(value) {}
+
+        using difference_type = typename std::iterator_traits<T*>::difference_type;
+        using value_type = typename std::iterator_traits<T*>::value_type;
+        using pointer = typename std::iterator_traits<T*>::pointer;
+        using reference = typename std::iterator_traits<T*>::reference;
+        using iterator_category = typename std::iterator_traits<T*>::iterator_category;
+
+        constexpr inline bool operator==(const RangeIterator& rhs) const {
+            return _value == rhs._value;
+        }
+
+        constexpr inline bool operator!=(const RangeIterator& rhs) const {
+            return _value != rhs._value;
+        }
+
+        constexpr inline difference_type operator-(const RangeIterator& rhs) const {
+            return _value - rhs._value;
+        }
+
+        constexpr inline T operator*() const {
+            return _value;
+        }
+
+        constexpr inline RangeIterator& operator++() {
+            ++_value;
+            return *this;
+        }
+
+        constexpr inline auto operator++(int) {
+            auto iterator{*this};
+            operator++();
+            return iterator;
+        }
+        
+};
+
+
+template <class T>
+
+class Range {
+
+    RangeIterator<T> _start, _stop;
+
+    public:
+        constexpr Range(const T start, const T stop):_start(start), _stop(stop) {}
+
+        constexpr inline RangeIterator<T> begin() const { return _start; }
+
+        constexpr inline RangeIterator<T> end() const { return _stop; }
+
+};
+
+
+template<class T>
+constexpr Range<T> range(const T& start, const T& stop) {
+    return Range<T>(start, stop);
+}
+
+#endif 
+#ifndef __VIPER_REDUCE__
+#define __VIPER_REDUCE__
+
+
+
+
+/*
+ * sum, min and max of a row or a column of a grid, and dot products of two of them,
+ * with the compile-time views of row<>() and col<>() as well as the runtime ones:
+ *
+ * std::array<float, rows*cols> samples = ...;
+ * auto peak = max(row<2, rows, cols>(samples));
+ * auto energy = dot(image.row(r), image.row(r));
+ *
+ * Rows of contiguous containers of float, double or std::int32_t are reduced with SIMD registers,
+ * and so are the columns of column-major ones (see LAYOUTS in grid.h). Otherwise reducing a single column
+ * can't use them, its elements are a row apart: to reduce all the columns of a grid, reduce its cols() range,
+ * whose adjacent columns are reduced a register at a time down the rows.
+ * Same with its rows(), each into a std::vector:
+ *
+ * std::vector<float> column_sums = sum(image.cols());
+ * std::vector<float> row_maxima = max(image.rows());
+ *
+ * Sums are of the view's value_type, like std::accumulate(first, last, T()) would be;
+ * floating point values are added in a different order than a sequential loop so their rounding can differ slightly.
+ * min and max need at least one element, they give T() otherwise. They are NaN when an element is.
+ * They only take these views (is_line_view) and their rows() and cols(), other calls to min(x) or max(x)
+ * in code that includes Viper don't see them.
+ */
+
+
+// the rows and columns of grid.h, compile-time or runtime, which sum, min, max and dot take
+template<class View>
+struct is_line_view : std::false_type {};
+
+template<class Iterator>
+struct is_line_view<RowView<Iterator>> : std::true_type {};
+
+template<class Iterator>
+struct is_line_view<ColumnView<Iterator>> : std::true_type {};
+
+template<std::size_t row_number, std::size_t rows, std::size_t cols, class SequenceContainer, class Layout>
+struct is_line_view<RowDimension<row_number, rows, cols, SequenceContainer, Layout>> : std::true_type {};
+
+template<std::size_t column_number, std::size_t rows, std::size_t cols, class SequenceContainer, class Layout>
+struct is_line_view<ColumnDimension<column_number, rows, cols, SequenceContainer, Layout>> : std::true_type {};
 
-    //
-    // READ OPS
-    //
+template<class View>
+constexpr bool is_line_view_v = is_line_view<View>::value;
 
-    constexpr size_type size() const noexcept {
-        return rows;
-    }
 
-    constexpr const_reference operator[]( size_type pos ) const {
-        return data[ column_number + pos*cols ];
+// views whose elements are contiguous in memory, one after the other
+template<class View>
+struct is_contiguous_view : std::false_type {};
+
+template<class T>
+struct is_contiguous_view<RowView<T*>> : std::true_type {};
+
+template<std::size_t row_number, std::size_t rows, std::size_t cols, class SequenceContainer, class Layout>
+struct is_contiguous_view<RowDimension<row_number, rows, cols, SequenceContainer, Layout>>
+    : std::bool_constant<Layout::contiguous_rows && has_data<std::remove_reference_t<SequenceContainer>>::value> {};
+
+template<std::size_t column_number, std::size_t rows, std::size_t cols, class SequenceContainer, class Layout>
+struct is_contiguous_view<ColumnDimension<column_number, rows, cols, SequenceContainer, Layout>>
+    : std::bool_constant<Layout::contiguous_cols && has_data<std::remove_reference_t<SequenceContainer>>::value> {};
+
+
+template<simd::reduction op, class View>
+inline auto reduce_view(const View& view) {
+    using value_type = std::remove_const_t<typename View::value_type>;
+    const std::size_t size = view.size();
+    if( size == 0 ) return value_type();
+    if constexpr( is_contiguous_view<View>::value ) {
+        return simd::reduce<op>(static_cast<const value_type*>(std::addressof(view[0])), size);
+    } else {
+        value_type result = view[0];
+        for( std::size_t i = 1; i < size; ++i ) result = simd::combine<op>(result, static_cast<value_type>(view[i]));
+        return result;
     }
+}
 
-    //
-    // WRITE OPS
-    //
 
-    constexpr reference operator[]( size_type pos ) {
-        return data[ column_number + pos*cols ];
+template<simd::reduction op, class Grid, bool columns>
+inline auto reduce_lines(const Lines<Grid, columns>& lines) {
+    using value_type = std::remove_const_t<typename Grid::value_type>;
+    const Grid& grid = lines.grid();
+    std::vector<value_type> results(lines.size());
+    if constexpr( !columns ) {
+        for( std::size_t r = 0; r < grid.height(); ++r ) results[r] = reduce_view<op>(grid.row(r));
+    } else if constexpr( std::is_pointer_v<std::decay_t<decltype(grid.base())>> ) {
+        simd::reduce_columns<op>(static_cast<const value_type*>(grid.base()), grid.stride(), grid.height(), grid.width(), results.data());
+    } else if( grid.height() > 0 ) {
+        // row by row all the same, each element is read once, in the order of the container
+        for( std::size_t c = 0; c < grid.width(); ++c ) results[c] = grid(0, c);
+        for( std::size_t r = 1; r < grid.height(); ++r ) {
+            for( std::size_t c = 0; c < grid.width(); ++c ) results[c] = simd::combine<op>(results[c], static_cast<value_type>(grid(r, c)));
+        }
     }
+    return results;
+}
 
-    constexpr iterator begin() { return iterator(std::next(data.begin(), column_number)); }
 
-    constexpr iterator end() { return iterator(std::next(data.begin(), column_number + rows*cols)); }
+template<class View, std::enable_if_t<is_line_view_v<View>, int> = 0>
+inline auto sum(const View& view) {
+    return reduce_view<simd::reduction::sum>(view);
+}
 
-    constexpr const_iterator cbegin() const { return const_iterator(std::next(data.cbegin(), column_number)); }
 
-    constexpr const_iterator cend() const { return const_iterator(std::next(data.cbegin(), column_number + rows*cols)); }
+template<class View, std::enable_if_t<is_line_view_v<View>, int> = 0>
+inline auto min(const View& view) {
+    return reduce_view<simd::reduction::min>(view);
+}
 
-};
 
+template<class View, std::enable_if_t<is_line_view_v<View>, int> = 0>
+inline auto max(const View& view) {
+    return reduce_view<simd::reduction::max>(view);
+}
 
-template<std::size_t row_number, std::size_t rows, std::size_t cols, class SequenceContainer>
-class RowDimension {
 
-    protected:
+template<class Grid, bool columns>
+inline auto sum(const Lines<Grid, columns>& lines) {
+    return reduce_lines<simd::reduction::sum>(lines);
+}
 
-        const SequenceContainer& data;
 
-    public:
+template<class Grid, bool columns>
+inline auto min(const Lines<Grid, columns>& lines) {
+    return reduce_lines<simd::reduction::min>(lines);
+}
 
-        template<typename iterator>
-            class RowIterator {
 
-                public:
+template<class Grid, bool columns>
+inline auto max(const Lines<Grid, columns>& lines) {
+    return reduce_lines<simd::reduction::max>(lines);
+}
 
-                    using difference_type = typename std::iterator_traits<iterator>::difference_type;
-                    using value_type = typename std::iterator_traits<iterator>::value_type;
-                    using pointer = typename std::iterator_traits<iterator>::pointer;
-                    using reference = typename std::iterator_traits<iterator>::reference;
-                    using const_reference = typename std::iterator_traits<iterator>::reference;
-                    using iterator_category = typename std::iterator_traits<iterator>::iterator_category;
 
-                protected:
+// the sum of the products of the elements of two views of the same size
+template<class ViewA, class ViewB, std::enable_if_t<is_line_view_v<ViewA> && is_line_view_v<ViewB>, int> = 0>
+inline auto dot(const ViewA& a, const ViewB& b) {
+    using value_type = std::remove_const_t<typename ViewA::value_type>;
+    const std::size_t size = a.size();
+    if( size == 0 ) return value_type();
+    if constexpr( is_contiguous_view<ViewA>::value && is_contiguous_view<ViewB>::value
+               && std::is_same_v<value_type, std::remove_const_t<typename ViewB::value_type>> ) {
+        return simd::dot(static_cast<const value_type*>(std::addressof(a[0])), static_cast<const value_type*>(std::addressof(b[0])), size);
+    } else {
+        value_type result = value_type();
+        for( std::size_t i = 0; i < size; ++i ) result += a[i] * b[i];
+        return result;
+    }
+}
 
-                    iterator _iter;
+#endif
+#ifndef __VIPER_TENSOR__
+#define __VIPER_TENSOR__
 
-                public:
 
-                    RowIterator(const iterator& iter): _iter(iter) {}
 
-                    inline typename std::conditional<std::is_const<iterator>::value, const_reference, reference>::type operator*() const {
-                        return *_iter;
-                    }
 
-                    inline auto operator!=(const RowIterator<iterator>& rhs) const {
-                        return _iter != rhs._iter;
-                    }
+/*
+ * A flat sequence container seen as an N-dimensional array, like grid() sees it as a 2-D one:
+ *
+ * std::vector<float> samples(time * sensors * channels);
+ * auto t = tensor(samples, time, sensors, channels);    // extents known at runtime
+ * auto s = tensor<512, 64, 3>(samples);                  // or at compile time
+ *
+ * t(i, j, k) = 0.f;
+ * auto at_time = t[i];                  // the sensors x channels matrix at time i
+ * auto of_sensor = t.slice<1>(j);       // the time x channels matrix of sensor j
+ * auto signal = of_sensor.slice<1>(k);  // slices of slices: the time series of channel k of sensor j
+ *
+ * Each axis has an extent (its number of elements) and a stride (how many elements apart consecutive ones are),
+ * row-major by default: the last axis is contiguous. Slicing fixes the index along an axis and drops it,
+ * the slice keeps the strides of the remaining axes: nothing is copied, it aliases the container.
+ *
+ * Iterating over a tensor (range-for, or for_each) visits every element once, looping innermost over the axis
+ * whose elements are closest in memory, the contiguous one of a row-major tensor or of any of its slices,
+ * so it walks memory in order rather than jumping a stride at each element.
+ */
 
-                    inline auto operator++() {
-                        _iter++;
-                        return *this;
-                    }
 
-            };
+// extents and strides given as template arguments, see StaticShape
+template<std::size_t... extents>
+struct Extents {};
 
-        using container_t = std::remove_reference_t<SequenceContainer>;
-        using value_type = typename container_t::value_type;
-        using size_type = typename container_t::size_type;
-        using difference_type = typename container_t::difference_type;
-        using reference = typename container_t::reference;
-        using const_reference = typename container_t::const_reference;
-        using pointer = typename container_t::pointer;
-        using const_pointer = typename container_t::const_pointer;
-        using iterator = RowIterator<typename container_t::iterator>;
-        using const_iterator = RowIterator<typename container_t::const_iterator>;
+template<std::ptrdiff_t... strides>
+struct Strides {};
 
-        constexpr RowDimension(const SequenceContainer& container)
-            :data(container) {}
 
-        //
-        // READ OPS
-        //
+// strides of a row-major array of the given extents: the last axis is contiguous
+template<std::size_t rank>
+constexpr std::array<std::ptrdiff_t, rank> row_major_strides(const std::array<std::size_t, rank>& extents) {
+    std::array<std::ptrdiff_t, rank> strides{};
+    std::ptrdiff_t stride = 1;
+    for( std::size_t axis = rank; axis-- > 0; ) {
+        strides[axis] = stride;
+        stride *= static_cast<std::ptrdiff_t>(extents[axis]);
+    }
+    return strides;
+}
 
-        constexpr size_type size() const noexcept {
-            return cols;
-        }
 
-        constexpr const_reference operator[]( size_type pos ) const {
-            return data[ row_number*cols + pos ];
-        }
+// extents and strides known at runtime
+template<std::size_t rank_>
+class DynamicShape {
 
-        constexpr const_iterator cbegin() const { return const_iterator(std::next(data.cbegin(), row_number*cols)); }
+    static_assert(rank_ > 0, "a shape has at least one axis");
 
-        constexpr const_iterator cend() const { return const_iterator(std::next(data.cbegin(), row_number*cols + cols)); }
+    std::array<std::size_t, rank_> _extents;
+    std::array<std::ptrdiff_t, rank_> _strides;
 
-        //
-        // WRITE OPS
-        //
+    public:
 
-        constexpr reference operator[]( size_type pos ) {
-            return data[ row_number*cols + pos ];
-        }
+        static constexpr std::size_t rank = rank_;
 
-        constexpr iterator begin() { return iterator(std::next(data.begin(), row_number*cols)); }
+        explicit DynamicShape(const std::array<std::size_t, rank>& extents)
+            : DynamicShape(extents, row_major_strides(extents)) {}
 
-        constexpr iterator end() { return iterator(std::next(data.begin(), row_number*cols + cols)); }
-};
+        DynamicShape(const std::array<std::size_t, rank>& extents, const std::array<std::ptrdiff_t, rank>& strides)
+            : _extents(extents), _strides(strides) {}
 
+        inline std::size_t extent(std::size_t axis) const noexcept { return _extents[axis]; }
 
-template<std::size_t column_number, std::size_t rows, std::size_t cols, class SequenceContainer>
-inline auto col(SequenceContainer&& container) {
-    return ColumnDimension<
-        column_number,
-        rows,
-        cols,
-        SequenceContainer
-            > (std::forward<SequenceContainer>(container));
-}
+        inline std::ptrdiff_t stride(std::size_t axis) const noexcept { return _strides[axis]; }
 
+        // the same shape without 'axis'
+        inline DynamicShape<rank - 1> without(std::size_t axis) const {
+            std::array<std::size_t, rank - 1> extents;
+            std::array<std::ptrdiff_t, rank - 1> strides;
+            for( std::size_t from = 0, to = 0; from < rank; ++from ) {
+                if( from == axis ) continue;
+                extents[to] = _extents[from];
+                strides[to++] = _strides[from];
+            }
+            return DynamicShape<rank - 1>(extents, strides);
+        }
 
-template<std::size_t row_number, std::size_t rows, std::size_t cols, class SequenceContainer>
-inline auto row(SequenceContainer&& container) {
-    return RowDimension<
-        row_number,
-        rows,
-        cols,
-        SequenceContainer
-            > (std::forward<SequenceContainer>(container));
-}
+        template<std::size_t axis>
+        inline DynamicShape<rank - 1> without() const { return without(axis); }
+};
 
 
-#endif
+/*
+ * Extents and strides known at compile time: the shape takes no room,
+ * and offsets are computed with constants the compiler can fold.
+ */
+template<class Extents, class Strides>
+class StaticShape;
 
+template<std::size_t axis, class Shape, class = std::make_index_sequence<Shape::rank - 1>>
+struct static_shape_without;
 
-template<class Iterator>
+template<std::size_t... extents, std::ptrdiff_t... strides>
+class StaticShape<Extents<extents...>, Strides<strides...>> {
 
-class FilterIterator : public Iterator {
-    public:
+    static_assert(sizeof...(extents) > 0, "a shape has at least one axis");
+    static_assert(sizeof...(extents) == sizeof...(strides), "a shape has as many strides as extents");
 
-    using predicate_t = std::function< bool (typename Iterator::reference) >;
+    public:
 
-    private:
-    
-    predicate_t _filter;
-    Iterator _end;
+        static constexpr std::size_t rank = sizeof...(extents);
+        static constexpr std::array<std::size_t, rank> extents_v{extents...};
+        static constexpr std::array<std::ptrdiff_t, rank> strides_v{strides...};
 
-    inline void move_to_next_valid_value() {
-        while( (*this!=_end) && !_filter(**this)) Iterator::operator++();
-    }
+        constexpr std::size_t extent(std::size_t axis) const noexcept { return extents_v[axis]; }
 
+        constexpr std::ptrdiff_t stride(std::size_t axis) const noexcept { return strides_v[axis]; }
 
-    public:
+        template<std::size_t axis>
+        constexpr auto without() const { return typename static_shape_without<axis, StaticShape>::type(); }
+};
 
-    FilterIterator(const FilterIterator& iter):FilterIterator(iter, iter._end, iter._filter) {}
+template<std::size_t axis, class Shape, std::size_t... i>
+struct static_shape_without<axis, Shape, std::index_sequence<i...>> {
+    using type = StaticShape<
+        Extents<Shape::extents_v[i < axis ? i : i + 1]...>,
+        Strides<Shape::strides_v[i < axis ? i : i + 1]...>
+            >;
+};
 
-    FilterIterator(const Iterator& begin, const Iterator& end, const predicate_t& filter)
-        : Iterator(begin),_filter(filter),_end(end) {
-            move_to_next_valid_value();
-        }
 
-    FilterIterator(Iterator&& begin, Iterator&& end, predicate_t&& filter)
-        : Iterator(std::move(begin)), _filter(std::move(filter)), _end(std::move(end)) {
-            move_to_next_valid_value();
-        }
+template<class Extents>
+struct row_major_shape;
 
-    FilterIterator& operator=(const FilterIterator& other) {
-        if( this != &other ) {
-            _filter = other._filter;
-            _end = other._end;
-        }
-        return *this;
-    }
+template<std::size_t... extents>
+struct row_major_shape<Extents<extents...>> {
 
-    FilterIterator& operator=(FilterIterator&& other) {
-        if( this != &other ) {
-            _filter = std::move(other._filter);
-            _end = std::move(other._end);
-        }
-        return *this;
-    }
+    template<class Sequence>
+    struct with;
 
-    inline FilterIterator& operator++() {
-        do {
-            Iterator::operator++();
-        } while( (*this!=_end) && !_filter(**this) );
-        return *this;
-    }
+    template<std::size_t... i>
+    struct with<std::index_sequence<i...>> {
+        static constexpr auto strides = row_major_strides<sizeof...(extents)>({extents...});
+        using type = StaticShape<Extents<extents...>, Strides<strides[i]...>>;
+    };
 
-    inline auto operator++(int) {
-        auto iterator{*this};
-        operator++();
-        return iterator;
-    }
+    using type = typename with<std::make_index_sequence<sizeof...(extents)>>::type;
 };
 
 
-template<class T>
+/*
+ * Walks every element of a tensor, in the order given by 'extents' and 'strides': the axes of the tensor
+ * from the farthest apart in memory to the closest, see Tensor::begin. The last axis moves fastest,
+ * carrying over to the previous ones like the digits of an odometer.
+ */
+template<class Iterator, std::size_t rank>
+class TensorIterator {
 
-class FilterIterator<T*> {
+    using traits_t = std::iterator_traits<Iterator>;
 
     public:
 
-    using predicate_t = typename std::function< bool (const T&) >;
+        using difference_type = typename traits_t::difference_type;
+        using value_type = typename traits_t::value_type;
+        using pointer = typename traits_t::pointer;
+        using reference = typename traits_t::reference;
+        using iterator_category = std::forward_iterator_tag;
 
     private:
 
-    const T *_iter, *_end;
-    const predicate_t& _filter;
-
-    inline void move_to_next_valid_value() {
-        while( (*this!=_end) && !_filter(**this)) ++_iter;
-    }
+        Iterator _first;
+        std::array<std::size_t, rank> _extents, _index;
+        std::array<difference_type, rank> _strides;
+        difference_type _offset, _pos;
 
     public:
 
-        using difference_type = typename std::iterator_traits<T*>::difference_type;
-        using value_type = typename std::iterator_traits<T*>::value_type;
-        using pointer = typename std::iterator_traits<T*>::pointer;
-        using reference = typename std::iterator_traits<T*>::reference;
-        using iterator_category = typename std::iterator_traits<T*>::iterator_category;
-
-        FilterIterator(const T* begin, const T* end, const predicate_t& filter)
-            : _iter(begin), _end(end), _filter(filter) {
-                move_to_next_valid_value();
-            }
-
-        inline bool operator==(const T* rhs) const {
-            return _iter == rhs;
-        }
-
-        inline bool operator==(const FilterIterator<T*>& rhs) const {
-            return _iter == rhs._iter;
-        }
-
-        inline bool operator!=(const T* rhs) const {
-            return _iter != rhs;
-        }
-
-        inline bool operator!=(const FilterIterator<T*>& rhs) const {
-            return _iter != rhs._iter;
-        }
+        TensorIterator(Iterator first, const std::array<std::size_t, rank>& extents, const std::array<difference_type, rank>& strides, difference_type pos)
+            : _first(std::move(first)), _extents(extents), _index{}, _strides(strides), _offset(0), _pos(pos) {}
 
-        inline difference_type operator-(const T* rhs) const {
-            return _iter - rhs;
+        inline reference operator*() const {
+            return _first[_offset];
         }
 
-        inline difference_type operator-(const FilterIterator<T*>& rhs) const {
-            return _iter - rhs._iter;
+        inline bool operator==(const TensorIterator& rhs) const {
+            return _pos == rhs._pos;
         }
 
-        inline const T& operator*() const {
-            return *_iter;
+        inline bool operator!=(const TensorIterator& rhs) const {
+            return _pos != rhs._pos;
         }
 
-        inline FilterIterator& operator++() {
-            do {
-                ++_iter;
-            } while( (*this!=_end) && !_filter(**this) );
+        inline TensorIterator& operator++() {
+            ++_pos;
+            for( std::size_t axis = rank; axis-- > 0; ) {
+                _offset += _strides[axis];
+                if( ++_index[axis] < _extents[axis] ) return *this;
+                _offset -= _strides[axis] * static_cast<difference_type>(_extents[axis]);
+                _index[axis] = 0;
+            }
             return *this;
         }
 
@@ -509,176 +4365,298 @@ class FilterIterator<T*> {
 };
 
 
+template<class Iterator, class Shape>
+class Tensor {
 
+    Iterator _first;
+    Shape _shape;
 
-template<class Iterator, class UnaryFunction>
+    public:
 
-class Iter : public Iterator {
-    
-    UnaryFunction& _convert;
+        static constexpr std::size_t rank = Shape::rank;
 
-    public:
+        using value_type = typename std::iterator_traits<Iterator>::value_type;
+        using size_type = std::size_t;
+        using difference_type = typename std::iterator_traits<Iterator>::difference_type;
+        using reference = typename std::iterator_traits<Iterator>::reference;
+        using shape_type = Shape;
+        using iterator = TensorIterator<Iterator, rank>;
+        using const_iterator = iterator;
 
-    //TODO provide valid value_type and reference!
-        //using value_type = typename std::iterator_traits<T*>::value_type;
-        //using reference = typename std::iterator_traits<T*>::reference;
+        Tensor(Iterator first, Shape shape = Shape()) : _first(std::move(first)), _shape(std::move(shape)) {}
 
-        Iter(const Iterator& iter, const UnaryFunction& convert)
-            : Iterator(iter),_convert(convert) {}
+        // the element at index 0 along every axis
+        inline const Iterator& base() const noexcept { return _first; }
 
-        Iter(Iterator&& iter, UnaryFunction&& convert)
-            : Iterator(std::move(iter)), _convert(std::move(convert)) {}
+        inline const Shape& shape() const noexcept { return _shape; }
 
-        inline auto operator*() {
-            return _convert(Iterator::operator*());
-        }
-};
+        inline size_type extent(size_type axis) const noexcept { return _shape.extent(axis); }
 
+        inline difference_type stride(size_type axis) const noexcept { return _shape.stride(axis); }
 
-template<class T, class UnaryFunction>
+        inline size_type size() const noexcept {
+            size_type size = 1;
+            for( size_type axis = 0; axis < rank; ++axis ) size *= extent(axis);
+            return size;
+        }
 
-class Iter<T*, UnaryFunction> {
-    T* _iter;
-    UnaryFunction& _convert;
+        template<class... Indices>
+        inline reference operator()(Indices... indices) const {
+            static_assert(sizeof...(Indices) == rank, "a tensor takes one index per axis");
+            difference_type offset = 0;
+            size_type axis = 0;
+            ((offset += static_cast<difference_type>(indices) * stride(axis++)), ...);
+            return _first[offset];
+        }
 
-    public:
+        // the slice at 'index' along 'axis', one rank lower
+        template<size_type axis>
+        inline auto slice(size_type index) const {
+            static_assert(rank > 1, "slicing a tensor of rank 1 gives an element, use operator[]");
+            static_assert(axis < rank, "slicing along an axis the tensor doesn't have");
+            auto shape = _shape.template without<axis>();
+            return Tensor<Iterator, decltype(shape)>(_first + static_cast<difference_type>(index) * stride(axis), shape);
+        }
 
-        using difference_type = typename std::iterator_traits<T*>::difference_type;
-        using value_type = typename std::iterator_traits<T*>::value_type;
-        using pointer = typename std::iterator_traits<T*>::pointer;
-        using reference = typename std::iterator_traits<T*>::reference;
-        using iterator_category = typename std::iterator_traits<T*>::iterator_category;
+        // same, 'axis' known at runtime, only for shapes known at runtime
+        inline auto slice(size_type axis, size_type index) const {
+            static_assert(rank > 1, "slicing a tensor of rank 1 gives an element, use operator[]");
+            static_assert(std::is_same_v<Shape, DynamicShape<rank>>, "the axis of a slice of a StaticShape must be known at compile time, use slice<axis>(index)");
+            return Tensor<Iterator, DynamicShape<rank - 1>>(_first + static_cast<difference_type>(index) * stride(axis), _shape.without(axis));
+        }
 
-        Iter(T* iter, const UnaryFunction& convert)
-            : _iter(iter),_convert(convert) {}
+        // the slice at 'index' along the first axis, or the element at 'index' for a tensor of rank 1
+        inline decltype(auto) operator[](size_type index) const {
+            if constexpr( rank == 1 ) return _first[static_cast<difference_type>(index) * stride(0)];
+            else return slice<0>(index);
+        }
 
-        //Iter(T* iter, UnaryFunction&& convert)
-            //: _iter(iter),_convert(std::move(convert)) {}
+        // a tensor of rank 2 whose second axis is contiguous, as a Grid
+        inline Grid<Iterator> as_grid() const {
+            static_assert(rank == 2, "only a tensor of rank 2 is a grid");
+            return Grid<Iterator>(_first, extent(0), extent(1), static_cast<size_type>(stride(0)));
+        }
 
-        inline bool operator!=(const Iter<T*, UnaryFunction>& rhs) const {
-            return _iter != rhs._iter;
+        // the axes from the farthest apart in memory to the closest, the order in which they are walked
+        inline std::array<size_type, rank> loop_order() const {
+            std::array<size_type, rank> order;
+            for( size_type axis = 0; axis < rank; ++axis ) order[axis] = axis;
+            std::stable_sort(order.begin(), order.end(), [this](size_type a, size_type b) {
+                return std::abs(stride(a)) > std::abs(stride(b));
+            });
+            return order;
         }
 
-        inline auto operator++() {
-            ++_iter;
-            return *this;
+        inline iterator begin() const {
+            const auto order = loop_order();
+            std::array<size_type, rank> extents;
+            std::array<difference_type, rank> strides;
+            for( size_type axis = 0; axis < rank; ++axis ) {
+                extents[axis] = extent(order[axis]);
+                strides[axis] = stride(order[axis]);
+            }
+            return iterator(_first, extents, strides, 0);
         }
 
-        inline auto operator*() {
-            return _convert(*_iter);
+        inline iterator end() const {
+            return iterator(_first, {}, {}, static_cast<difference_type>(size()));
         }
+
+        inline const_iterator cbegin() const { return begin(); }
+
+        inline const_iterator cend() const { return end(); }
 };
 
 
-template<class T, class UnaryFunction>
+template<std::size_t depth, std::size_t rank, class Iterator, class Function>
+inline void for_each_axis(const Iterator& first, const std::array<std::size_t, rank>& extents,
+                          const std::array<std::ptrdiff_t, rank>& strides, Function& fn) {
+    using difference_type = typename std::iterator_traits<Iterator>::difference_type;
+    const auto stride = static_cast<difference_type>(strides[depth]);
+    if constexpr( depth + 1 == rank ) {
+        for( std::size_t i = 0; i < extents[depth]; ++i ) fn(first[static_cast<difference_type>(i) * stride]);
+    } else {
+        for( std::size_t i = 0; i < extents[depth]; ++i ) for_each_axis<depth + 1>(first + static_cast<difference_type>(i) * stride, extents, strides, fn);
+    }
+}
 
-class Iter<const T*, UnaryFunction> {
-    const T* _iter;
-    UnaryFunction& _convert;
 
-    public:
+/*
+ * Calls fn on every element of 'tensor', in the order of its iterators, with a plain loop for each axis:
+ * the innermost one runs over contiguous elements of a row-major tensor, and compiles like a loop over an array.
+ */
+template<class Iterator, class Shape, class Function>
+inline void for_each(const Tensor<Iterator, Shape>& tensor, Function fn) {
+    constexpr std::size_t rank = Shape::rank;
+    const auto order = tensor.loop_order();
+    std::array<std::size_t, rank> extents;
+    std::array<std::ptrdiff_t, rank> strides;
+    for( std::size_t axis = 0; axis < rank; ++axis ) {
+        extents[axis] = tensor.extent(order[axis]);
+        strides[axis] = tensor.stride(order[axis]);
+    }
+    for_each_axis<0>(tensor.base(), extents, strides, fn);
+}
 
-        using difference_type = typename std::iterator_traits<const T*>::difference_type;
-        using value_type = typename std::iterator_traits<const T*>::value_type;
-        using pointer = typename std::iterator_traits<const T*>::pointer;
-        using reference = typename std::iterator_traits<const T*>::reference;
-        using iterator_category = typename std::iterator_traits<const T*>::iterator_category;
 
-        Iter(const T* iter, const UnaryFunction& convert)
-            : _iter(iter),_convert(convert) {}
+// a row-major tensor of 'container', its extents known at runtime
+template<class SequenceContainer, class... Integers, class = std::enable_if_t<(std::is_integral_v<Integers> && ...)>>
+inline auto tensor(SequenceContainer&& container, Integers... extents) {
+    static_assert(std::is_lvalue_reference_v<SequenceContainer>, "tensor() views a container without owning it, a temporary would be destroyed under the view");
+    using shape_t = DynamicShape<sizeof...(Integers)>;
+    return Tensor<decltype(first_element(container)), shape_t>(first_element(container), shape_t({static_cast<std::size_t>(extents)...}));
+}
 
-        //Iter(T* iter, UnaryFunction&& convert)
-            //: _iter(iter),_convert(std::move(convert)) {}
 
-        inline bool operator!=(const Iter<const T*, UnaryFunction>& rhs) const {
-            return _iter != rhs._iter;
-        }
+// a row-major tensor of 'container', its extents known at compile time
+template<std::size_t... extents, class SequenceContainer>
+inline auto tensor(SequenceContainer&& container) {
+    static_assert(std::is_lvalue_reference_v<SequenceContainer>, "tensor() views a container without owning it, a temporary would be destroyed under the view");
+    using shape_t = typename row_major_shape<Extents<extents...>>::type;
+    return Tensor<decltype(first_element(container)), shape_t>(first_element(container));
+}
 
-        inline difference_type operator-(const Iter<const T*, UnaryFunction>& rhs) const {
-            return _iter - rhs._iter;
-        }
+#endif
+#ifndef __VIPER_TRANSPOSE__
+#define __VIPER_TRANSPOSE__
 
-        inline auto operator++() {
-            ++_iter;
-            return *this;
-        }
 
-        inline auto operator*() {
-            return _convert(*_iter);
-        }
-};
 
 
-template<class Iterator, class UnaryFunction>
-inline auto iterator_cast(Iterator&& iter, UnaryFunction&& convert) {
-    return Iter<Iterator, UnaryFunction>(std::forward<Iterator>(iter), std::forward<UnaryFunction>(convert));
-};
+/*
+ * transpose(in, out) writes the transpose of the grid 'in' into the grid 'out': out(c, r) = in(r, c).
+ * 'out' has to be in.width() rows of in.height() elements, and must not overlap 'in'.
+ * transpose(square) transposes a square grid in place.
+ *
+ * For example, to get contiguous columns before heavy work on each of them:
+ * std::vector<float> samples(rows*cols), by_column(cols*rows);
+ * transpose(grid(samples, rows, cols), grid(by_column, cols, rows));
+ * for( auto column : grid(by_column, cols, rows).rows() ) { ... }
+ *
+ * The grids are cut in two along their larger dimension, again and again, until a block and its transpose
+ * fit in the L1 cache together. Whatever the sizes of the caches, there is a level of the recursion whose blocks
+ * fit each of them (the algorithm is cache-oblivious), and a column of the input is never walked further than a block.
+ * Between contiguous grids of 32-bit or 64-bit arithmetic values, blocks are transposed 8x8 or 4x4 tiles at a time
+ * in SIMD registers, see simd::transpose.
+ */
 
 
-template<class T, class UnaryFunction>
-inline auto iterator_cast(T* iter, UnaryFunction&& convert) {
-   return Iter<decltype(iter), decltype(convert)>(iter, std::forward<UnaryFunction>(convert));
-}
+// blocks of at most this many rows and columns are transposed without cutting them further
+constexpr std::size_t transpose_leaf_size = 32;
 
 
-template<class T, class UnaryFunction>
-inline auto iterator_cast(const T* iter, UnaryFunction&& convert) {
-   return Iter<decltype(iter), decltype(convert)>(iter, std::forward<UnaryFunction>(convert));
+// where a dimension of 'size' elements is cut in two, on a multiple of the widest SIMD tile so only the edges are left over
+inline std::size_t transpose_split(std::size_t size) noexcept {
+    return size / 16 * 8;
 }
 
 
-template<class T, class Container>
-T into(const Container& c) {
-    return T(c.begin(), c.end());
+// grids whose leaf blocks go to the SIMD kernels: plain pointers, to the same arithmetic type
+template<class InIterator, class OutIterator>
+constexpr bool is_simd_transposable_v = std::is_pointer_v<InIterator>
+                                     && std::is_pointer_v<OutIterator>
+                                     && std::is_same_v<std::remove_const_t<std::remove_pointer_t<InIterator>>, std::remove_pointer_t<OutIterator>>
+                                     && simd::is_vectorizable_v<std::remove_pointer_t<OutIterator>>;
+
+
+template<class InIterator, class OutIterator>
+inline void transpose_recursive(const Grid<InIterator>& in, const Grid<OutIterator>& out) {
+    const std::size_t height = in.height(), width = in.width();
+    if( height <= transpose_leaf_size && width <= transpose_leaf_size ) {
+        if constexpr( is_simd_transposable_v<InIterator, OutIterator> ) {
+            simd::transpose(in.base(), in.stride(), out.base(), out.stride(), height, width);
+        } else {
+            for( std::size_t r = 0; r < height; ++r ) {
+                for( std::size_t c = 0; c < width; ++c ) out(c, r) = in(r, c);
+            }
+        }
+    } else if( height >= width ) {
+        const std::size_t top = transpose_split(height);
+        transpose_recursive(in.block(0, 0, top, width), out.block(0, 0, width, top));
+        transpose_recursive(in.block(top, 0, height - top, width), out.block(0, top, width, height - top));
+    } else {
+        const std::size_t left = transpose_split(width);
+        transpose_recursive(in.block(0, 0, height, left), out.block(0, 0, left, height));
+        transpose_recursive(in.block(0, left, height, width - left), out.block(left, 0, width - left, height));
+    }
 }
 
 
-template<class T, class UnaryFunction, class Container>
-T into(const UnaryFunction& fn, Container&& c) {
-    return T(iterator_cast(c.cbegin(), fn), iterator_cast(c.cend(), fn));
+// exchanges the block 'a' with the transpose of 'b', its mirror across the diagonal of the same square grid
+template<class Iterator>
+inline void transpose_swap_recursive(const Grid<Iterator>& a, const Grid<Iterator>& b) {
+    const std::size_t height = a.height(), width = a.width();
+    if( height <= transpose_leaf_size && width <= transpose_leaf_size ) {
+        if constexpr( is_simd_transposable_v<Iterator, Iterator> ) {
+            simd::transpose_swap(a.base(), b.base(), a.stride(), height, width);
+        } else {
+            using std::swap;
+            for( std::size_t r = 0; r < height; ++r ) {
+                for( std::size_t c = 0; c < width; ++c ) swap(a(r, c), b(c, r));
+            }
+        }
+    } else if( height >= width ) {
+        const std::size_t top = transpose_split(height);
+        transpose_swap_recursive(a.block(0, 0, top, width), b.block(0, 0, width, top));
+        transpose_swap_recursive(a.block(top, 0, height - top, width), b.block(0, top, width, height - top));
+    } else {
+        const std::size_t left = transpose_split(width);
+        transpose_swap_recursive(a.block(0, 0, height, left), b.block(0, 0, left, height));
+        transpose_swap_recursive(a.block(0, left, height, width - left), b.block(left, 0, width - left, height));
+    }
 }
 
 
+template<class Iterator>
+inline void transpose_inplace_recursive(const Grid<Iterator>& square) {
+    const std::size_t size = square.height();
+    if( size <= transpose_leaf_size ) {
+        if constexpr( is_simd_transposable_v<Iterator, Iterator> ) {
+            simd::transpose_inplace(square.base(), square.stride(), size);
+        } else {
+            using std::swap;
+            for( std::size_t r = 0; r < size; ++r ) {
+                for( std::size_t c = r + 1; c < size; ++c ) swap(square(r, c), square(c, r));
+            }
+        }
+    } else {
+        // the two blocks on the diagonal in place, the two off it with each other
+        const std::size_t half = transpose_split(size);
+        transpose_inplace_recursive(square.block(0, 0, half, half));
+        transpose_inplace_recursive(square.block(half, half, size - half, size - half));
+        transpose_swap_recursive(square.block(0, half, half, size - half), square.block(half, 0, size - half, half));
+    }
+}
 
 
-template<class ContainerOut, class ContainerIn>
-ContainerOut filter(const typename FilterIterator<typename ContainerIn::const_iterator>::predicate_t& fn, const ContainerIn& in) {
-    using filter_type_t = FilterIterator<typename ContainerIn::const_iterator>;
-    ContainerOut out{
-        filter_type_t(
-                in.cbegin(),
-                in.cend(),
-                fn
-                ),
-        filter_type_t(
-                in.cend(),
-                in.cend(),
-                fn
-                ),
-    };
-    return out;
+template<class InIterator, class OutIterator>
+inline void transpose(const Grid<InIterator>& in, const Grid<OutIterator>& out) {
+    transpose_recursive(in, out);
 }
 
 
-template<class ContainerIn>
-ContainerIn filter(const typename FilterIterator<typename ContainerIn::const_iterator>::predicate_t& fn, const ContainerIn& in) {
-    using filter_type_t = FilterIterator<typename ContainerIn::const_iterator>;
-    ContainerIn out{
-        filter_type_t(
-                in.cbegin(),
-                in.cend(),
-                fn
-                ),
-        filter_type_t(
-                in.cend(),
-                in.cend(),
-                fn
-                ),
-    };
-    return out;
+// 'square' has as many rows as columns
+template<class Iterator>
+inline void transpose(const Grid<Iterator>& square) {
+    transpose_inplace_recursive(square);
 }
 
 
+/*
+ * Same, with the dimensions known at compile time like the ones of row<>() and col<>():
+ * 'in' is 'rows' x 'cols', 'out' is 'cols' x 'rows'.
+ *
+ * For example:
+ * std::array<int, 6> in { 0, 1, 2,
+ *                         3, 4, 5 }, out;
+ * transpose<2, 3>(in, out);   // out == { 0, 3, 1, 4, 2, 5 }
+ */
+template<std::size_t rows, std::size_t cols, class InContainer, class OutContainer>
+inline void transpose(const InContainer& in, OutContainer& out) {
+    transpose(grid(in, rows, cols), grid(out, cols, rows));
+}
+
+#endif
 
 
 } // closing namespace viper
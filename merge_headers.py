@@ -14,16 +14,28 @@ find_local_include = re_compile(r"#include \"(.*)\"")
 '''
 find_global_include = re_compile(r"#include <(.*)>")
 
+'''
+#ifndef __VIPER_GRID__ => include guard, not a condition on the includes it encloses
+'''
+find_include_guard = re_compile(r"#ifndef __VIPER_\w+__")
+
 
 @contextmanager
 def master_header(version_path, filename):
     local_headers = dict()
     global_headers = set()
+    conditional_headers = dict()
     headers_path = version_path/'headers'
-    yield (headers_path, local_headers, global_headers)
+    yield (headers_path, local_headers, global_headers, conditional_headers)
     with open(version_path/filename, 'w') as header_file:
-        for header in global_headers:
+        for header in sorted(global_headers):
+            header_file.write(f"#include <{header}>\n")
+        for (conditions, header) in conditional_headers:
+            # re-open every enclosing #if/#elif/#else chain so the include keeps its platform condition
+            for chain in conditions:
+                header_file.write("\n".join(chain) + "\n")
             header_file.write(f"#include <{header}>\n")
+            header_file.write("#endif\n" * len(conditions))
         header_file.write("\n\nnamespace viper {\n\n")
         for declaration in local_headers.values():
             header_file.write(declaration)
@@ -31,12 +43,21 @@ def master_header(version_path, filename):
 
 
 def include(master_header, local_header):
-    headers_path, local_headers, global_headers = master_header
+    headers_path, local_headers, global_headers, conditional_headers = master_header
     if local_header not in local_headers:
         local_dependencies = []
+        # one entry per enclosing #if, holding the lines of its #if/#elif/#else chain so far (None for include guards)
+        conditions = []
         with open(local_header) as local_header_file:
             all_code_minus_includes = ""
             for line in local_header_file:
+                directive = line.strip()
+                if directive.startswith("#if"):
+                    conditions.append(None if find_include_guard.match(directive) else [directive])
+                elif directive.startswith("#el") and conditions and conditions[-1] is not None:
+                    conditions[-1].append(directive)
+                elif directive.startswith("#endif") and conditions:
+                    conditions.pop()
                 if line.startswith("#include"):
                     match = find_local_include.match(line)
                     if match:
@@ -49,7 +70,10 @@ def include(master_header, local_header):
                         match = find_global_include.match(line)
                         if match:
                             header = match.group(1)
-                            if header not in global_headers:
+                            enclosing = tuple(tuple(chain) for chain in conditions if chain is not None)
+                            if enclosing:
+                                conditional_headers.setdefault((enclosing, header), None)
+                            elif header not in global_headers:
                                 global_headers.add(header)
                 else:
                     all_code_minus_includes += line
@@ -61,7 +85,7 @@ def viper_h(version_dir):
     version_path = Path(version_dir)
     headers_path = version_path/'headers'
     with master_header(version_path, "viper.h") as viper_h:
-        for header in headers_path.glob('*.h'):
+        for header in sorted(headers_path.glob('*.h')):
             include(viper_h, header)
 
 